@@ -28,6 +28,8 @@
 #include "KisDocument.h"
 #include "kis_image.h"
 #include "kis_image_config.h"
+#include "KisFrameDataSerializer.h"
+#include "opengl/kis_texture_tile_info_pool.h"
 
 namespace {
 void removeTempFiles(const QString &filesMask)
@@ -109,4 +111,98 @@ void KisAnimationRenderingBenchmark::testCacheRendering()
     }
 }
 
+void KisAnimationRenderingBenchmark::testFrameDeltaEncoding()
+{
+    const int tileSize = 256;
+    const int numTiles = 64; // 2048x2048 frame
+    const int numFrames = 24;
+
+    KisTextureTileInfoPoolRegistry poolRegistry;
+    KisTextureTileInfoPoolSP pool = poolRegistry.getPool(tileSize, tileSize);
+
+    KisFrameDataSerializer::Frame keyframe;
+    keyframe.pixelSize = 4;
+
+    for (int i = 0; i < numTiles; i++) {
+        KisFrameDataSerializer::FrameTile tile(pool);
+        tile.col = i % 8;
+        tile.row = i / 8;
+        tile.rect = QRect(tile.col * tileSize, tile.row * tileSize, tileSize, tileSize);
+        tile.data.allocate(keyframe.pixelSize);
+
+        quint32 *dataPtr = reinterpret_cast<quint32*>(tile.data.data());
+        for (int j = 0; j < tileSize * tileSize; j++) {
+            *dataPtr++ = 0xff000000 | (j * 2654435761U >> 8);
+        }
+
+        keyframe.frameTiles.push_back(std::move(tile));
+    }
+
+    /**
+     * Every frame of the "animation" changes a small patch of the keyframe,
+     * which is what usually happens in a hand-drawn shot
+     */
+    std::vector<KisFrameDataSerializer::Frame> frames;
+
+    for (int i = 0; i < numFrames; i++) {
+        KisFrameDataSerializer::Frame frame = keyframe.clone();
+        KisFrameDataSerializer::FrameTile &tile = frame.frameTiles[(i * 7) % numTiles];
+
+        quint32 *dataPtr = reinterpret_cast<quint32*>(tile.data.data());
+        for (int j = 0; j < tileSize * 32; j++) {
+            *dataPtr++ = 0xff0000ff;
+        }
+
+        frames.push_back(std::move(frame));
+    }
+
+    KisFrameDataSerializer serializer;
+    const int keyframeId = serializer.saveFrame(keyframe);
+
+    auto framesSize = [&serializer] (const std::vector<int> &ids) {
+        qint64 size = 0;
+        for (int id : ids) {
+            size += serializer.frameDataSize(id);
+        }
+        return size;
+    };
+
+    QElapsedTimer timer;
+
+    std::vector<int> denseIds;
+    timer.start();
+    for (const KisFrameDataSerializer::Frame &frame : frames) {
+        KisFrameDataSerializer::Frame diff = frame.clone();
+        KisFrameDataSerializer::subtractFrames(diff, keyframe);
+        denseIds.push_back(serializer.saveFrame(diff));
+    }
+    const qint64 denseSaveTime = timer.restart();
+
+    for (int id : denseIds) {
+        KisFrameDataSerializer::Frame frame = serializer.loadFrame(id, pool);
+        KisFrameDataSerializer::addFrames(frame, keyframe);
+    }
+    const qint64 denseLoadTime = timer.restart();
+
+    std::vector<int> sparseIds;
+    for (const KisFrameDataSerializer::Frame &frame : frames) {
+        KisFrameDataSerializer::Frame diff = frame.clone();
+        KisFrameDataSerializer::subtractFramesSparse(diff, keyframe);
+        sparseIds.push_back(serializer.saveFrame(diff));
+    }
+    const qint64 sparseSaveTime = timer.restart();
+
+    for (int id : sparseIds) {
+        KisFrameDataSerializer::Frame frame = keyframe.clone();
+        KisFrameDataSerializer::addFramesSparse(frame, serializer.loadFrame(id, pool));
+    }
+    const qint64 sparseLoadTime = timer.restart();
+
+    qDebug() << "Keyframe:" << serializer.frameDataSize(keyframeId) << "bytes";
+    qDebug() << "Full-tile differences:" << framesSize(denseIds) << "bytes"
+             << "save:" << denseSaveTime << "ms" << "load:" << denseLoadTime << "ms";
+    qDebug() << "Sparse differences:   " << framesSize(sparseIds) << "bytes"
+             << "save:" << sparseSaveTime << "ms" << "load:" << sparseLoadTime << "ms";
+}
+
 QTEST_MAIN(KisAnimationRenderingBenchmark)
@@ -0,0 +1,90 @@
+/*
+ *  Copyright (c) 2020 Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "KisImageCloneBenchmark.h"
+
+#include <QTest>
+
+#include <KoColorSpaceRegistry.h>
+#include <KoColor.h>
+
+#include "kis_image.h"
+#include "kis_paint_layer.h"
+#include "kis_group_layer.h"
+#include "kis_paint_device.h"
+#include "kis_layer_utils.h"
+
+const int IMAGE_WIDTH = 4096;
+const int IMAGE_HEIGHT = 4096;
+const int NUM_LAYERS = 64;
+
+void KisImageCloneBenchmark::initTestCase()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    m_image = new KisImage(0, IMAGE_WIDTH, IMAGE_HEIGHT, cs, "clone benchmark");
+
+    const QRect rc(0, 0, IMAGE_WIDTH, IMAGE_HEIGHT);
+
+    for (int i = 0; i < NUM_LAYERS; i++) {
+        KisPaintLayerSP layer = new KisPaintLayer(m_image, QString("layer %1").arg(i), OPACITY_OPAQUE_U8);
+        layer->paintDevice()->fill(rc, KoColor(QColor(i, 255 - i, 128), cs));
+        m_image->addNode(layer, m_image->root());
+    }
+}
+
+void KisImageCloneBenchmark::cleanupTestCase()
+{
+    m_image = 0;
+}
+
+void KisImageCloneBenchmark::benchmarkClone()
+{
+    /**
+     * This is the part of the background saving that is done
+     * while the image is locked, so the user cannot paint
+     */
+    KisImageSP clone;
+
+    QBENCHMARK_ONCE {
+        clone = m_image->clone(true);
+    }
+}
+
+void KisImageCloneBenchmark::benchmarkCloneAndRead()
+{
+    /**
+     * The full cost of the clone, including the part done
+     * when the clone is accessed by the saving thread
+     */
+    const QRect rc(0, 0, IMAGE_WIDTH, IMAGE_HEIGHT);
+    QVector<quint8> pixels(4 * 64 * 64);
+
+    QBENCHMARK_ONCE {
+        KisImageSP clone = m_image->clone(true);
+
+        KisLayerUtils::recursiveApplyNodes(clone->root(),
+            [&pixels] (KisNodeSP node) {
+                KisPaintDeviceSP dev = node->paintDevice();
+                if (!dev) return;
+
+                dev->readBytes(pixels.data(), QRect(0, 0, 64, 64));
+            });
+    }
+}
+
+QTEST_MAIN(KisImageCloneBenchmark)
@@ -0,0 +1,156 @@
+/*
+ *  Copyright (c) 2020 Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "KisKraStoreBenchmark.h"
+
+#include <QTest>
+#include <QBuffer>
+
+#include <KoColorSpaceRegistry.h>
+#include <KoColor.h>
+#include <KoStore.h>
+
+#include "kis_paint_device.h"
+#include "kis_assert.h"
+#include "kis_sequential_iterator.h"
+#include "kis_store_paintdevice_writer.h"
+
+const int IMAGE_WIDTH = 4096;
+const int IMAGE_HEIGHT = 4096;
+
+void KisKraStoreBenchmark::initTestCase()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    m_dev = new KisPaintDevice(cs);
+
+    /**
+     * Smooth gradients with a bit of noise, which is close to what
+     * real paintings look like after LZF compression
+     */
+    KisSequentialIterator it(m_dev, QRect(0, 0, IMAGE_WIDTH, IMAGE_HEIGHT));
+    quint32 seed = 42;
+
+    while (it.nextPixel()) {
+        seed = seed * 1103515245 + 12345;
+        const int noise = (seed >> 16) & 0x7;
+
+        quint8 *pixel = it.rawData();
+        pixel[0] = (it.x() / 16 + noise) & 0xff;
+        pixel[1] = (it.y() / 16 + noise) & 0xff;
+        pixel[2] = ((it.x() + it.y()) / 32) & 0xff;
+        pixel[3] = 255;
+    }
+}
+
+QByteArray KisKraStoreBenchmark::saveDevice(KoStore::EntryCompression compression, bool compressionEnabled)
+{
+    QByteArray data;
+    QBuffer buffer(&data);
+
+    QScopedPointer<KoStore> store(
+        KoStore::createStore(&buffer, KoStore::Write, "application/x-krita", KoStore::Zip));
+
+    store->setCompressionEnabled(compressionEnabled);
+    store->setEntryCompression(compression);
+
+    KisStorePaintDeviceWriter writer(store.data());
+
+    KIS_ASSERT(store->open("layers/layer1"));
+    KIS_ASSERT(m_dev->write(writer));
+    store->close();
+
+    store->setCompressionEnabled(true);
+    store->setEntryCompression(KoStore::DeflatedEntry);
+
+    KIS_ASSERT(store->open("maindoc.xml"));
+    store->write(QByteArray("<DOC/>"));
+    store->close();
+
+    store->finalize();
+    store.reset();
+
+    return data;
+}
+
+void KisKraStoreBenchmark::loadDevice(const QByteArray &data)
+{
+    QBuffer buffer(const_cast<QByteArray*>(&data));
+
+    QScopedPointer<KoStore> store(
+        KoStore::createStore(&buffer, KoStore::Read, "application/x-krita", KoStore::Zip));
+
+    KisPaintDeviceSP dev = new KisPaintDevice(m_dev->colorSpace());
+
+    KIS_ASSERT(store->open("layers/layer1"));
+    KIS_ASSERT(dev->read(store->device()));
+    store->close();
+}
+
+void KisKraStoreBenchmark::benchmarkSaveDeflatedBest()
+{
+    QByteArray data;
+
+    QBENCHMARK_ONCE {
+        data = saveDevice(KoStore::DeflatedEntry, true);
+    }
+
+    qDebug() << "Size:" << data.size();
+}
+
+void KisKraStoreBenchmark::benchmarkSaveDeflatedNone()
+{
+    QByteArray data;
+
+    QBENCHMARK_ONCE {
+        data = saveDevice(KoStore::DeflatedEntry, false);
+    }
+
+    qDebug() << "Size:" << data.size();
+}
+
+void KisKraStoreBenchmark::benchmarkSaveStored()
+{
+    QByteArray data;
+
+    QBENCHMARK_ONCE {
+        data = saveDevice(KoStore::StoredEntry, false);
+    }
+
+    qDebug() << "Size:" << data.size();
+}
+
+void KisKraStoreBenchmark::benchmarkLoadDeflatedBest()
+{
+    const QByteArray data = saveDevice(KoStore::DeflatedEntry, true);
+
+    QBENCHMARK_ONCE {
+        loadDevice(data);
+    }
+}
+
+void KisKraStoreBenchmark::benchmarkLoadStored()
+{
+    const QByteArray data = saveDevice(KoStore::StoredEntry, false);
+
+    QBENCHMARK_ONCE {
+        loadDevice(data);
+    }
+}
+
+QTEST_MAIN(KisKraStoreBenchmark)
@@ -0,0 +1,50 @@
+/*
+ *  Copyright (c) 2020 Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef __KIS_KRA_STORE_BENCHMARK_H
+#define __KIS_KRA_STORE_BENCHMARK_H
+
+#include <QtTest>
+#include <KoStore.h>
+
+#include "kis_types.h"
+
+class KisKraStoreBenchmark : public QObject
+{
+    Q_OBJECT
+
+private:
+    QByteArray saveDevice(KoStore::EntryCompression compression, bool compressionEnabled);
+    void loadDevice(const QByteArray &data);
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void benchmarkSaveDeflatedBest();
+    void benchmarkSaveDeflatedNone();
+    void benchmarkSaveStored();
+
+    void benchmarkLoadDeflatedBest();
+    void benchmarkLoadStored();
+
+private:
+    KisPaintDeviceSP m_dev;
+};
+
+#endif /* __KIS_KRA_STORE_BENCHMARK_H */
@@ -0,0 +1,106 @@
+/*
+ *  Copyright (c) 2020 Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "KisPSDBenchmark.h"
+
+#include <QTest>
+
+#include <KoColorSpaceRegistry.h>
+
+#include <testutil.h>
+#include "KisPart.h"
+#include "KisDocument.h"
+#include "KisImportExportManager.h"
+#include <KisImportExportErrorCode.h>
+#include "kis_image.h"
+#include "kis_group_layer.h"
+#include "kis_paint_layer.h"
+#include "kis_sequential_iterator.h"
+
+const QString PSDMimetype = "image/vnd.adobe.photoshop";
+
+const int IMAGE_WIDTH = 4096;
+const int IMAGE_HEIGHT = 4096;
+const int NUM_LAYERS = 8;
+
+void KisPSDBenchmark::initTestCase()
+{
+    const QRect rc(0, 0, IMAGE_WIDTH, IMAGE_HEIGHT);
+
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    m_image = new KisImage(0, rc.width(), rc.height(), cs, "psd benchmark");
+
+    quint32 seed = 42;
+
+    for (int i = 0; i < NUM_LAYERS; i++) {
+        KisPaintLayerSP layer = new KisPaintLayer(m_image, QString("layer %1").arg(i), OPACITY_OPAQUE_U8);
+
+        /**
+         * Smooth gradients with a bit of noise, which is close to what
+         * real paintings look like after RLE compression
+         */
+        KisSequentialIterator it(layer->paintDevice(), rc);
+        while (it.nextPixel()) {
+            seed = seed * 1103515245 + 12345;
+            const int noise = (seed >> 16) & 0x3;
+
+            quint8 *pixel = it.rawData();
+            pixel[0] = (it.x() / 16 + i * 32 + noise) & 0xff;
+            pixel[1] = (it.y() / 16 + noise) & 0xff;
+            pixel[2] = ((it.x() + it.y()) / 32) & 0xff;
+            pixel[3] = (it.x() + i * 512) % rc.width() < rc.width() / 2 ? 255 : 0;
+        }
+
+        m_image->addNode(layer, m_image->root());
+    }
+
+    m_image->initialRefreshGraph();
+}
+
+void KisPSDBenchmark::benchmarkSaveLoadLargeImage()
+{
+    QScopedPointer<KisDocument> doc(KisPart::instance()->createDocument());
+    doc->setCurrentImage(m_image);
+    doc->setFileBatchMode(true);
+
+    QFileInfo dstFileInfo(QDir::currentPath() + QDir::separator() + "psd_large_image.psd");
+
+    QBENCHMARK_ONCE {
+        bool retval = doc->exportDocumentSync(QUrl::fromLocalFile(dstFileInfo.absoluteFilePath()), PSDMimetype.toLatin1());
+        QVERIFY(retval);
+    }
+
+    QScopedPointer<KisDocument> loadedDoc(KisPart::instance()->createDocument());
+    loadedDoc->setFileBatchMode(true);
+
+    QBENCHMARK_ONCE {
+        KisImportExportManager manager(loadedDoc.data());
+        KisImportExportErrorCode status = manager.importDocument(dstFileInfo.absoluteFilePath(), QString());
+        QVERIFY(status.isOk());
+    }
+
+    QVERIFY(loadedDoc->image());
+
+    QPoint errorPoint;
+    QVERIFY(TestUtil::comparePaintDevices(errorPoint,
+                                          m_image->root()->firstChild()->paintDevice(),
+                                          loadedDoc->image()->root()->firstChild()->paintDevice()));
+}
+
+QTEST_MAIN(KisPSDBenchmark)
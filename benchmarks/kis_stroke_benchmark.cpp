@@ -161,6 +161,39 @@ void KisStrokeBenchmark::deformBrushRL()
     benchmarkRandomLines(presetFileName);
 }
 
+void KisStrokeBenchmark::deformBrush500px()
+{
+    QString presetFileName = "deform-default.kpp";
+
+    KisPaintOpPresetSP preset = new KisPaintOpPreset(m_dataPath + presetFileName);
+    QVERIFY(preset->load());
+
+    // 500px radius, the size where the deform dabs become painfully slow
+    preset->settings()->setProperty("Brush/diameter", 1000);
+
+    m_painter->setPaintOpPreset(preset, m_layer, m_image);
+
+    QPointF startPoint(0.10 * TEST_IMAGE_WIDTH, 0.5 * TEST_IMAGE_HEIGHT);
+    QPointF endPoint(0.90 * TEST_IMAGE_WIDTH, 0.5 * TEST_IMAGE_HEIGHT);
+
+    KisPaintInformation pi1(startPoint, 1.0);
+    KisPaintInformation pi2(endPoint, 1.0);
+
+    int numDabs = 0;
+
+    QBENCHMARK{
+        KisDistanceInformation currentDistance;
+        m_painter->paintLine(pi1, pi2, &currentDistance);
+        numDabs = currentDistance.currentDabSeqNo();
+    }
+
+    dbgKrita << "dabs per line:" << numDabs;
+
+#ifdef SAVE_OUTPUT
+    m_layer->paintDevice()->convertToQImage(0).save(m_outputPath + presetFileName + "_500px" + OUTPUT_FORMAT);
+#endif
+}
+
 void KisStrokeBenchmark::pixelbrush300px()
 {
     QString presetFileName = "autobrush_300px.kpp";
@@ -120,6 +120,7 @@ private Q_SLOTS:
 
     void deformBrush();
     void deformBrushRL();
+    void deformBrush500px();
 
     void experimental();
     void experimentalCircle();
@@ -0,0 +1,337 @@
+/*
+ *  Copyright (c) 2020 Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "KisLatencyTracer.h"
+
+#include <atomic>
+
+#include <QMap>
+#include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QThreadStorage>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QGlobalStatic>
+
+#include "kis_debug.h"
+
+Q_GLOBAL_STATIC(KisLatencyTracer, s_instance)
+
+namespace {
+
+/**
+ * Limits the memory consumed by the tracer during long sessions
+ */
+const int maxNumEvents = 1000000;
+const int maxNumUnfinishedTraces = 100000;
+
+struct Event {
+    KisLatencyTracer::Stage stage;
+    quintptr threadId;
+    qint64 start;
+    qint64 duration;
+    KisLatencyTracer::TraceIds ids;
+};
+
+QElapsedTimer* globalTimer()
+{
+    static QElapsedTimer *timer = [] () {
+        QElapsedTimer *t = new QElapsedTimer();
+        t->start();
+        return t;
+    }();
+
+    return timer;
+}
+
+QThreadStorage<KisLatencyTracer::TraceIds> s_currentTraces;
+
+int bucketForDuration(qint64 duration)
+{
+    int bucket = 0;
+    while (duration > 1 && bucket < KisLatencyTracer::numHistogramBuckets - 1) {
+        duration >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+}
+
+struct KisLatencyTracer::Private
+{
+    std::atomic<bool> isEnabled {false};
+    std::atomic<quint64> nextTraceId {1};
+
+    QString outputFileName;
+
+    mutable QMutex mutex;
+    QVector<Event> events;
+    int numDroppedEvents = 0;
+    QMap<quint64, qint64> unfinishedTraces;
+    QVector<int> histograms[NumStages];
+
+    void addHistogramValue(Stage stage, qint64 duration) {
+        histograms[stage][bucketForDuration(duration)]++;
+    }
+};
+
+KisLatencyTracer::ScopedCurrentTraces::ScopedCurrentTraces(const TraceIds &ids)
+    : m_oldIds(s_currentTraces.localData())
+{
+    s_currentTraces.localData() = ids;
+}
+
+KisLatencyTracer::ScopedCurrentTraces::~ScopedCurrentTraces()
+{
+    s_currentTraces.localData() = m_oldIds;
+}
+
+KisLatencyTracer::KisLatencyTracer()
+    : m_d(new Private)
+{
+    for (int i = 0; i < NumStages; i++) {
+        m_d->histograms[i].resize(numHistogramBuckets);
+    }
+
+    const QString fileName = QString::fromLocal8Bit(qgetenv("KRITA_LATENCY_TRACE"));
+    if (!fileName.isEmpty()) {
+        setOutputFileName(fileName);
+        setEnabled(true);
+    }
+}
+
+KisLatencyTracer::~KisLatencyTracer()
+{
+    if (!m_d->outputFileName.isEmpty()) {
+        save(m_d->outputFileName);
+    }
+}
+
+KisLatencyTracer *KisLatencyTracer::instance()
+{
+    return s_instance;
+}
+
+bool KisLatencyTracer::isEnabled() const
+{
+    return m_d->isEnabled;
+}
+
+void KisLatencyTracer::setEnabled(bool value)
+{
+    globalTimer();
+    m_d->isEnabled = value;
+}
+
+void KisLatencyTracer::setOutputFileName(const QString &fileName)
+{
+    QMutexLocker l(&m_d->mutex);
+    m_d->outputFileName = fileName;
+}
+
+qint64 KisLatencyTracer::now()
+{
+    return globalTimer()->nsecsElapsed() / 1000;
+}
+
+quint64 KisLatencyTracer::startTrace()
+{
+    if (!m_d->isEnabled) return 0;
+
+    const quint64 id = m_d->nextTraceId++;
+    const qint64 startTime = now();
+
+    QMutexLocker l(&m_d->mutex);
+
+    // the ids grow monotonically, so the oldest trace is the first one
+    if (m_d->unfinishedTraces.size() >= maxNumUnfinishedTraces) {
+        m_d->unfinishedTraces.erase(m_d->unfinishedTraces.begin());
+    }
+
+    m_d->unfinishedTraces.insert(id, startTime);
+
+    return id;
+}
+
+void KisLatencyTracer::addEvent(Stage stage, const TraceIds &ids, qint64 start, qint64 end)
+{
+    if (!m_d->isEnabled || ids.isEmpty()) return;
+
+    Event event;
+    event.stage = stage;
+    event.threadId = reinterpret_cast<quintptr>(QThread::currentThreadId());
+    event.start = start;
+    event.duration = end - start;
+    event.ids = ids;
+
+    QMutexLocker l(&m_d->mutex);
+
+    m_d->addHistogramValue(stage, event.duration);
+
+    if (m_d->events.size() < maxNumEvents) {
+        m_d->events.append(event);
+    } else {
+        m_d->numDroppedEvents++;
+    }
+}
+
+void KisLatencyTracer::finishTraces(const TraceIds &ids, qint64 end)
+{
+    if (!m_d->isEnabled || ids.isEmpty()) return;
+
+    QMutexLocker l(&m_d->mutex);
+
+    Q_FOREACH (quint64 id, ids) {
+        auto it = m_d->unfinishedTraces.find(id);
+        if (it == m_d->unfinishedTraces.end()) continue;
+
+        Event event;
+        event.stage = Total;
+        event.threadId = reinterpret_cast<quintptr>(QThread::currentThreadId());
+        event.start = it.value();
+        event.duration = end - it.value();
+        event.ids = {id};
+
+        m_d->addHistogramValue(Total, event.duration);
+
+        if (m_d->events.size() < maxNumEvents) {
+            m_d->events.append(event);
+        } else {
+            m_d->numDroppedEvents++;
+        }
+
+        m_d->unfinishedTraces.erase(it);
+    }
+}
+
+KisLatencyTracer::TraceIds KisLatencyTracer::currentTraces()
+{
+    return s_currentTraces.hasLocalData() ? s_currentTraces.localData() : TraceIds();
+}
+
+QString KisLatencyTracer::stageName(Stage stage)
+{
+    switch (stage) {
+    case StrokeQueue:
+        return "stroke-queue";
+    case StrokeJob:
+        return "stroke-job";
+    case UpdateQueue:
+        return "update-queue";
+    case Merge:
+        return "merge";
+    case CanvasCompressor:
+        return "canvas-compressor";
+    case CanvasUpload:
+        return "canvas-upload";
+    case Total:
+        return "total";
+    case NumStages:
+        break;
+    }
+
+    return QString();
+}
+
+QVector<int> KisLatencyTracer::histogram(Stage stage) const
+{
+    KIS_SAFE_ASSERT_RECOVER_RETURN_VALUE(stage >= 0 && stage < NumStages, QVector<int>());
+
+    QMutexLocker l(&m_d->mutex);
+    return m_d->histograms[stage];
+}
+
+bool KisLatencyTracer::save(const QString &fileName) const
+{
+    QJsonArray traceEvents;
+    QJsonObject histograms;
+    int numDroppedEvents = 0;
+
+    {
+        QMutexLocker l(&m_d->mutex);
+
+        Q_FOREACH (const Event &event, m_d->events) {
+            QJsonArray ids;
+            Q_FOREACH (quint64 id, event.ids) {
+                ids.append(QJsonValue(qint64(id)));
+            }
+
+            QJsonObject args;
+            args["ids"] = ids;
+
+            QJsonObject object;
+            object["name"] = stageName(event.stage);
+            object["cat"] = "krita";
+            object["ph"] = "X";
+            object["ts"] = event.start;
+            object["dur"] = event.duration;
+            object["pid"] = 1;
+            object["tid"] = qint64(event.threadId);
+            object["args"] = args;
+
+            traceEvents.append(object);
+        }
+
+        for (int i = 0; i < NumStages; i++) {
+            QJsonArray buckets;
+            Q_FOREACH (int value, m_d->histograms[i]) {
+                buckets.append(value);
+            }
+            histograms[stageName(Stage(i))] = buckets;
+        }
+
+        numDroppedEvents = m_d->numDroppedEvents;
+    }
+
+    QJsonObject otherData;
+    otherData["histogramBuckets"] = "log2(microseconds)";
+    otherData["histograms"] = histograms;
+    otherData["droppedEvents"] = numDroppedEvents;
+
+    QJsonObject root;
+    root["traceEvents"] = traceEvents;
+    root["displayTimeUnit"] = "ms";
+    root["otherData"] = otherData;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        warnKrita << "KisLatencyTracer: failed to open" << fileName;
+        return false;
+    }
+
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    return true;
+}
+
+void KisLatencyTracer::reset()
+{
+    QMutexLocker l(&m_d->mutex);
+
+    m_d->events.clear();
+    m_d->numDroppedEvents = 0;
+    m_d->unfinishedTraces.clear();
+
+    for (int i = 0; i < NumStages; i++) {
+        m_d->histograms[i].fill(0);
+    }
+}
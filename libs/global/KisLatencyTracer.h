@@ -0,0 +1,141 @@
+/*
+ *  Copyright (c) 2020 Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KISLATENCYTRACER_H
+#define KISLATENCYTRACER_H
+
+#include <QVector>
+#include <QString>
+#include <QScopedPointer>
+
+#include "kritaglobal_export.h"
+
+/**
+ * KisLatencyTracer follows the stroke jobs through the whole update
+ * pipeline: the strokes queue, the stroke job itself (the paintop), the
+ * updates queue, the merger, the canvas updates compressor and the
+ * upload of the data into the canvas.
+ *
+ * Every stroke job gets a unique trace id when it is added to the stroke.
+ * The ids are passed from one stage to another: a stage running in a
+ * worker thread sets the ids it processes as "current" for this thread
+ * (see ScopedCurrentTraces), and the next stage takes them with
+ * currentTraces() when it is created.
+ *
+ * The tracer is disabled by default. It is enabled by setting the
+ * environment variable KRITA_LATENCY_TRACE to the name of a file. On exit
+ * the collected events are written into this file in the Chrome Trace
+ * Event format (can be opened in chrome://tracing or Perfetto). The
+ * per-stage latency histograms are saved in the "otherData" section.
+ */
+class KRITAGLOBAL_EXPORT KisLatencyTracer
+{
+public:
+    enum Stage {
+        StrokeQueue = 0,
+        StrokeJob,
+        UpdateQueue,
+        Merge,
+        CanvasCompressor,
+        CanvasUpload,
+        Total,
+        NumStages
+    };
+
+    typedef QVector<quint64> TraceIds;
+
+    /**
+     * Sets the ids being processed by the current thread for
+     * the lifetime of the object
+     */
+    class KRITAGLOBAL_EXPORT ScopedCurrentTraces
+    {
+    public:
+        ScopedCurrentTraces(const TraceIds &ids);
+        ~ScopedCurrentTraces();
+
+    private:
+        Q_DISABLE_COPY(ScopedCurrentTraces)
+        TraceIds m_oldIds;
+    };
+
+public:
+    KisLatencyTracer();
+    ~KisLatencyTracer();
+
+    static KisLatencyTracer* instance();
+
+    bool isEnabled() const;
+    void setEnabled(bool value);
+
+    /**
+     * The file the trace is saved to on destruction of the tracer.
+     * Empty string means that nothing is saved.
+     */
+    void setOutputFileName(const QString &fileName);
+
+    /**
+     * \return the current time in microseconds
+     */
+    static qint64 now();
+
+    /**
+     * Starts a new trace and remembers its start time.
+     * \return the id of the trace or 0 if the tracer is disabled
+     */
+    quint64 startTrace();
+
+    /**
+     * Records that traces \p ids spent time from \p start till \p end
+     * in stage \p stage
+     */
+    void addEvent(Stage stage, const TraceIds &ids, qint64 start, qint64 end);
+
+    /**
+     * Records the total latency of every trace in \p ids that hasn't
+     * been finished yet. The traces are finished when their data
+     * reaches the canvas.
+     */
+    void finishTraces(const TraceIds &ids, qint64 end);
+
+    /**
+     * \return the ids of the traces processed by the current thread
+     */
+    static TraceIds currentTraces();
+
+    static QString stageName(Stage stage);
+
+    /**
+     * The histograms use power-of two buckets: bucket i counts the events
+     * with the duration in range [2^i, 2^(i+1)) microseconds. Bucket 0
+     * counts also zero-length events.
+     */
+    static const int numHistogramBuckets = 32;
+    QVector<int> histogram(Stage stage) const;
+
+    bool save(const QString &fileName) const;
+    void reset();
+
+private:
+    Q_DISABLE_COPY(KisLatencyTracer)
+
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+#endif // KISLATENCYTRACER_H
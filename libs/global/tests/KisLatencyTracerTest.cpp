@@ -0,0 +1,128 @@
+/*
+ *  Copyright (c) 2020 Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "KisLatencyTracerTest.h"
+
+#include <numeric>
+
+#include <QTemporaryDir>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include "KisLatencyTracer.h"
+
+void KisLatencyTracerTest::testDisabled()
+{
+    KisLatencyTracer tracer;
+    tracer.setEnabled(false);
+
+    QCOMPARE(tracer.startTrace(), quint64(0));
+
+    tracer.addEvent(KisLatencyTracer::Merge, {1}, 0, 100);
+    QCOMPARE(tracer.histogram(KisLatencyTracer::Merge)[6], 0);
+}
+
+void KisLatencyTracerTest::testCurrentTraces()
+{
+    QVERIFY(KisLatencyTracer::currentTraces().isEmpty());
+
+    {
+        KisLatencyTracer::ScopedCurrentTraces outer({1, 2});
+        QCOMPARE(KisLatencyTracer::currentTraces(), KisLatencyTracer::TraceIds({1, 2}));
+
+        {
+            KisLatencyTracer::ScopedCurrentTraces inner({3});
+            QCOMPARE(KisLatencyTracer::currentTraces(), KisLatencyTracer::TraceIds({3}));
+        }
+
+        QCOMPARE(KisLatencyTracer::currentTraces(), KisLatencyTracer::TraceIds({1, 2}));
+    }
+
+    QVERIFY(KisLatencyTracer::currentTraces().isEmpty());
+}
+
+void KisLatencyTracerTest::testTraceFlow()
+{
+    KisLatencyTracer tracer;
+    tracer.setEnabled(true);
+
+    const quint64 id1 = tracer.startTrace();
+    const quint64 id2 = tracer.startTrace();
+
+    QVERIFY(id1);
+    QVERIFY(id2);
+    QVERIFY(id1 != id2);
+
+    // 100us falls into bucket 6: [64, 128)
+    tracer.addEvent(KisLatencyTracer::Merge, {id1, id2}, 1000, 1100);
+    QCOMPARE(tracer.histogram(KisLatencyTracer::Merge)[6], 1);
+
+    // zero-length events go to the first bucket
+    tracer.addEvent(KisLatencyTracer::StrokeJob, {id1}, 1000, 1000);
+    QCOMPARE(tracer.histogram(KisLatencyTracer::StrokeJob)[0], 1);
+
+    const qint64 end = KisLatencyTracer::now();
+
+    // every trace is finished only once
+    tracer.finishTraces({id1, id2}, end);
+    tracer.finishTraces({id1}, end);
+
+    const QVector<int> total = tracer.histogram(KisLatencyTracer::Total);
+    QCOMPARE(std::accumulate(total.begin(), total.end(), 0), 2);
+
+    tracer.reset();
+    QCOMPARE(tracer.histogram(KisLatencyTracer::Merge)[6], 0);
+}
+
+void KisLatencyTracerTest::testSave()
+{
+    KisLatencyTracer tracer;
+    tracer.setEnabled(true);
+
+    const quint64 id = tracer.startTrace();
+    tracer.addEvent(KisLatencyTracer::StrokeQueue, {id}, 10, 20);
+    tracer.addEvent(KisLatencyTracer::StrokeJob, {id}, 20, 50);
+    tracer.finishTraces({id}, KisLatencyTracer::now());
+
+    QTemporaryDir dir;
+    const QString fileName = dir.path() + "/trace.json";
+
+    QVERIFY(tracer.save(fileName));
+
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+
+    const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+    const QJsonArray events = root["traceEvents"].toArray();
+
+    QCOMPARE(events.size(), 3);
+
+    const QJsonObject strokeJob = events[1].toObject();
+    QCOMPARE(strokeJob["name"].toString(), QString("stroke-job"));
+    QCOMPARE(strokeJob["ph"].toString(), QString("X"));
+    QCOMPARE(strokeJob["ts"].toInt(), 20);
+    QCOMPARE(strokeJob["dur"].toInt(), 30);
+    QCOMPARE(strokeJob["args"].toObject()["ids"].toArray().first().toInt(), int(id));
+
+    const QJsonObject histograms = root["otherData"].toObject()["histograms"].toObject();
+    QCOMPARE(histograms["stroke-job"].toArray().size(), int(KisLatencyTracer::numHistogramBuckets));
+}
+
+QTEST_MAIN(KisLatencyTracerTest)
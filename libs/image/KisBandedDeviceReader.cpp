@@ -0,0 +1,223 @@
+/*
+ *  Copyright (c) 2020 Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "KisBandedDeviceReader.h"
+
+#include <QQueue>
+#include <QFuture>
+#include <QtConcurrent>
+
+#include <KoColor.h>
+#include <KoColorSpace.h>
+#include <KoCompositeOp.h>
+#include <KoCompositeOpRegistry.h>
+
+#include "kis_assert.h"
+#include "kis_paint_device.h"
+#include "kis_image_config.h"
+
+namespace {
+
+/**
+ * The height of the bands matches the height of the tiles, so
+ * (for aligned rects) every tile is read by a single worker
+ */
+const int bandHeight = 64;
+
+struct Band {
+    int top = 0;
+    int height = 0;
+    QByteArray data;
+};
+
+}
+
+struct KisBandedDeviceReader::Private
+{
+    KisPaintDeviceSP device;
+    QRect rect;
+    const KoColorSpace *srcColorSpace = 0;
+    const KoColorSpace *dstColorSpace = 0;
+
+    bool useFillColor = false;
+    QByteArray fillPixel;
+
+    KoColorConversionTransformation::Intent renderingIntent =
+        KoColorConversionTransformation::internalRenderingIntent();
+    KoColorConversionTransformation::ConversionFlags conversionFlags =
+        KoColorConversionTransformation::internalConversionFlags();
+
+    int maxPendingBands = 2;
+    int nextBandTop = 0;
+    QQueue<QFuture<Band>> pendingBands;
+    Band currentBand;
+
+    Band readBand(int top, int height) const;
+    void scheduleBands();
+};
+
+KisBandedDeviceReader::KisBandedDeviceReader(KisPaintDeviceSP device, const QRect &rect, const KoColorSpace *dstColorSpace)
+    : m_d(new Private)
+{
+    m_d->device = device;
+    m_d->rect = rect;
+    m_d->srcColorSpace = device->colorSpace();
+    m_d->dstColorSpace = dstColorSpace ? dstColorSpace : device->colorSpace();
+    m_d->nextBandTop = rect.top();
+
+    // every band in flight is converted by its own worker thread
+    m_d->maxPendingBands = qBound(2, KisImageConfig(true).maxNumberOfThreads(), 8);
+}
+
+KisBandedDeviceReader::~KisBandedDeviceReader()
+{
+    // the jobs access the private data, so they should finish before it is gone
+    Q_FOREACH (QFuture<Band> band, m_d->pendingBands) {
+        band.waitForFinished();
+    }
+}
+
+void KisBandedDeviceReader::setFillColor(const KoColor &color)
+{
+    KIS_SAFE_ASSERT_RECOVER_RETURN(m_d->pendingBands.isEmpty() && m_d->nextBandTop == m_d->rect.top());
+
+    KoColor fillColor(color);
+    fillColor.convertTo(m_d->srcColorSpace);
+
+    m_d->fillPixel = QByteArray(reinterpret_cast<const char*>(fillColor.data()), m_d->srcColorSpace->pixelSize());
+    m_d->useFillColor = true;
+}
+
+void KisBandedDeviceReader::setConversionOptions(KoColorConversionTransformation::Intent renderingIntent,
+                                                 KoColorConversionTransformation::ConversionFlags conversionFlags)
+{
+    KIS_SAFE_ASSERT_RECOVER_RETURN(m_d->pendingBands.isEmpty() && m_d->nextBandTop == m_d->rect.top());
+
+    m_d->renderingIntent = renderingIntent;
+    m_d->conversionFlags = conversionFlags;
+}
+
+const KoColorSpace *KisBandedDeviceReader::colorSpace() const
+{
+    return m_d->dstColorSpace;
+}
+
+QRect KisBandedDeviceReader::rect() const
+{
+    return m_d->rect;
+}
+
+bool KisBandedDeviceReader::nextBand()
+{
+    m_d->currentBand = Band();
+    m_d->scheduleBands();
+
+    if (m_d->pendingBands.isEmpty()) {
+        return false;
+    }
+
+    m_d->currentBand = m_d->pendingBands.dequeue().result();
+
+    // keep the workers busy while the encoder processes the current band
+    m_d->scheduleBands();
+
+    return true;
+}
+
+int KisBandedDeviceReader::bandTop() const
+{
+    return m_d->currentBand.top;
+}
+
+int KisBandedDeviceReader::bandBottom() const
+{
+    return m_d->currentBand.top + m_d->currentBand.height - 1;
+}
+
+const quint8 *KisBandedDeviceReader::row(int y) const
+{
+    KIS_SAFE_ASSERT_RECOVER_RETURN_VALUE(y >= bandTop() && y <= bandBottom(), 0);
+
+    const int rowSize = m_d->rect.width() * m_d->dstColorSpace->pixelSize();
+    return reinterpret_cast<const quint8*>(m_d->currentBand.data.constData()) + (y - bandTop()) * rowSize;
+}
+
+void KisBandedDeviceReader::Private::scheduleBands()
+{
+    while (pendingBands.size() < maxPendingBands && nextBandTop <= rect.bottom()) {
+        const int top = nextBandTop;
+        const int height = qMin(bandHeight, rect.bottom() - top + 1);
+
+        pendingBands.enqueue(
+            QtConcurrent::run(
+                [this, top, height] () {
+                    return readBand(top, height);
+                }));
+
+        nextBandTop += height;
+    }
+}
+
+Band KisBandedDeviceReader::Private::readBand(int top, int height) const
+{
+    const int srcPixelSize = srcColorSpace->pixelSize();
+    const int numPixels = rect.width() * height;
+
+    QByteArray srcData(numPixels * srcPixelSize, Qt::Uninitialized);
+    device->readBytes(reinterpret_cast<quint8*>(srcData.data()), rect.x(), top, rect.width(), height);
+
+    if (useFillColor) {
+        QByteArray filledData(numPixels * srcPixelSize, Qt::Uninitialized);
+        quint8 *filledPtr = reinterpret_cast<quint8*>(filledData.data());
+
+        for (int i = 0; i < numPixels; i++) {
+            memcpy(filledPtr + i * srcPixelSize, fillPixel.constData(), srcPixelSize);
+        }
+
+        KoCompositeOp::ParameterInfo params;
+        params.dstRowStart = filledPtr;
+        params.dstRowStride = rect.width() * srcPixelSize;
+        params.srcRowStart = reinterpret_cast<const quint8*>(srcData.constData());
+        params.srcRowStride = rect.width() * srcPixelSize;
+        params.maskRowStart = 0;
+        params.maskRowStride = 0;
+        params.rows = height;
+        params.cols = rect.width();
+
+        srcColorSpace->compositeOp(COMPOSITE_OVER)->composite(params);
+
+        srcData = filledData;
+    }
+
+    Band band;
+    band.top = top;
+    band.height = height;
+
+    if (*srcColorSpace == *dstColorSpace) {
+        band.data = srcData;
+    } else {
+        band.data = QByteArray(numPixels * dstColorSpace->pixelSize(), Qt::Uninitialized);
+
+        srcColorSpace->convertPixelsTo(reinterpret_cast<const quint8*>(srcData.constData()),
+                                       reinterpret_cast<quint8*>(band.data.data()),
+                                       dstColorSpace, numPixels,
+                                       renderingIntent, conversionFlags);
+    }
+
+    return band;
+}
@@ -0,0 +1,123 @@
+/*
+ *  Copyright (c) 2020 Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KISBANDEDDEVICEREADER_H
+#define KISBANDEDDEVICEREADER_H
+
+#include <QScopedPointer>
+
+#include <KoColorConversionTransformation.h>
+
+#include "kis_types.h"
+#include "kritaimage_export.h"
+
+class KoColor;
+class KoColorSpace;
+class QRect;
+
+/**
+ * Streams the pixels of a paint device to a file encoder in bands of
+ * rows, without creating a flattened or converted copy of the device.
+ *
+ * The rows are read directly from the tiles of the device. The
+ * optional composition over a background color and the color space
+ * conversion are done for every band separately on worker threads,
+ * a few bands ahead of the encoder. Therefore, the peak memory usage
+ * is limited to a few bands, independently of the size of the image.
+ *
+ * Example:
+ *
+ * \code{.cpp}
+ * KisBandedDeviceReader reader(image->projection(), image->bounds(), dstColorSpace);
+ *
+ * while (reader.nextBand()) {
+ *     for (int y = reader.bandTop(); y <= reader.bandBottom(); y++) {
+ *         const quint8 *row = reader.row(y);
+ *         // encode the row...
+ *     }
+ * }
+ * \endcode
+ *
+ * The device should not be changed while the reader is alive.
+ */
+class KRITAIMAGE_EXPORT KisBandedDeviceReader
+{
+public:
+    /**
+     * \param device the device to read the pixels from
+     * \param rect the area of the device that is read
+     * \param dstColorSpace the color space of the returned rows. If it is
+     *        null, the rows are returned in the color space of the device.
+     */
+    KisBandedDeviceReader(KisPaintDeviceSP device, const QRect &rect, const KoColorSpace *dstColorSpace = 0);
+    ~KisBandedDeviceReader();
+
+    /**
+     * Composite the pixels of the device over \p color before they are
+     * converted into the destination color space. It is used by the
+     * formats that cannot store the alpha channel.
+     */
+    void setFillColor(const KoColor &color);
+
+    /**
+     * Set the options of the conversion into the destination color space.
+     * By default the internal rendering intent and flags are used.
+     */
+    void setConversionOptions(KoColorConversionTransformation::Intent renderingIntent,
+                              KoColorConversionTransformation::ConversionFlags conversionFlags);
+
+    /**
+     * \return the color space of the returned rows
+     */
+    const KoColorSpace* colorSpace() const;
+
+    /**
+     * \return the area of the device that is read
+     */
+    QRect rect() const;
+
+    /**
+     * Fetch the next band of rows. The pointers returned by row() for the
+     * previous band become invalid.
+     *
+     * \return false when all the rows of the rect have already been read
+     */
+    bool nextBand();
+
+    /**
+     * \return the y-coordinate of the first row of the current band
+     */
+    int bandTop() const;
+
+    /**
+     * \return the y-coordinate of the last row of the current band
+     */
+    int bandBottom() const;
+
+    /**
+     * \return the pixels of the row \p y of the current band. The row
+     *         contains rect().width() pixels of colorSpace()
+     */
+    const quint8* row(int y) const;
+
+private:
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+#endif // KISBANDEDDEVICEREADER_H
@@ -25,6 +25,7 @@
 
 #include "kis_abstract_projection_plane.h"
 #include "kis_projection_leaf.h"
+#include "KisLatencyTracer.h"
 
 
 class KisBaseRectsWalker;
@@ -222,6 +223,27 @@ public:
         return m_levelOfDetail;
     }
 
+    /**
+     * Attaches latency traces to the walker. When several walkers
+     * are merged, the traces of all of them are kept together with
+     * the time of the earliest request.
+     */
+    inline void addTraces(const KisLatencyTracer::TraceIds &ids, qint64 requestTime) {
+        if (ids.isEmpty()) return;
+
+        m_traceRequestTime = m_traceIds.isEmpty() ?
+            requestTime : qMin(m_traceRequestTime, requestTime);
+        m_traceIds += ids;
+    }
+
+    inline const KisLatencyTracer::TraceIds& traceIds() const {
+        return m_traceIds;
+    }
+
+    inline qint64 traceRequestTime() const {
+        return m_traceRequestTime;
+    }
+
     virtual UpdateType type() const = 0;
 
 protected:
@@ -511,6 +533,9 @@ private:
     QRect m_lastNeedRect;
 
     int m_levelOfDetail;
+
+    KisLatencyTracer::TraceIds m_traceIds;
+    qint64 m_traceRequestTime = 0;
 };
 
 #endif /* __KIS_BASE_RECTS_WALKER_H */
@@ -173,6 +173,17 @@ void KisImageConfig::setSwapWindowSize(int value)
     m_config.writeEntry("swapWindowSize", value);
 }
 
+bool KisImageConfig::lazyTileLoading(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("lazyTileLoading", true) : true;
+}
+
+void KisImageConfig::setLazyTileLoading(bool value)
+{
+    m_config.writeEntry("lazyTileLoading", value);
+}
+
 int KisImageConfig::tilesHardLimit() const
 {
     qreal hp = qreal(memoryHardLimitPercent()) / 100.0;
@@ -58,6 +58,13 @@ public:
     int swapWindowSize() const;
     void setSwapWindowSize(int value);
 
+    /**
+     * When true, the tiles read from .kra files are kept compressed
+     * in the swap and decompressed only when accessed for the first time
+     */
+    bool lazyTileLoading(bool requestDefault = false) const;
+    void setLazyTileLoading(bool value);
+
     int tilesHardLimit() const; // MiB
     int tilesSoftLimit() const; // MiB
     int poolLimit() const; // MiB
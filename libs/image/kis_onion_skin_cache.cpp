@@ -21,19 +21,127 @@
 #include <QReadWriteLock>
 #include <QReadLocker>
 #include <QWriteLocker>
+#include <QHash>
+#include <QtMath>
 
 
 #include "kis_paint_device.h"
+#include "kis_datamanager.h"
 #include "kis_onion_skin_compositor.h"
 #include "kis_default_bounds.h"
 #include "kis_image.h"
+#include "kis_painter.h"
+#include "kis_paint_device_frames_interface.h"
+#include "kis_keyframe.h"
 
 #include "kis_raster_keyframe_channel.h"
 
 
+namespace {
+
+/**
+ * A frame of the source device tinted with the color of
+ * the onion skin direction. The untinted snapshot of the frame
+ * shares the tiles with the source frame, so it costs almost
+ * nothing until the frame is painted on.
+ */
+struct TintedFrame {
+    KisPaintDeviceSP snapshot;
+    KisPaintDeviceSP tinted;
+    int frameSeqNo = -1;
+    int tintSeqNo = -1;
+    bool used = false;
+};
+
+typedef QPair<int, bool> TintedFrameKey;
+
+const int tileSize = 64;
+
+/**
+ * Returns tile-aligned rects where the pixels of \p oldDevice
+ * and \p newDevice differ.
+ *
+ * Both devices are snapshots of the same frame, so the tiles that
+ * were not painted on since the previous snapshot still share their
+ * tile data thanks to copy-on-write. Such tiles are skipped without
+ * reading their pixels, only the tiles with different data are
+ * compared byte by byte.
+ */
+QVector<QRect> changedTiles(KisPaintDeviceSP oldDevice, KisPaintDeviceSP newDevice)
+{
+    QVector<QRect> result;
+
+    const QRect rect = oldDevice->extent() | newDevice->extent();
+    if (rect.isEmpty()) return result;
+
+    const int pixelSize = newDevice->pixelSize();
+    QVector<quint8> oldBytes(tileSize * tileSize * pixelSize);
+    QVector<quint8> newBytes(tileSize * tileSize * pixelSize);
+
+    /**
+     * The tiles can be compared directly only if the tile
+     * grids of the devices are aligned
+     */
+    const bool canCompareTileData =
+        oldDevice->x() == newDevice->x() &&
+        oldDevice->y() == newDevice->y() &&
+        oldDevice->pixelSize() == pixelSize;
+
+    KisDataManagerSP oldDataManager = oldDevice->dataManager();
+    KisDataManagerSP newDataManager = newDevice->dataManager();
+
+    const bool sameDefaultPixel =
+        canCompareTileData &&
+        !memcmp(oldDataManager->defaultPixel(), newDataManager->defaultPixel(), pixelSize);
+
+    const QPoint offset(newDevice->x(), newDevice->y());
+    const QRect dataRect = rect.translated(-offset);
+
+    const int firstCol = qFloor(qreal(dataRect.left()) / tileSize);
+    const int firstRow = qFloor(qreal(dataRect.top()) / tileSize);
+    const int lastCol = qFloor(qreal(dataRect.right()) / tileSize);
+    const int lastRow = qFloor(qreal(dataRect.bottom()) / tileSize);
+
+    for (int row = firstRow; row <= lastRow; row++) {
+        for (int col = firstCol; col <= lastCol; col++) {
+            const QRect tileRect = QRect(col * tileSize, row * tileSize, tileSize, tileSize).translated(offset);
+
+            if (canCompareTileData) {
+                bool oldTileExists = false;
+                bool newTileExists = false;
+
+                KisTileSP oldTile = oldDataManager->getReadOnlyTileLazy(col, row, oldTileExists);
+                KisTileSP newTile = newDataManager->getReadOnlyTileLazy(col, row, newTileExists);
+
+                if (oldTileExists && newTileExists &&
+                    oldTile->tileData() == newTile->tileData()) {
+
+                    continue;
+                }
+
+                if (!oldTileExists && !newTileExists && sameDefaultPixel) {
+                    continue;
+                }
+            }
+
+            oldDevice->readBytes(oldBytes.data(), tileRect);
+            newDevice->readBytes(newBytes.data(), tileRect);
+
+            if (memcmp(oldBytes.constData(), newBytes.constData(), oldBytes.size()) != 0) {
+                result << tileRect;
+            }
+        }
+    }
+
+    return result;
+}
+
+}
+
 struct KisOnionSkinCache::Private
 {
     KisPaintDeviceSP cachedProjection;
+    QHash<TintedFrameKey, TintedFrame> tintedFrames;
 
     int cacheTime = 0;
     int cacheConfigSeqNo = 0;
@@ -61,6 +169,68 @@ struct KisOnionSkinCache::Private
         cacheConfigSeqNo = seqNo;
         framesHash = hash;
     }
+
+    /**
+     * Returns a tinted copy of \p keyframe. Only the tiles changed
+     * since the previous call are tinted again, the frames that are
+     * not changed at all are reused as they are.
+     */
+    KisPaintDeviceSP fetchTintedFrame(KisPaintDeviceSP source, KisOnionSkinCompositor *compositor,
+                                      KisKeyframeSP keyframe, bool backwards)
+    {
+        KisRasterKeyframeChannel *keyframes = source->keyframeChannel();
+
+        const int frameId = keyframes->frameIdAt(keyframe->time());
+        const int frameSeqNo = source->framesInterface()->frameSequenceNumber(frameId);
+        const int tintSeqNo = compositor->tintSeqNo();
+
+        TintedFrame &frame = tintedFrames[TintedFrameKey(frameId, backwards)];
+        frame.used = true;
+
+        if (frame.tinted &&
+            frame.frameSeqNo == frameSeqNo &&
+            frame.tintSeqNo == tintSeqNo) {
+
+            return frame.tinted;
+        }
+
+        KisPaintDeviceSP snapshot = new KisPaintDevice(source->colorSpace());
+        keyframes->fetchFrame(keyframe, snapshot);
+
+        if (frame.tinted && frame.tintSeqNo == tintSeqNo) {
+            Q_FOREACH (const QRect &rc, changedTiles(frame.snapshot, snapshot)) {
+                KisPainter::copyAreaOptimized(rc.topLeft(), snapshot, frame.tinted, rc);
+                compositor->tintFrame(frame.tinted, backwards, rc);
+            }
+        } else {
+            frame.tinted = new KisPaintDevice(*snapshot);
+            compositor->tintFrame(frame.tinted, backwards, frame.tinted->extent());
+        }
+
+        frame.snapshot = snapshot;
+        frame.frameSeqNo = frameSeqNo;
+        frame.tintSeqNo = tintSeqNo;
+
+        return frame.tinted;
+    }
+
+    /**
+     * Drops the tinted frames that were not used by the last
+     * composition, so the cache never holds more than the visible
+     * onion skins
+     */
+    void dropUnusedTintedFrames()
+    {
+        auto it = tintedFrames.begin();
+        while (it != tintedFrames.end()) {
+            if (!it->used) {
+                it = tintedFrames.erase(it);
+            } else {
+                it->used = false;
+                ++it;
+            }
+        }
+    }
 };
 
 KisOnionSkinCache::KisOnionSkinCache()
@@ -96,7 +266,14 @@ KisPaintDeviceSP KisOnionSkinCache::projection(KisPaintDeviceSP source)
             }
 
             const QRect extent = compositor->calculateExtent(source);
-            compositor->composite(source, cachedProjection, extent);
+
+            auto fetchTintedFrame =
+                [this, source, compositor] (KisKeyframeSP keyframe, bool backwards) {
+                    return m_d->fetchTintedFrame(source, compositor, keyframe, backwards);
+                };
+
+            compositor->composite(source, cachedProjection, extent, fetchTintedFrame);
+            m_d->dropUnusedTintedFrames();
 
             cachedProjection->setDefaultBounds(source->defaultBounds());
 
@@ -124,6 +301,7 @@ void KisOnionSkinCache::reset()
 {
     QWriteLocker writeLocker(&m_d->lock);
     m_d->cachedProjection = 0;
+    m_d->tintedFrames.clear();
 }
 
 KisPaintDeviceSP KisOnionSkinCache::lodCapableDevice() const
@@ -21,9 +21,10 @@
 
 #include <QScopedPointer>
 #include "kis_types.h"
+#include "kritaimage_export.h"
 
 
-class KisOnionSkinCache
+class KRITAIMAGE_EXPORT KisOnionSkinCache
 {
 public:
     KisOnionSkinCache();
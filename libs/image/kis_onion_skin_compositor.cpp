@@ -39,6 +39,7 @@ struct KisOnionSkinCompositor::Private
     QVector<int> backwardOpacities;
     QVector<int> forwardOpacities;
     int configSeqNo = 0;
+    int tintSeqNo = 0;
     QList<int> colorLabelFilter;
 
     int skinOpacity(int offset)
@@ -73,27 +74,26 @@ struct KisOnionSkinCompositor::Private
         return keyframe;
     }
 
-    void tryCompositeFrame(KisRasterKeyframeChannel *keyframes, KisKeyframeSP keyframe, KisPainter &gcFrame, KisPainter &gcDest, KisPaintDeviceSP tintSource, int opacity, const QRect &rect)
-    {
-        if (keyframe.isNull() || opacity == OPACITY_TRANSPARENT_U8) return;
-
-        keyframes->fetchFrame(keyframe, gcFrame.device());
-
-        gcFrame.bitBlt(rect.topLeft(), tintSource, rect);
-
-        gcDest.setOpacity(opacity);
-        gcDest.bitBlt(rect.topLeft(), gcFrame.device(), rect);
-    }
-
     void refreshConfig()
     {
         KisImageConfig config(true);
 
+        const int oldTintFactor = tintFactor;
+        const QColor oldBackwardTintColor = backwardTintColor;
+        const QColor oldForwardTintColor = forwardTintColor;
+
         numberOfSkins = config.numberOfOnionSkins();
         tintFactor = config.onionSkinTintFactor();
         backwardTintColor = config.onionSkinTintColorBackward();
         forwardTintColor = config.onionSkinTintColorForward();
 
+        if (oldTintFactor != tintFactor ||
+            oldBackwardTintColor != backwardTintColor ||
+            oldForwardTintColor != forwardTintColor) {
+
+            tintSeqNo++;
+        }
+
         backwardOpacities.resize(numberOfSkins);
         forwardOpacities.resize(numberOfSkins);
 
@@ -131,6 +131,11 @@ int KisOnionSkinCompositor::configSeqNo() const
     return m_d->configSeqNo;
 }
 
+int KisOnionSkinCompositor::tintSeqNo() const
+{
+    return m_d->tintSeqNo;
+}
+
 void KisOnionSkinCompositor::setColorLabelFilter(QList<int> colors)
 {
     m_d->colorLabelFilter = colors;
@@ -139,15 +144,22 @@ void KisOnionSkinCompositor::setColorLabelFilter(QList<int> colors)
 void KisOnionSkinCompositor::composite(const KisPaintDeviceSP sourceDevice, KisPaintDeviceSP targetDevice, const QRect& rect)
 {
     KisRasterKeyframeChannel *keyframes = sourceDevice->keyframeChannel();
-
     KisPaintDeviceSP frameDevice = new KisPaintDevice(sourceDevice->colorSpace());
-    KisPainter gcFrame(frameDevice);
-    QBitArray channelFlags = targetDevice->colorSpace()->channelFlags(true, false);
-    gcFrame.setChannelFlags(channelFlags);
-    gcFrame.setOpacity(m_d->tintFactor);
 
-    KisPaintDeviceSP backwardTintDevice = m_d->setUpTintDevice(m_d->backwardTintColor, sourceDevice->colorSpace());
-    KisPaintDeviceSP forwardTintDevice = m_d->setUpTintDevice(m_d->forwardTintColor, sourceDevice->colorSpace());
+    auto fetchTintedFrame =
+        [this, keyframes, frameDevice, rect] (KisKeyframeSP keyframe, bool backwards) {
+            keyframes->fetchFrame(keyframe, frameDevice);
+            tintFrame(frameDevice, backwards, rect);
+            return frameDevice;
+        };
+
+    composite(sourceDevice, targetDevice, rect, fetchTintedFrame);
+}
+
+void KisOnionSkinCompositor::composite(const KisPaintDeviceSP sourceDevice, KisPaintDeviceSP targetDevice, const QRect& rect,
+                                       TintedFrameFetcher fetchTintedFrame)
+{
+    KisRasterKeyframeChannel *keyframes = sourceDevice->keyframeChannel();
 
     KisPainter gcDest(targetDevice);
     gcDest.setCompositeOp(sourceDevice->colorSpace()->compositeOp(COMPOSITE_BEHIND));
@@ -162,15 +174,31 @@ void KisOnionSkinCompositor::composite(const KisPaintDeviceSP sourceDevice, KisP
         keyframeBck = m_d->getNextFrameToComposite(keyframes, keyframeBck, true);
         keyframeFwd = m_d->getNextFrameToComposite(keyframes, keyframeFwd, false);
 
-        if (!keyframeBck.isNull()) {
-            m_d->tryCompositeFrame(keyframes, keyframeBck, gcFrame, gcDest, backwardTintDevice, m_d->skinOpacity(-offset), rect);
+        const int opacityBck = m_d->skinOpacity(-offset);
+        if (!keyframeBck.isNull() && opacityBck != OPACITY_TRANSPARENT_U8) {
+            gcDest.setOpacity(opacityBck);
+            gcDest.bitBlt(rect.topLeft(), fetchTintedFrame(keyframeBck, true), rect);
         }
 
-        if (!keyframeFwd.isNull()) {
-            m_d->tryCompositeFrame(keyframes, keyframeFwd, gcFrame, gcDest, forwardTintDevice, m_d->skinOpacity(offset), rect);
+        const int opacityFwd = m_d->skinOpacity(offset);
+        if (!keyframeFwd.isNull() && opacityFwd != OPACITY_TRANSPARENT_U8) {
+            gcDest.setOpacity(opacityFwd);
+            gcDest.bitBlt(rect.topLeft(), fetchTintedFrame(keyframeFwd, false), rect);
         }
     }
+}
+
+void KisOnionSkinCompositor::tintFrame(KisPaintDeviceSP frameDevice, bool backwards, const QRect &rect)
+{
+    const KoColorSpace *colorSpace = frameDevice->colorSpace();
 
+    KisPaintDeviceSP tintDevice =
+        m_d->setUpTintDevice(backwards ? m_d->backwardTintColor : m_d->forwardTintColor, colorSpace);
+
+    KisPainter gcFrame(frameDevice);
+    gcFrame.setChannelFlags(colorSpace->channelFlags(true, false));
+    gcFrame.setOpacity(m_d->tintFactor);
+    gcFrame.bitBlt(rect.topLeft(), tintDevice, rect);
 }
 
 QRect KisOnionSkinCompositor::calculateFullExtent(const KisPaintDeviceSP device)
@@ -19,6 +19,8 @@
 #ifndef KIS_ONION_SKIN_COMPOSITOR_H
 #define KIS_ONION_SKIN_COMPOSITOR_H
 
+#include <functional>
+
 #include "kis_types.h"
 #include "kritaimage_export.h"
 
@@ -31,13 +33,40 @@ public:
     ~KisOnionSkinCompositor() override;
     static KisOnionSkinCompositor *instance();
 
+    /**
+     * Returns a device with \p keyframe already tinted with the color
+     * of the corresponding direction
+     */
+    typedef std::function<KisPaintDeviceSP (KisKeyframeSP keyframe, bool backwards)> TintedFrameFetcher;
+
     void composite(const KisPaintDeviceSP sourceDevice, KisPaintDeviceSP targetDevice, const QRect &rect);
 
+    /**
+     * Composites the onion skins of \p sourceDevice into \p targetDevice
+     * by blending the frames returned by \p fetchTintedFrame. The fetcher
+     * lets the caller reuse the frames tinted during the previous passes.
+     */
+    void composite(const KisPaintDeviceSP sourceDevice, KisPaintDeviceSP targetDevice, const QRect &rect,
+                   TintedFrameFetcher fetchTintedFrame);
+
+    /**
+     * Tints area \p rect of \p frameDevice with the color of the backward
+     * or forward onion skins
+     */
+    void tintFrame(KisPaintDeviceSP frameDevice, bool backwards, const QRect &rect);
+
     QRect calculateFullExtent(const KisPaintDeviceSP device);
     QRect calculateExtent(const KisPaintDeviceSP device);
 
     int configSeqNo() const;
 
+    /**
+     * The number changes only when the tint color or the tint factor are
+     * changed, that is, when the frames tinted with tintFrame() become
+     * outdated.
+     */
+    int tintSeqNo() const;
+
     void setColorLabelFilter(QList<int> colors);
 
 public Q_SLOTS:
@@ -348,6 +348,12 @@ public:
         return extent;
     }
 
+    int frameSequenceNumber(int frameId) const
+    {
+        DataSP data = m_frames[frameId];
+        return data->cache()->sequenceNumber();
+    }
+
     QPoint frameOffset(int frameId) const
     {
         DataSP data = m_frames[frameId];
@@ -1130,6 +1136,11 @@ int KisPaintDevice::sequenceNumber() const
     return m_d->cache()->sequenceNumber();
 }
 
+qint64 KisPaintDevice::contentVersion() const
+{
+    return m_d->cache()->contentVersion();
+}
+
 void KisPaintDevice::estimateMemoryStats(qint64 &imageData, qint64 &temporaryData, qint64 &lodData) const
 {
     m_d->estimateMemoryStats(imageData, temporaryData, lodData);
@@ -2124,6 +2135,12 @@ QPoint KisPaintDeviceFramesInterface::frameOffset(int frameId) const
     return q->m_d->frameOffset(frameId);
 }
 
+int KisPaintDeviceFramesInterface::frameSequenceNumber(int frameId) const
+{
+    KIS_ASSERT_RECOVER(frameId >= 0) { return -1; }
+    return q->m_d->frameSequenceNumber(frameId);
+}
+
 void KisPaintDeviceFramesInterface::setFrameDefaultPixel(const KoColor &defPixel, int frameId)
 {
     KIS_ASSERT_RECOVER_RETURN(frameId >= 0);
@@ -778,6 +778,13 @@ public:
      */
     int sequenceNumber() const;
 
+    /**
+     * \return a globally unique stamp of the current content of the
+     *         device. The stamp is preserved when the device is cloned,
+     *         so two devices with equal stamps have the same pixel data.
+     */
+    qint64 contentVersion() const;
+
 
     void estimateMemoryStats(qint64 &imageData, qint64 &temporaryData, qint64 &lodData) const;
 
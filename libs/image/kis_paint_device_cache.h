@@ -21,6 +21,7 @@
 
 #include "kis_lock_free_cache.h"
 #include <QElapsedTimer>
+#include <QAtomicInteger>
 
 
 class KisPaintDeviceCache
@@ -31,7 +32,8 @@ public:
           m_exactBoundsCache(paintDevice),
           m_nonDefaultPixelAreaCache(paintDevice),
           m_regionCache(paintDevice),
-          m_sequenceNumber(0)
+          m_sequenceNumber(0),
+          m_contentVersion(0)
     {
     }
 
@@ -40,7 +42,8 @@ public:
           m_exactBoundsCache(rhs.m_paintDevice),
           m_nonDefaultPixelAreaCache(rhs.m_paintDevice),
           m_regionCache(rhs.m_paintDevice),
-          m_sequenceNumber(0)
+          m_sequenceNumber(0),
+          m_contentVersion(0)
     {
     }
 
@@ -54,6 +57,7 @@ public:
         m_nonDefaultPixelAreaCache.invalidate();
         m_regionCache.invalidate();
         m_sequenceNumber++;
+        m_contentVersion = generateContentVersion();
     }
 
     QRect exactBounds() {
@@ -112,7 +116,25 @@ public:
         return m_sequenceNumber;
     }
 
+    /**
+     * Unlike sequenceNumber(), the content version is unique among all
+     * the devices and is inherited by the clones of the device, so equal
+     * versions guarantee equal pixel data, even in different images.
+     */
+    qint64 contentVersion() const {
+        return m_contentVersion;
+    }
+
+    void setContentVersion(qint64 value) {
+        m_contentVersion = value;
+    }
+
 private:
+    static qint64 generateContentVersion() {
+        static QAtomicInteger<qint64> s_lastContentVersion;
+        return s_lastContentVersion.fetchAndAddOrdered(1) + 1;
+    }
+
     inline QImage findThumbnail(qint32 w, qint32 h, qreal oversample) {
         QImage resultImage;
         if (m_thumbnails.contains(w) && m_thumbnails[w].contains(h) && m_thumbnails[w][h].contains(oversample)) {
@@ -165,6 +187,7 @@ private:
     bool m_thumbnailsValid;
     QMap<int, QMap<int, QMap<qreal,QImage> > > m_thumbnails;
     QAtomicInt m_sequenceNumber;
+    QAtomicInteger<qint64> m_contentVersion;
 };
 
 #endif /* __KIS_PAINT_DEVICE_CACHE_H */
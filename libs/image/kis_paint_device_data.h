@@ -73,6 +73,10 @@ public:
           m_cacheInvalidator(this)
         {
             m_cache.setupCache();
+
+            if (cloneContent) {
+                m_cache.setContentVersion(rhs->m_cache.contentVersion());
+            }
         }
 
     void init(const KoColorSpace *cs, KisDataManagerSP dataManager) {
@@ -84,6 +84,13 @@ public:
      */
     QPoint frameOffset(int frameId) const;
 
+    /**
+     * @return sequence number of the cache of \p frameId. The number
+     * changes every time the content of the frame is modified, so it
+     * can be used for checking validity of the frame-based caches.
+     */
+    int frameSequenceNumber(int frameId) const;
+
     /**
      * Sets default pixel for \p frameId
      */
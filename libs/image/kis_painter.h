@@ -305,6 +305,21 @@ public:
      */
     void bltFixed(const QRect &rc, const QList<KisRenderedDab> allSrcDevices);
 
+    /**
+     * Render all the dabs from \p dabs on the destination device in one
+     * pass, grouping them by the destination tiles, and then render their
+     * mirrored copies if mirroring is active. All the painted areas are
+     * added to the dirty region of the painter.
+     *
+     * Every dab is painted with its own opacity and flow. The composite op
+     * of the painter is used for all the dabs, so it should not be changed
+     * in the middle of the batch.
+     *
+     * NOTE: when mirroring is active, the devices of the dabs are
+     *       mirrored in-place, so the caller should not reuse them.
+     */
+    void bltFixedWithMirroring(QList<KisRenderedDab> dabs);
+
     /**
      * Convenience method that uses QPoint and QRect.
      *
@@ -22,7 +22,11 @@
 #include "kis_paint_device.h"
 #include "kis_fixed_paint_device.h"
 #include "kis_random_accessor_ng.h"
+#include "kis_default_bounds_base.h"
+#include "kis_wrapped_rect.h"
+#include "krita_utils.h"
 #include "KisRenderedDab.h"
+#include "tiles3/kis_tile_data_interface.h"
 
 void KisPainter::Private::applyDevice(const QRect &applyRect,
                                       const KisRenderedDab &dab,
@@ -180,13 +184,26 @@ void KisPainter::bltFixed(const QRect &applyRect, const QList<KisRenderedDab> al
     KisRandomAccessorSP dstIt = d->device->createRandomAccessorNG(rc.left(), rc.top());
     KisRandomConstAccessorSP maskIt = d->selection ? d->selection->projection()->createRandomConstAccessorNG(rc.left(), rc.top()) : 0;
 
-    if (maskIt) {
+    /**
+     * We walk through the destination area tile-by-tile and render all
+     * the dabs touching the current tile before moving to the next one.
+     * That is, every tile is fetched and locked only once for the whole
+     * batch of dabs and its data stays hot in the cache, which matters
+     * a lot for small spacing, when hundreds of dabs overlap. The order
+     * of the dabs for every single pixel is still preserved.
+     */
+    const QVector<QRect> tileRects =
+        KritaUtils::splitRectIntoPatches(rc, QSize(KisTileData::WIDTH, KisTileData::HEIGHT));
+
+    Q_FOREACH (const QRect &tileRect, tileRects) {
         Q_FOREACH (const KisRenderedDab &dab, devices) {
-            d->applyDeviceWithSelection(rc, dab, dstIt, maskIt, srcColorSpace, localParamInfo);
-        }
-    } else {
-        Q_FOREACH (const KisRenderedDab &dab, devices) {
-            d->applyDevice(rc, dab, dstIt, srcColorSpace, localParamInfo);
+            if (!tileRect.intersects(dab.realBounds())) continue;
+
+            if (maskIt) {
+                d->applyDeviceWithSelection(tileRect, dab, dstIt, maskIt, srcColorSpace, localParamInfo);
+            } else {
+                d->applyDevice(tileRect, dab, dstIt, srcColorSpace, localParamInfo);
+            }
         }
     }
 
@@ -204,3 +221,84 @@ void KisPainter::bltFixed(const QRect &applyRect, const QList<KisRenderedDab> al
 #endif
 }
 
+
+void KisPainter::bltFixedWithMirroring(QList<KisRenderedDab> dabs)
+{
+    if (dabs.isEmpty() || !d->device) return;
+
+    QVector<QRect> rects;
+
+    if (d->device->defaultBounds()->wrapAroundMode()) {
+        /**
+         * Normalize the dabs into the wrap rect, so that all the pieces of
+         * the dabs were rendered in the same coordinate space and the order
+         * of the dabs in every tile was preserved.
+         */
+        const QRect wrapRect = d->device->defaultBounds()->bounds();
+
+        QList<KisRenderedDab> wrappedDabs;
+
+        Q_FOREACH (const KisRenderedDab &dab, dabs) {
+            const QVector<QPoint> normalizationOrigins =
+                KisWrappedRect::normalizationOriginsForRect(dab.realBounds(), wrapRect);
+
+            Q_FOREACH(const QPoint &pt, normalizationOrigins) {
+                KisRenderedDab newDab = dab;
+                newDab.offset = pt;
+
+                rects.append(newDab.realBounds() & wrapRect);
+                wrappedDabs.append(newDab);
+            }
+        }
+
+        dabs = wrappedDabs;
+    } else {
+        Q_FOREACH (const KisRenderedDab &dab, dabs) {
+            rects.append(dab.realBounds());
+        }
+    }
+
+    auto renderPass = [this, &dabs, &rects] () {
+        QRect totalRect;
+        Q_FOREACH (const QRect &rc, rects) {
+            totalRect |= rc;
+        }
+
+        bltFixed(totalRect, dabs);
+        addDirtyRects(rects);
+    };
+
+    auto mirrorPass = [this, &dabs, &rects] (Qt::Orientation direction) {
+        for (KisRenderedDab &dab : dabs) {
+            mirrorDab(direction, &dab);
+        }
+
+        for (QRect &rc : rects) {
+            mirrorRect(direction, &rc);
+        }
+    };
+
+    renderPass();
+
+    /**
+     * The sequence of 'if's is the same as in KisBrushOp: it mirrors
+     * the dabs one (h __or__ v) or three (h __and__ v) times without
+     * any extra copying. It has __no__ 'else' branches intentionally!
+     */
+    if (d->mirrorHorizontally) {
+        mirrorPass(Qt::Horizontal);
+        renderPass();
+    }
+
+    if (d->mirrorVertically) {
+        mirrorPass(Qt::Vertical);
+        renderPass();
+    }
+
+    if (d->mirrorHorizontally && d->mirrorVertically) {
+        mirrorPass(Qt::Horizontal);
+        renderPass();
+    }
+
+    setAverageOpacity(dabs.last().averageOpacity);
+}
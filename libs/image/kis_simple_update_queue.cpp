@@ -183,6 +183,14 @@ void KisSimpleUpdateQueue::addJob(KisNodeSP node, const QVector<QRect> &rects,
 {
     QList<KisBaseRectsWalkerSP> walkers;
 
+    KisLatencyTracer::TraceIds traceIds;
+    qint64 traceRequestTime = 0;
+
+    if (KisLatencyTracer::instance()->isEnabled()) {
+        traceIds = KisLatencyTracer::currentTraces();
+        traceRequestTime = !traceIds.isEmpty() ? KisLatencyTracer::now() : 0;
+    }
+
     Q_FOREACH (const QRect &rc, rects) {
         if (rc.isEmpty()) continue;
 
@@ -203,6 +211,7 @@ void KisSimpleUpdateQueue::addJob(KisNodeSP node, const QVector<QRect> &rects,
         /* else if(type == KisBaseRectsWalker::UNSUPPORTED) fatalKrita; */
 
         walker->collectRects(node, rc);
+        walker->addTraces(traceIds, traceRequestTime);
         walkers.append(walker);
     }
 
@@ -313,8 +322,16 @@ bool KisSimpleUpdateQueue::tryMergeJob(KisNodeSP node, const QRect& rc,
         }
     }
 
-    if(goodCandidate)
+    if(goodCandidate) {
+        if (KisLatencyTracer::instance()->isEnabled()) {
+            const KisLatencyTracer::TraceIds traceIds = KisLatencyTracer::currentTraces();
+            if (!traceIds.isEmpty()) {
+                goodCandidate->addTraces(traceIds, KisLatencyTracer::now());
+            }
+        }
+
         collectJobs(goodCandidate, baseRect, m_maxMergeCollectAlpha);
+    }
 
     return (bool)goodCandidate;
 }
@@ -348,6 +365,7 @@ void KisSimpleUpdateQueue::collectJobs(KisBaseRectsWalkerSP &baseWalker,
         if(item->levelOfDetail() != baseWalker->levelOfDetail()) continue;
 
         if(joinRects(baseRect, item->requestedRect(), maxAlpha)) {
+            baseWalker->addTraces(item->traceIds(), item->traceRequestTime());
             iter.remove();
         }
     }
@@ -21,6 +21,7 @@
 
 #include "kis_runnable.h"
 #include "kis_stroke_job_strategy.h"
+#include "KisLatencyTracer.h"
 
 class KisStrokeJob : public KisRunnable
 {
@@ -32,7 +33,9 @@ public:
         : m_dabStrategy(strategy),
           m_dabData(data),
           m_levelOfDetail(levelOfDetail),
-          m_isOwnJob(isOwnJob)
+          m_isOwnJob(isOwnJob),
+          m_traceId(KisLatencyTracer::instance()->startTrace()),
+          m_traceStartTime(m_traceId ? KisLatencyTracer::now() : 0)
     {
     }
 
@@ -41,7 +44,24 @@ public:
     }
 
     void run() override {
-        m_dabStrategy->run(m_dabData);
+        if (!m_traceId) {
+            m_dabStrategy->run(m_dabData);
+            return;
+        }
+
+        KisLatencyTracer *tracer = KisLatencyTracer::instance();
+        const KisLatencyTracer::TraceIds ids({m_traceId});
+
+        const qint64 startTime = KisLatencyTracer::now();
+        tracer->addEvent(KisLatencyTracer::StrokeQueue, ids, m_traceStartTime, startTime);
+
+        {
+            // the updates requested by the job will inherit its trace id
+            KisLatencyTracer::ScopedCurrentTraces currentTraces(ids);
+            m_dabStrategy->run(m_dabData);
+        }
+
+        tracer->addEvent(KisLatencyTracer::StrokeJob, ids, startTime, KisLatencyTracer::now());
     }
 
     KisStrokeJobData::Sequentiality sequentiality() const {
@@ -98,6 +118,9 @@ private:
 
     int m_levelOfDetail;
     bool m_isOwnJob;
+
+    quint64 m_traceId;
+    qint64 m_traceStartTime;
 };
 
 #endif /* __KIS_STROKE_JOB_H */
@@ -115,10 +115,28 @@ public:
         KIS_SAFE_ASSERT_RECOVER_RETURN(m_walker);
         // dbgKrita << "Executing merge job" << m_walker->changeRect()
         //          << "on thread" << QThread::currentThreadId();
-        m_merger.startMerge(*m_walker);
+        const KisLatencyTracer::TraceIds &traceIds = m_walker->traceIds();
 
-        QRect changeRect = m_walker->changeRect();
-        m_updaterContext->continueUpdate(changeRect);
+        if (traceIds.isEmpty()) {
+            m_merger.startMerge(*m_walker);
+
+            QRect changeRect = m_walker->changeRect();
+            m_updaterContext->continueUpdate(changeRect);
+        } else {
+            KisLatencyTracer *tracer = KisLatencyTracer::instance();
+
+            const qint64 startTime = KisLatencyTracer::now();
+            tracer->addEvent(KisLatencyTracer::UpdateQueue, traceIds, m_walker->traceRequestTime(), startTime);
+
+            m_merger.startMerge(*m_walker);
+            tracer->addEvent(KisLatencyTracer::Merge, traceIds, startTime, KisLatencyTracer::now());
+
+            // the canvas will take the ids when receiving the update
+            KisLatencyTracer::ScopedCurrentTraces currentTraces(traceIds);
+
+            QRect changeRect = m_walker->changeRect();
+            m_updaterContext->continueUpdate(changeRect);
+        }
     }
 
     // return true if the thread should actually be started
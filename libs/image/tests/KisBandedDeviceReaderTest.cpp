@@ -0,0 +1,130 @@
+/*
+ *  Copyright (c) 2020 Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "KisBandedDeviceReaderTest.h"
+
+#include <QTest>
+
+#include <KoColor.h>
+#include <KoColorSpace.h>
+#include <KoColorSpaceRegistry.h>
+
+#include "kis_paint_device.h"
+#include "kis_painter.h"
+#include "KisBandedDeviceReader.h"
+#include "testutil.h"
+
+namespace {
+
+KisPaintDeviceSP createTestDevice()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+
+    const QRect rc(0, 0, 400, 300);
+    QByteArray data(rc.width() * rc.height() * cs->pixelSize(), 0);
+    quint8 *ptr = reinterpret_cast<quint8*>(data.data());
+
+    for (int y = 0; y < rc.height(); y++) {
+        for (int x = 0; x < rc.width(); x++) {
+            ptr[0] = x & 0xff;
+            ptr[1] = y & 0xff;
+            ptr[2] = (x + y) & 0xff;
+            ptr[3] = (x * y) & 0xff;
+            ptr += cs->pixelSize();
+        }
+    }
+
+    dev->writeBytes(reinterpret_cast<const quint8*>(data.constData()), rc);
+    return dev;
+}
+
+/**
+ * Streams all the bands of \p reader and compares them with
+ * the same rect of \p reference
+ */
+void compareWithReference(KisBandedDeviceReader &reader, KisPaintDeviceSP reference)
+{
+    const QRect rc = reader.rect();
+    const int rowSize = rc.width() * reference->pixelSize();
+
+    QCOMPARE(reader.colorSpace()->id(), reference->colorSpace()->id());
+
+    QByteArray expectedRow(rowSize, 0);
+    int numRows = 0;
+
+    while (reader.nextBand()) {
+        QVERIFY(reader.bandTop() <= reader.bandBottom());
+
+        for (int y = reader.bandTop(); y <= reader.bandBottom(); y++) {
+            QCOMPARE(y, rc.top() + numRows);
+
+            reference->readBytes(reinterpret_cast<quint8*>(expectedRow.data()), rc.x(), y, rc.width(), 1);
+            QVERIFY(!memcmp(reader.row(y), expectedRow.constData(), rowSize));
+
+            numRows++;
+        }
+    }
+
+    QCOMPARE(numRows, rc.height());
+    QVERIFY(!reader.nextBand());
+}
+
+}
+
+void KisBandedDeviceReaderTest::testRead()
+{
+    KisPaintDeviceSP dev = createTestDevice();
+
+    // the rect is not aligned to the tiles on purpose
+    KisBandedDeviceReader reader(dev, QRect(13, 7, 350, 270));
+    compareWithReference(reader, dev);
+}
+
+void KisBandedDeviceReaderTest::testConversion()
+{
+    KisPaintDeviceSP dev = createTestDevice();
+
+    const KoColorSpace *dstCS = KoColorSpaceRegistry::instance()->rgb16();
+
+    KisPaintDeviceSP reference = new KisPaintDevice(*dev);
+    reference->convertTo(dstCS);
+
+    KisBandedDeviceReader reader(dev, QRect(0, 0, 400, 300), dstCS);
+    compareWithReference(reader, reference);
+}
+
+void KisBandedDeviceReaderTest::testFillColor()
+{
+    KisPaintDeviceSP dev = createTestDevice();
+    const QRect rc(0, 0, 400, 300);
+
+    const KoColor fillColor(Qt::white, dev->colorSpace());
+
+    KisPaintDeviceSP reference = new KisPaintDevice(dev->colorSpace());
+    reference->fill(rc, fillColor);
+    KisPainter gc(reference);
+    gc.bitBlt(rc.topLeft(), dev, rc);
+    gc.end();
+
+    KisBandedDeviceReader reader(dev, rc);
+    reader.setFillColor(fillColor);
+    compareWithReference(reader, reference);
+}
+
+KISTEST_MAIN(KisBandedDeviceReaderTest)
@@ -21,6 +21,7 @@
 #include <QTest>
 
 #include "kis_onion_skin_compositor.h"
+#include "kis_onion_skin_cache.h"
 #include "kis_paint_device.h"
 #include "kis_raster_keyframe_channel.h"
 #include "kis_image_animation_interface.h"
@@ -158,4 +159,79 @@ void KisOnionSkinCompositorTest::testSettings()
     QVERIFY(chk.checkDevice(compositeDevice, p.image, "02_single_skin_tinted"));
 }
 
+KisPaintDeviceSP referenceSkins(KisPaintDeviceSP paintDevice)
+{
+    KisOnionSkinCompositor *compositor = KisOnionSkinCompositor::instance();
+
+    KisPaintDeviceSP dev = new KisPaintDevice(paintDevice->colorSpace());
+    compositor->composite(paintDevice, dev, compositor->calculateExtent(paintDevice));
+    return dev;
+}
+
+void KisOnionSkinCompositorTest::testCacheIncrementalUpdates()
+{
+    KisOnionSkinCompositor *compositor = KisOnionSkinCompositor::instance();
+
+    KisImageConfig config(false);
+    config.setOnionSkinTintFactor(64);
+    config.setOnionSkinTintColorBackward(Qt::blue);
+    config.setOnionSkinTintColorForward(Qt::red);
+    config.setNumberOfOnionSkins(2);
+    config.setOnionSkinOpacity(-2, 64);
+    config.setOnionSkinOpacity(-1, 128);
+    config.setOnionSkinOpacity(1, 128);
+    config.setOnionSkinOpacity(2, 64);
+    compositor->configChanged();
+
+    TestUtil::MaskParent p;
+    KisImageAnimationInterface *i = p.image->animationInterface();
+    KisPaintDeviceSP paintDevice = p.layer->paintDevice();
+    paintDevice->createKeyframeChannel(KoID());
+    KisKeyframeChannel *keyframes = paintDevice->keyframeChannel();
+
+    const QList<QColor> colors = {Qt::red, Qt::green, Qt::blue, Qt::yellow, Qt::cyan};
+
+    for (int time = 0; time < colors.size(); time++) {
+        keyframes->addKeyframe(time);
+
+        i->switchCurrentTimeAsync(time);
+        p.image->waitForDone();
+
+        paintDevice->fill(QRect(time * 50, 0, 200, 200), KoColor(colors[time], paintDevice->colorSpace()));
+    }
+
+    KisOnionSkinCache cache;
+
+    // scrubbing reuses the tinted frames of the previous pass
+    for (int time = 0; time < colors.size(); time++) {
+        i->switchCurrentTimeAsync(time);
+        p.image->waitForDone();
+
+        QVERIFY(TestUtil::comparePaintDevicesClever<quint8>(cache.projection(paintDevice), referenceSkins(paintDevice)));
+    }
+
+    i->switchCurrentTimeAsync(2);
+    p.image->waitForDone();
+    QVERIFY(TestUtil::comparePaintDevicesClever<quint8>(cache.projection(paintDevice), referenceSkins(paintDevice)));
+
+    // a part of the cached frame is changed while the frame is active
+    i->switchCurrentTimeAsync(1);
+    p.image->waitForDone();
+    paintDevice->fill(QRect(300, 300, 30, 30), KoColor(Qt::magenta, paintDevice->colorSpace()));
+
+    i->switchCurrentTimeAsync(2);
+    p.image->waitForDone();
+    QVERIFY(TestUtil::comparePaintDevicesClever<quint8>(cache.projection(paintDevice), referenceSkins(paintDevice)));
+
+    // the opacity is changed, the tint is the same
+    config.setOnionSkinOpacity(-1, 192);
+    compositor->configChanged();
+    QVERIFY(TestUtil::comparePaintDevicesClever<quint8>(cache.projection(paintDevice), referenceSkins(paintDevice)));
+
+    // the tint is changed, all the frames should be tinted again
+    config.setOnionSkinTintColorBackward(Qt::green);
+    compositor->configChanged();
+    QVERIFY(TestUtil::comparePaintDevicesClever<quint8>(cache.projection(paintDevice), referenceSkins(paintDevice)));
+}
+
 QTEST_MAIN(KisOnionSkinCompositorTest)
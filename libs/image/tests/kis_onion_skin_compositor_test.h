@@ -29,6 +29,7 @@ private Q_SLOTS:
 
     void testComposite();
     void testSettings();
+    void testCacheIncrementalUpdates();
 };
 
 #endif
@@ -621,6 +621,78 @@ void KisPainterTest::testMassiveBltFixedCornerCases()
     QVERIFY(dst->extent().isEmpty());
 }
 
+void KisPainterTest::testBltFixedWithMirroring()
+{
+    const KoColorSpace* cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisPaintDeviceSP refDev = new KisPaintDevice(cs);
+    KisPaintDeviceSP batchDev = new KisPaintDevice(cs);
+
+    QList<QColor> colors;
+    colors << Qt::red;
+    colors << Qt::green;
+    colors << Qt::blue;
+
+    QList<KisRenderedDab> dabs;
+
+    // overlapping dabs crossing the tile borders, but not the mirroring axes
+    for (int i = 0; i < 20; i++) {
+        const QRect rc(10 + i * 7, 20 + i * 5, 30, 30);
+
+        KisFixedPaintDeviceSP dev = new KisFixedPaintDevice(cs);
+        dev->setRect(QRect(QPoint(), rc.size()));
+        dev->initialize();
+        dev->fill(dev->bounds(), KoColor(colors[i % 3], cs));
+        dev->fill(kisGrowRect(dev->bounds(), -5), KoColor(Qt::white, cs));
+
+        KisRenderedDab dab(dev);
+        dab.offset = rc.topLeft();
+        dab.opacity = qreal(10 * (i + 1)) / 255.0;
+
+        dabs << dab;
+    }
+
+    const QPointF axesCenter(300, 300);
+
+    {
+        KisPainter painter(refDev);
+        painter.setMirrorInformation(axesCenter, true, true);
+
+        Q_FOREACH (const KisRenderedDab &dab, dabs) {
+            KisFixedPaintDeviceSP dev = new KisFixedPaintDevice(*dab.device);
+
+            painter.setOpacity(quint8(qRound(dab.opacity * 255.0)));
+            painter.bltFixed(dab.offset, dev, dev->bounds());
+            painter.renderMirrorMaskSafe(dab.realBounds(), dev, true);
+        }
+        painter.end();
+    }
+
+    {
+        KisPainter painter(batchDev);
+        painter.setMirrorInformation(axesCenter, true, true);
+
+        QList<KisRenderedDab> batch;
+        Q_FOREACH (const KisRenderedDab &dab, dabs) {
+            KisRenderedDab newDab = dab;
+            newDab.device = new KisFixedPaintDevice(*dab.device);
+            batch << newDab;
+        }
+
+        painter.bltFixedWithMirroring(batch);
+
+        QRect dirtyRect;
+        Q_FOREACH (const QRect &rc, painter.takeDirtyRegion()) {
+            dirtyRect |= rc;
+        }
+        QCOMPARE(dirtyRect, refDev->exactBounds());
+
+        painter.end();
+    }
+
+    QPoint errorPoint;
+    QVERIFY(TestUtil::comparePaintDevices(errorPoint, refDev, batchDev));
+}
+
 
 #include "kis_lod_transform.h"
 
@@ -275,6 +275,28 @@ bool KisTileDataStore::trySwapTileData(KisTileData *td)
     return result;
 }
 
+bool KisTileDataStore::trySwapTileDataCompressed(KisTileData *td, const QByteArray &blob, const quint8 *defaultPixel)
+{
+    bool result = false;
+
+    m_iteratorLock.lockForRead();
+    td->m_swapLock.lockForWrite();
+
+    if (td->data()) {
+        unregisterTileDataImp(td);
+        if (m_swappedStore.tryStoreCompressedTileData(td, (const quint8*)blob.constData(), blob.size(), defaultPixel)) {
+            result = true;
+        } else {
+            registerTileDataImp(td);
+        }
+    }
+
+    td->m_swapLock.unlock();
+    m_iteratorLock.unlock();
+
+    return result;
+}
+
 KisTileDataStoreIterator* KisTileDataStore::beginIteration()
 {
     m_iteratorLock.lockForWrite();
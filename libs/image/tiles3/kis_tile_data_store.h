@@ -118,6 +118,15 @@ public:
      */
     bool trySwapTileData(KisTileData *td);
 
+    /**
+     * Swap out the tile data, replacing its content with \a blob,
+     * which is already compressed by KisTileCompressor2. The data
+     * will be decompressed on the first access to the tile. If the
+     * decompression fails, the tile is filled with \a defaultPixel.
+     * PRECONDITIONS: the tile data is not shared with anyone else
+     */
+    bool trySwapTileDataCompressed(KisTileData *td, const QByteArray &blob, const quint8 *defaultPixel);
+
 
     /**
      * WARN: The following three method are only for usage
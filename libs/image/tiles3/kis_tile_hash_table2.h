@@ -19,6 +19,10 @@
 #ifndef KIS_TILEHASHTABLE_2_H
 #define KIS_TILEHASHTABLE_2_H
 
+#include <QMutex>
+#include <QPoint>
+#include <QVector>
+
 #include "kis_shared.h"
 #include "kis_shared_ptr.h"
 #include "3rdparty/lock_free_map/concurrent_map.h"
@@ -60,6 +64,7 @@ public:
 
     bool isEmpty()
     {
+        ensureTilesCreated();
         return !m_numTiles.load();
     }
 
@@ -105,15 +110,49 @@ public:
 
     qint32 numTiles()
     {
+        ensureTilesCreated();
         return m_numTiles.load();
     }
 
+    /**
+     * Returns positions of all the tiles in the table. Unlike
+     * iterating through the table, it doesn't create the tiles
+     * pending after copying of the table.
+     */
+    QVector<QPoint> tileIndexes();
+
+    /**
+     * The copy constructor doesn't create the tiles, it only
+     * acquires the tile data of the source table, which pins
+     * their current versions the same way the tiles would do.
+     * The tiles are created on the first access to the table.
+     *
+     * The tiles should be created before starting a transaction
+     * in the memento manager, otherwise they would be registered
+     * as a part of this transaction.
+     */
+    inline void ensureTilesCreated()
+    {
+        if (m_hasPendingTiles.loadAcquire()) {
+            createPendingTiles();
+        }
+    }
+
     void debugPrintInfo();
     void debugMaxListLength(qint32 &min, qint32 &max);
 
     friend class KisTileHashTableIteratorTraits2<T>;
 
 private:
+    struct PendingTile {
+        qint32 col;
+        qint32 row;
+        KisTileData *tileData;
+    };
+
+    void createPendingTiles();
+    void dropPendingTiles();
+
     struct MemoryReclaimer {
         MemoryReclaimer(TileType *data) : d(data) {}
 
@@ -200,6 +239,10 @@ private:
     QAtomicInt m_numTiles;
     KisTileData *m_defaultTileData;
     KisMementoManager *m_mementoManager;
+
+    QVector<PendingTile> m_pendingTiles;
+    QAtomicInt m_hasPendingTiles;
+    mutable QMutex m_pendingTilesLock;
 };
 
 template <class T>
@@ -212,6 +255,7 @@ public:
 
     KisTileHashTableIteratorTraits2(KisTileHashTableTraits2<T> *ht) : m_ht(ht)
     {
+        m_ht->ensureTilesCreated();
         m_ht->m_iteratorLock.lockForWrite();
         m_iter.setMap(m_ht->m_map);
     }
@@ -249,6 +293,7 @@ public:
 
         quint32 idx = m_ht->calculateHash(tile->col(), tile->row());
         m_ht->erase(idx);
+        newHashTable->ensureTilesCreated();
         newHashTable->insert(idx, tile);
     }
 
@@ -259,7 +304,7 @@ private:
 
 template <class T>
 KisTileHashTableTraits2<T>::KisTileHashTableTraits2(KisMementoManager *mm)
-    : m_numTiles(0), m_defaultTileData(0), m_mementoManager(mm)
+    : m_numTiles(0), m_defaultTileData(0), m_mementoManager(mm), m_hasPendingTiles(0)
 {
 }
 
@@ -269,23 +314,89 @@ KisTileHashTableTraits2<T>::KisTileHashTableTraits2(const KisTileHashTableTraits
 {
     setDefaultTileData(ht.m_defaultTileData);
 
+    QMutexLocker pendingLocker(&ht.m_pendingTilesLock);
     QWriteLocker locker(&ht.m_iteratorLock);
+
+    m_pendingTiles.reserve(ht.m_pendingTiles.size() + ht.m_numTiles.load());
+
+    Q_FOREACH (const PendingTile &pending, ht.m_pendingTiles) {
+        pending.tileData->acquire();
+        m_pendingTiles.append(pending);
+    }
+
     typename ConcurrentMap<quint32, TileType*>::Iterator iter(ht.m_map);
 
     while (iter.isValid()) {
-        TileTypeSP tile = new TileType(*iter.getValue(), m_mementoManager);
-        insert(iter.getKey(), tile);
+        TileType *tile = iter.getValue();
+        KisTileData *tileData = tile->tileData();
+        tileData->acquire();
+        m_pendingTiles.append({tile->col(), tile->row(), tileData});
         iter.next();
     }
+
+    m_hasPendingTiles.storeRelease(!m_pendingTiles.isEmpty());
 }
 
 template <class T>
 KisTileHashTableTraits2<T>::~KisTileHashTableTraits2()
 {
+    dropPendingTiles();
     clear();
     setDefaultTileData(0);
 }
 
+template <class T>
+void KisTileHashTableTraits2<T>::createPendingTiles()
+{
+    QMutexLocker locker(&m_pendingTilesLock);
+    if (!m_hasPendingTiles.loadAcquire()) return;
+
+    Q_FOREACH (const PendingTile &pending, m_pendingTiles) {
+        TileTypeSP tile = new TileType(pending.col, pending.row, pending.tileData, m_mementoManager);
+        insert(calculateHash(pending.col, pending.row), tile);
+        pending.tileData->release();
+    }
+
+    m_pendingTiles.clear();
+    m_hasPendingTiles.storeRelease(0);
+}
+
+template <class T>
+void KisTileHashTableTraits2<T>::dropPendingTiles()
+{
+    QMutexLocker locker(&m_pendingTilesLock);
+
+    Q_FOREACH (const PendingTile &pending, m_pendingTiles) {
+        pending.tileData->release();
+    }
+
+    m_pendingTiles.clear();
+    m_hasPendingTiles.storeRelease(0);
+}
+
+template <class T>
+QVector<QPoint> KisTileHashTableTraits2<T>::tileIndexes()
+{
+    QVector<QPoint> indexes;
+
+    QMutexLocker pendingLocker(&m_pendingTilesLock);
+    QWriteLocker locker(&m_iteratorLock);
+
+    Q_FOREACH (const PendingTile &pending, m_pendingTiles) {
+        indexes << QPoint(pending.col, pending.row);
+    }
+
+    typename ConcurrentMap<quint32, TileType*>::Iterator iter(m_map);
+
+    while (iter.isValid()) {
+        TileType *tile = iter.getValue();
+        indexes << QPoint(tile->col(), tile->row());
+        iter.next();
+    }
+
+    return indexes;
+}
+
 template<class T>
 bool KisTileHashTableTraits2<T>::tileExists(qint32 col, qint32 row)
 {
@@ -295,6 +406,7 @@ bool KisTileHashTableTraits2<T>::tileExists(qint32 col, qint32 row)
 template <class T>
 typename KisTileHashTableTraits2<T>::TileTypeSP KisTileHashTableTraits2<T>::getExistingTile(qint32 col, qint32 row)
 {
+    ensureTilesCreated();
     quint32 idx = calculateHash(col, row);
 
     m_map.getGC().lockRawPointerAccess();
@@ -308,6 +420,7 @@ typename KisTileHashTableTraits2<T>::TileTypeSP KisTileHashTableTraits2<T>::getE
 template <class T>
 typename KisTileHashTableTraits2<T>::TileTypeSP KisTileHashTableTraits2<T>::getTileLazy(qint32 col, qint32 row, bool &newTile)
 {
+    ensureTilesCreated();
     newTile = false;
     quint32 idx = calculateHash(col, row);
 
@@ -372,6 +485,7 @@ typename KisTileHashTableTraits2<T>::TileTypeSP KisTileHashTableTraits2<T>::getT
 template <class T>
 typename KisTileHashTableTraits2<T>::TileTypeSP KisTileHashTableTraits2<T>::getReadOnlyTileLazy(qint32 col, qint32 row, bool &existingTile)
 {
+    ensureTilesCreated();
     quint32 idx = calculateHash(col, row);
 
     m_map.getGC().lockRawPointerAccess();
@@ -392,6 +506,7 @@ typename KisTileHashTableTraits2<T>::TileTypeSP KisTileHashTableTraits2<T>::getR
 template <class T>
 void KisTileHashTableTraits2<T>::addTile(TileTypeSP tile)
 {
+    ensureTilesCreated();
     quint32 idx = calculateHash(tile->col(), tile->row());
     insert(idx, tile);
 }
@@ -405,6 +520,7 @@ bool KisTileHashTableTraits2<T>::deleteTile(TileTypeSP tile)
 template <class T>
 bool KisTileHashTableTraits2<T>::deleteTile(qint32 col, qint32 row)
 {
+    ensureTilesCreated();
     quint32 idx = calculateHash(col, row);
     return erase(idx);
 }
@@ -412,6 +528,8 @@ bool KisTileHashTableTraits2<T>::deleteTile(qint32 col, qint32 row)
 template<class T>
 void KisTileHashTableTraits2<T>::clear()
 {
+    ensureTilesCreated();
+
     {
         QWriteLocker locker(&m_iteratorLock);
 
@@ -20,18 +20,71 @@
 
 #include <QRect>
 #include <QVector>
+#include <QThread>
+#include <QtConcurrent>
 
 #include "kis_tile.h"
 #include "kis_tiled_data_manager.h"
 #include "kis_tile_data_wrapper.h"
 #include "kis_tiled_data_manager_p.h"
 #include "kis_memento_manager.h"
+#include "kis_tile_data_store.h"
 #include "swap/kis_legacy_tile_compressor.h"
 #include "swap/kis_tile_compressor_factory.h"
+#include "swap/kis_tile_compressor_2.h"
 
 #include "kis_paint_device_writer.h"
 
 #include "kis_global.h"
+#include "kis_image_config.h"
+
+namespace {
+
+/**
+ * Collects the compressed tiles in memory, so that they could be
+ * encoded on a worker thread and written into the store later
+ */
+class KisBufferPaintDeviceWriter : public KisPaintDeviceWriter {
+public:
+    bool write(const QByteArray &data) override {
+        m_buffer.append(data);
+        return true;
+    }
+
+    bool write(const char* data, qint64 length) override {
+        m_buffer.append(data, length);
+        return true;
+    }
+
+    const QByteArray& buffer() const {
+        return m_buffer;
+    }
+
+private:
+    QByteArray m_buffer;
+};
+
+/**
+ * A continuous range of tiles compressed by a single worker thread
+ */
+struct TilesEncodingChunk {
+    QVector<KisTileSP>::const_iterator begin;
+    QVector<KisTileSP>::const_iterator end;
+    KisBufferPaintDeviceWriter writer;
+    bool result = true;
+};
+
+/**
+ * A continuous range of tiles read from the stream, but not yet
+ * decompressed
+ */
+struct TilesDecodingChunk {
+    QVector<KisTileSP> tiles;
+    QVector<QByteArray> blobs;
+    bool result = true;
+};
+
+}
 
 
 /* The data area is divided into tiles each say 64x64 pixels (defined at compiletime)
@@ -121,21 +174,69 @@ bool KisTiledDataManager::write(KisPaintDeviceWriter &store)
     }
 
 
+    QVector<KisTileSP> tiles;
+    tiles.reserve(m_hashTable->numTiles());
+
     KisTileHashTableConstIterator iter(m_hashTable);
     KisTileSP tile;
 
-    KisAbstractTileCompressorSP compressor =
-        KisTileCompressorFactory::create(CURRENT_VERSION);
-
     while ((tile = iter.tile())) {
-        retval = compressor->writeTile(tile, store);
-        if (!retval) {
-            warnFile << "Failed to write tile";
-            break;
-        }
+        tiles.append(tile);
         iter.next();
     }
 
+    /**
+     * The tiles are compressed on the worker threads in batches,
+     * each batch is split into chunks of continuous tiles. When the
+     * batch is ready, the chunks are written into the store in the
+     * original order, so the result is exactly the same as if the
+     * tiles were compressed sequentially. The size of the batch
+     * limits the amount of memory occupied by the compressed data.
+     */
+    const int tilesPerChunk = 16;
+    const int chunksPerBatch = 8 * qMax(1, QThread::idealThreadCount());
+
+    QVector<TilesEncodingChunk> chunks(chunksPerBatch);
+
+    auto batchBegin = tiles.constBegin();
+    while (retval && batchBegin != tiles.constEnd()) {
+        int numChunks = 0;
+
+        while (numChunks < chunksPerBatch && batchBegin != tiles.constEnd()) {
+            TilesEncodingChunk &chunk = chunks[numChunks++];
+
+            chunk.begin = batchBegin;
+            chunk.end = batchBegin + qMin(int(tiles.constEnd() - batchBegin), tilesPerChunk);
+            chunk.writer = KisBufferPaintDeviceWriter();
+            chunk.result = true;
+
+            batchBegin = chunk.end;
+        }
+
+        QtConcurrent::blockingMap(chunks.begin(), chunks.begin() + numChunks,
+            [] (TilesEncodingChunk &chunk) {
+                KisAbstractTileCompressorSP compressor =
+                    KisTileCompressorFactory::create(CURRENT_VERSION);
+
+                for (auto it = chunk.begin; it != chunk.end; ++it) {
+                    if (!compressor->writeTile(*it, chunk.writer)) {
+                        chunk.result = false;
+                        break;
+                    }
+                }
+            });
+
+        for (int i = 0; i < numChunks; i++) {
+            const TilesEncodingChunk &chunk = chunks[i];
+
+            retval = chunk.result && store.write(chunk.writer.buffer());
+            if (!retval) {
+                warnFile << "Failed to write tile";
+                break;
+            }
+        }
+    }
+
     return retval;
 }
 bool KisTiledDataManager::read(QIODevice *stream)
@@ -175,10 +276,95 @@ bool KisTiledDataManager::read(QIODevice *stream)
     KisAbstractTileCompressorSP compressor =
         KisTileCompressorFactory::create(tilesVersion);
 
+    /**
+     * Reading from the stream is serialized, but the tiles are
+     * decompressed on the worker threads in batches, the same
+     * way as they are compressed in write()
+     */
+    const int tilesPerChunk = 16;
+    const int chunksPerBatch = 8 * qMax(1, QThread::idealThreadCount());
+
+    QVector<TilesDecodingChunk> chunks(chunksPerBatch);
+
+    /**
+     * In lazy mode the tiles of the current version are not decompressed
+     * at all. Their compressed data is moved directly into the swap, so
+     * the tiles that are never accessed (e.g. the ones of hidden layers)
+     * do not occupy any memory.
+     */
+    const bool lazyLoading =
+        tilesVersion == 2 && // the format of KisTileCompressor2 used by the swap
+        KisImageConfig(true).lazyTileLoading();
+
     bool readSuccess = true;
-    for (quint32 i = 0; i < numTiles; i++) {
-        if (!compressor->readTile(stream, this)) {
-            readSuccess = false;
+    quint32 tilesRead = 0;
+
+    while (tilesRead < numTiles) {
+        int numChunks = 0;
+
+        while (numChunks < chunksPerBatch && tilesRead < numTiles) {
+            TilesDecodingChunk &chunk = chunks[numChunks++];
+
+            chunk.tiles.clear();
+            chunk.blobs.clear();
+            chunk.result = true;
+
+            for (int i = 0; i < tilesPerChunk && tilesRead < numTiles; i++, tilesRead++) {
+                KisTileSP tile;
+                QByteArray blob;
+
+                if (compressor->readTileBlob(stream, this, tile, blob)) {
+                    chunk.tiles.append(tile);
+                    chunk.blobs.append(blob);
+                } else {
+                    readSuccess = false;
+                }
+            }
+        }
+
+        const quint8 *defaultPixel = this->defaultPixel();
+
+        QtConcurrent::blockingMap(chunks.begin(), chunks.begin() + numChunks,
+            [tilesVersion, lazyLoading, defaultPixel] (TilesDecodingChunk &chunk) {
+                KisAbstractTileCompressorSP compressor =
+                    KisTileCompressorFactory::create(tilesVersion);
+
+                for (int i = 0; i < chunk.tiles.size(); i++) {
+                    KisTileSP tile = chunk.tiles[i];
+                    QByteArray &blob = chunk.blobs[i];
+
+                    if (lazyLoading) {
+                        /**
+                         * The blob is not decompressed now, so at least check
+                         * that it is not broken, like the eager decompression
+                         * would do
+                         */
+                        if (!KisTileCompressor2::isValidTileBlob((const quint8*)blob.constData(), blob.size(),
+                                                                 tile->pixelSize())) {
+                            chunk.result = false;
+                            continue;
+                        }
+
+                        // ensure the tile has its own copy of tile data
+                        tile->lockForWrite();
+                        KisTileData *td = tile->tileData();
+                        tile->unlockForWrite();
+
+                        if (KisTileDataStore::instance()->trySwapTileDataCompressed(td, blob, defaultPixel)) {
+                            continue;
+                        }
+                    }
+
+                    tile->lockForWrite();
+                    if (!compressor->decompressTileData((quint8*)blob.data(), blob.size(), tile->tileData())) {
+                        chunk.result = false;
+                    }
+                    tile->unlockForWrite();
+                }
+            });
+
+        for (int i = 0; i < numChunks; i++) {
+            readSuccess &= chunks[i].result;
         }
     }
 
@@ -641,19 +827,7 @@ void KisTiledDataManager::setExtent(QRect newRect)
 
 void KisTiledDataManager::recalculateExtent()
 {
-    QVector<QPoint> indexes;
-
-    {
-        KisTileHashTableConstIterator iter(m_hashTable);
-        KisTileSP tile;
-
-        while ((tile = iter.tile())) {
-            indexes << QPoint(tile->col(), tile->row());
-            iter.next();
-        }
-    }
-
-    m_extentManager.replaceTileStats(indexes);
+    m_extentManager.replaceTileStats(m_hashTable->tileIndexes());
 }
 
 void KisTiledDataManager::extent(qint32 &x, qint32 &y, qint32 &w, qint32 &h) const
@@ -145,6 +145,10 @@ public:
 
     KisMementoSP getMemento() {
         QWriteLocker locker(&m_lock);
+
+        // the tiles of a copied device must not get into the transaction
+        m_hashTable->ensureTilesCreated();
+
         KisMementoSP memento = m_mementoManager->getMemento();
         memento->saveOldDefaultPixel(m_defaultPixel, m_pixelSize);
         return memento;
@@ -55,6 +55,17 @@ public:
      */
     virtual bool readTile(QIODevice *stream, KisTiledDataManager *dm) = 0;
 
+    /**
+     * Reads the header and the still compressed data of the next tile
+     * from the \a stream. The \p tile is created in \p dm, but its
+     * data is left untouched. The data should be unpacked later with
+     * decompressTileData(), which can be done on a different thread.
+     *
+     * \see readTile()
+     */
+    virtual bool readTileBlob(QIODevice *stream, KisTiledDataManager *dm,
+                              KisTileSP &tile, QByteArray &blob) = 0;
+
     /**
      * Compresses a \p tileData and writes it into the \p buffer.
      * The buffer must be at least tileDataBufferSize() bytes long.
@@ -53,28 +53,41 @@ bool KisLegacyTileCompressor::writeTile(KisTileSP tile, KisPaintDeviceWriter &st
 }
 
 bool KisLegacyTileCompressor::readTile(QIODevice *stream, KisTiledDataManager *dm)
+{
+    KisTileSP tile;
+    QByteArray blob;
+
+    if (!readTileBlob(stream, dm, tile, blob)) {
+        return false;
+    }
+
+    tile->lockForWrite();
+    bool res = decompressTileData((quint8*)blob.data(), blob.size(), tile->tileData());
+    tile->unlockForWrite();
+    return res;
+}
+
+bool KisLegacyTileCompressor::readTileBlob(QIODevice *stream, KisTiledDataManager *dm,
+                                           KisTileSP &tile, QByteArray &blob)
 {
     const qint32 tileDataSize = TILE_DATA_SIZE(pixelSize(dm));
 
     const qint32 bufferSize = maxHeaderLength() + 1;
-    quint8 *headerBuffer = new quint8[bufferSize];
+    QByteArray headerBuffer(bufferSize, '\0');
 
     qint32 x, y;
     qint32 width, height;
 
-    stream->readLine((char *)headerBuffer, bufferSize);
-    sscanf((char *) headerBuffer, "%d,%d,%d,%d", &x, &y, &width, &height);
+    stream->readLine(headerBuffer.data(), bufferSize);
+    sscanf(headerBuffer.constData(), "%d,%d,%d,%d", &x, &y, &width, &height);
 
     qint32 row = yToRow(dm, y);
     qint32 col = xToCol(dm, x);
 
-    KisTileSP tile = dm->getTile(col, row, true);
-
-    tile->lockForWrite();
-    stream->read((char *)tile->data(), tileDataSize);
-    tile->unlockForWrite();
+    tile = dm->getTile(col, row, true);
+    blob = stream->read(tileDataSize);
 
-    return true;
+    return blob.size() == tileDataSize;
 }
 
 void KisLegacyTileCompressor::compressTileData(KisTileData *tileData,
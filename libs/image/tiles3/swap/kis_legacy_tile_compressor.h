@@ -29,6 +29,8 @@ public:
     ~KisLegacyTileCompressor() override;
 
     bool writeTile(KisTileSP tile, KisPaintDeviceWriter &store) override;
+    bool readTileBlob(QIODevice *stream, KisTiledDataManager *dm,
+                      KisTileSP &tile, QByteArray &blob) override;
     bool readTile(QIODevice *stream, KisTiledDataManager *dm) override;
 
 
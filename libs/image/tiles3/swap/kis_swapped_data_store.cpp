@@ -26,13 +26,15 @@
 //#define COMPRESSOR_VERSION 2
 
 KisSwappedDataStore::KisSwappedDataStore()
-    : m_memoryMetric(0)
+    : m_memoryMetric(0),
+      m_swappedBytes(0)
 {
     KisImageConfig config(true);
     const quint64 maxSwapSize = config.maxSwapSize() * MiB;
     const quint64 swapSlabSize = config.swapSlabSize() * MiB;
     const quint64 swapWindowSize = config.swapWindowSize() * MiB;
 
+    m_maxSwapSize = maxSwapSize;
     m_allocator = new KisChunkAllocator(swapSlabSize, maxSwapSize);
     m_swapSpace = new KisMemoryWindow(config.swapDir(), swapWindowSize);
 
@@ -73,18 +75,43 @@ bool KisSwappedDataStore::trySwapOutTileData(KisTileData *td)
     qint32 bytesWritten;
     m_compressor->compressTileData(td, (quint8*) m_buffer.data(), m_buffer.size(), bytesWritten);
 
-    KisChunk chunk = m_allocator->getChunk(bytesWritten);
+    return storeChunkImp(td, (const quint8*) m_buffer.data(), bytesWritten);
+}
+
+bool KisSwappedDataStore::tryStoreCompressedTileData(KisTileData *td, const quint8 *data, qint32 size,
+                                                     const quint8 *defaultPixel)
+{
+    Q_ASSERT(td->data());
+    QMutexLocker locker(&m_lock);
+
+    if (size <= 0 || m_swappedBytes + size > m_maxSwapSize / 2) {
+        return false;
+    }
+
+    if (!storeChunkImp(td, data, size)) {
+        return false;
+    }
+
+    m_compressedTilesDefaultPixels.insert(td, QByteArray((const char*)defaultPixel, td->pixelSize()));
+    return true;
+}
+
+bool KisSwappedDataStore::storeChunkImp(KisTileData *td, const quint8 *data, qint32 size)
+{
+    KisChunk chunk = m_allocator->getChunk(size);
     quint8 *ptr = m_swapSpace->getWriteChunkPtr(chunk);
     if (!ptr) {
         qWarning() << "swap out of tile failed";
+        m_allocator->freeChunk(chunk);
         return false;
     }
-    memcpy(ptr, m_buffer.data(), bytesWritten);
+    memcpy(ptr, data, size);
 
     td->releaseMemory();
     td->setSwapChunk(chunk);
 
     m_memoryMetric += td->pixelSize();
+    m_swappedBytes += size;
 
     return true;
 }
@@ -103,8 +130,25 @@ void KisSwappedDataStore::swapInTileData(KisTileData *td)
 
     quint8 *ptr = m_swapSpace->getReadChunkPtr(chunk);
     Q_ASSERT(ptr);
-    m_compressor->decompressTileData(ptr, chunk.size(), td);
+
+    QByteArray defaultPixel = m_compressedTilesDefaultPixels.take(td);
+
+    /**
+     * The data stored by tryStoreCompressedTileData() comes from a
+     * file and is only roughly checked when loading. Don't let a
+     * corrupted tile leave garbage in the image.
+     */
+    if (!m_compressor->decompressTileData(ptr, chunk.size(), td)) {
+        qWarning() << "Failed to decompress the tile data, the tile is filled with the default pixel";
+
+        if (defaultPixel.isEmpty()) {
+            defaultPixel.fill(0, td->pixelSize());
+        }
+        td->fillWithPixel((const quint8*)defaultPixel.constData());
+    }
+
     m_allocator->freeChunk(chunk);
+    m_swappedBytes -= chunk.size();
 
     m_memoryMetric -= td->pixelSize();
 }
@@ -113,8 +157,10 @@ void KisSwappedDataStore::forgetTileData(KisTileData *td)
 {
     QMutexLocker locker(&m_lock);
 
+    m_swappedBytes -= td->swapChunk().size();
     m_allocator->freeChunk(td->swapChunk());
     td->setSwapChunk(KisChunk());
+    m_compressedTilesDefaultPixels.remove(td);
 
     m_memoryMetric -= td->pixelSize();
 }
@@ -23,6 +23,7 @@
 
 #include <QMutex>
 #include <QByteArray>
+#include <QHash>
 
 
 class QMutex;
@@ -50,6 +51,26 @@ public:
      */
     bool trySwapOutTileData(KisTileData *td);
 
+    /**
+     * Put the data of the \a td into the swap file without
+     * compressing it. \a data should already be compressed in the
+     * format of KisTileCompressor2, e.g. be read directly from a
+     * .kra file. The memory occupied by td->data() is freed, the
+     * data will be decompressed on the first access.
+     *
+     * The store refuses the data if it would take more than a half
+     * of the maximum swap size, so that the usual swapping would
+     * still have some space to work with.
+     *
+     * \a defaultPixel is used to fill the tile if \a data turns out
+     * to be corrupted when it is decompressed.
+     *
+     * LOCKING: the lock on the tile data should be taken
+     *          by the caller before making a call.
+     */
+    bool tryStoreCompressedTileData(KisTileData *td, const quint8 *data, qint32 size,
+                                    const quint8 *defaultPixel);
+
     /**
      * Restore the data of a \a td basing on information
      * stored in the swap file.
@@ -76,6 +97,9 @@ public:
      */
     void debugStatistics();
 
+private:
+    bool storeChunkImp(KisTileData *td, const quint8 *data, qint32 size);
+
 private:
     QByteArray m_buffer;
     KisAbstractTileCompressor *m_compressor;
@@ -86,6 +110,15 @@ private:
     QMutex m_lock;
 
     qint64 m_memoryMetric;
+
+    quint64 m_maxSwapSize;
+    quint64 m_swappedBytes;
+
+    /**
+     * The default pixels of the tiles stored with
+     * tryStoreCompressedTileData() and not swapped in yet
+     */
+    QHash<KisTileData*, QByteArray> m_compressedTilesDefaultPixels;
 };
 
 #endif /* __KIS_SWAPPED_DATA_STORE_H */
@@ -62,9 +62,22 @@ bool KisTileCompressor2::writeTile(KisTileSP tile, KisPaintDeviceWriter &store)
 
 bool KisTileCompressor2::readTile(QIODevice *stream, KisTiledDataManager *dm)
 {
-    const qint32 tileDataSize = TILE_DATA_SIZE(pixelSize(dm));
-    prepareStreamingBuffer(tileDataSize);
+    KisTileSP tile;
+    QByteArray blob;
+
+    if (!readTileBlob(stream, dm, tile, blob)) {
+        return false;
+    }
+
+    tile->lockForWrite();
+    bool res = decompressTileData((quint8*)blob.data(), blob.size(), tile->tileData());
+    tile->unlockForWrite();
+    return res;
+}
 
+bool KisTileCompressor2::readTileBlob(QIODevice *stream, KisTiledDataManager *dm,
+                                      KisTileSP &tile, QByteArray &blob)
+{
     QByteArray header = stream->readLine(maxHeaderLength());
 
     QList<QByteArray> headerItems = header.trimmed().split(',');
@@ -80,14 +93,10 @@ bool KisTileCompressor2::readTile(QIODevice *stream, KisTiledDataManager *dm)
         qint32 row = yToRow(dm, y);
         qint32 col = xToCol(dm, x);
 
-        KisTileSP tile = dm->getTile(col, row, true);
-
-        stream->read(m_streamingBuffer.data(), dataSize);
+        tile = dm->getTile(col, row, true);
+        blob = stream->read(dataSize);
 
-        tile->lockForWrite();
-        bool res = decompressTileData((quint8*)m_streamingBuffer.data(), dataSize, tile->tileData());
-        tile->unlockForWrite();
-        return res;
+        return dataSize > 0 && blob.size() == dataSize;
     }
     return false;
 }
@@ -170,6 +179,29 @@ bool KisTileCompressor2::decompressTileData(quint8 *buffer,
 
 }
 
+bool KisTileCompressor2::isValidTileBlob(const quint8 *buffer, qint32 bufferSize, qint32 pixelSize)
+{
+    const qint32 tileDataSize = TILE_DATA_SIZE(pixelSize);
+
+    if (bufferSize < 2) return false;
+
+    if (buffer[0] == RAW_DATA_FLAG) {
+        return bufferSize == tileDataSize + 1;
+    }
+
+    if (buffer[0] != COMPRESSED_DATA_FLAG) return false;
+
+    // the compressed data is saved only when it is smaller than the raw one
+    if (bufferSize > tileDataSize) return false;
+
+    /**
+     * There is nothing to reference in the beginning of the
+     * stream, so LZF always starts it with a literal run
+     */
+    const qint32 literalLength = qint32(buffer[1]) + 1;
+    return literalLength <= 32 && 2 + literalLength <= bufferSize;
+}
+
 qint32 KisTileCompressor2::tileDataBufferSize(KisTileData *tileData)
 {
     return TILE_DATA_SIZE(tileData->pixelSize()) + 1;
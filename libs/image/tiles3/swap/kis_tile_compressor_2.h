@@ -30,6 +30,8 @@ public:
     ~KisTileCompressor2() override;
 
     bool writeTile(KisTileSP tile, KisPaintDeviceWriter &store) override;
+    bool readTileBlob(QIODevice *stream, KisTiledDataManager *dm,
+                      KisTileSP &tile, QByteArray &blob) override;
     bool readTile(QIODevice *io, KisTiledDataManager *dm) override;
 
 
@@ -38,6 +40,13 @@ public:
     bool decompressTileData(quint8 *buffer, qint32 bufferSize, KisTileData *tileData) override;
     qint32 tileDataBufferSize(KisTileData *tileData) override;
 
+    /**
+     * Checks if \p buffer looks like a valid compressed tile with
+     * \p pixelSize without decompressing it: checks the flag byte,
+     * the size of the buffer and the first token of the LZF stream
+     */
+    static bool isValidTileBlob(const quint8 *buffer, qint32 bufferSize, qint32 pixelSize);
+
 private:
     /**
      * Quite self describing
@@ -18,8 +18,12 @@
 
 #include "kis_tiled_data_manager_test.h"
 #include <QTest>
+#include <QBuffer>
 
 #include "tiles3/kis_tiled_data_manager.h"
+#include "kis_paint_device_writer.h"
+#include "tiles3/kis_tile_data_store.h"
+#include "kis_image_config.h"
 
 #include "tiles_test_utils.h"
 #include "config-limit-long-tests.h"
@@ -542,6 +546,179 @@ void KisTiledDataManagerTest::testUndoSetDefaultPixel()
 
 //#include <valgrind/callgrind.h>
 
+class TestBufferWriter : public KisPaintDeviceWriter {
+public:
+    TestBufferWriter(QIODevice *device) : m_device(device) {}
+
+    bool write(const QByteArray &data) override {
+        return m_device->write(data) == data.size();
+    }
+
+    bool write(const char* data, qint64 length) override {
+        return m_device->write(data, length) == length;
+    }
+
+private:
+    QIODevice *m_device;
+};
+
+void KisTiledDataManagerTest::testWriteReadManyTiles()
+{
+    /**
+     * The tiles are compressed in parallel batches, so use more
+     * tiles than a single batch can hold and check that the order
+     * of the tiles survives the round trip
+     */
+    quint8 defaultPixel = 0;
+    KisTiledDataManager srcDM(1, &defaultPixel);
+
+    const QRect rect(-100, -100, 64 * 64, 64 * 48);
+
+    QVector<quint8> srcBytes(rect.width() * rect.height());
+    for (int i = 0; i < srcBytes.size(); i++) {
+        srcBytes[i] = (i * 7 + i / rect.width()) % 251;
+    }
+    srcDM.writeBytes(srcBytes.constData(), rect.x(), rect.y(), rect.width(), rect.height());
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    TestBufferWriter writer(&buffer);
+    QVERIFY(srcDM.write(writer));
+    buffer.close();
+
+    buffer.open(QIODevice::ReadOnly);
+    KisTiledDataManager dstDM(1, &defaultPixel);
+    QVERIFY(dstDM.read(&buffer));
+
+    QVector<quint8> dstBytes(srcBytes.size());
+    dstDM.readBytes(dstBytes.data(), rect.x(), rect.y(), rect.width(), rect.height());
+
+    QCOMPARE(dstDM.extent(), srcDM.extent());
+    QVERIFY(dstBytes == srcBytes);
+}
+
+void KisTiledDataManagerTest::testLazyRead()
+{
+    quint8 defaultPixel = 0;
+    KisTiledDataManager srcDM(1, &defaultPixel);
+
+    const QRect rect(0, 0, 64 * 16, 64 * 16);
+
+    QVector<quint8> srcBytes(rect.width() * rect.height());
+    for (int i = 0; i < srcBytes.size(); i++) {
+        srcBytes[i] = (i * 13 + i / rect.width()) % 251;
+    }
+    srcDM.writeBytes(srcBytes.constData(), rect.x(), rect.y(), rect.width(), rect.height());
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    TestBufferWriter writer(&buffer);
+    QVERIFY(srcDM.write(writer));
+    buffer.close();
+
+    const bool oldLazyTileLoading = KisImageConfig(true).lazyTileLoading();
+    KisImageConfig(false).setLazyTileLoading(true);
+
+    KisTileDataStore *store = KisTileDataStore::instance();
+    const qint32 tilesInMemory = store->numTilesInMemory();
+
+    buffer.open(QIODevice::ReadOnly);
+    KisTiledDataManager dstDM(1, &defaultPixel);
+    QVERIFY(dstDM.read(&buffer));
+
+    KisImageConfig(false).setLazyTileLoading(oldLazyTileLoading);
+
+    // the loaded tiles stay in the swap until they are accessed
+    QCOMPARE(store->numTilesInMemory(), tilesInMemory);
+    QCOMPARE(dstDM.extent(), srcDM.extent());
+
+    QVector<quint8> dstBytes(srcBytes.size());
+    dstDM.readBytes(dstBytes.data(), rect.x(), rect.y(), rect.width(), rect.height());
+
+    QCOMPARE(store->numTilesInMemory(), tilesInMemory + 16 * 16);
+    QVERIFY(dstBytes == srcBytes);
+}
+
+void KisTiledDataManagerTest::testLazyReadCorrupted()
+{
+    quint8 defaultPixel = 0;
+    KisTiledDataManager srcDM(1, &defaultPixel);
+
+    const QRect rect(0, 0, 64 * 4, 64 * 4);
+
+    QVector<quint8> srcBytes(rect.width() * rect.height());
+    for (int i = 0; i < srcBytes.size(); i++) {
+        srcBytes[i] = (i * 13 + i / rect.width()) % 251;
+    }
+    srcDM.writeBytes(srcBytes.constData(), rect.x(), rect.y(), rect.width(), rect.height());
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    TestBufferWriter writer(&buffer);
+    QVERIFY(srcDM.write(writer));
+    buffer.close();
+
+    // break the flag byte of the first tile
+    QByteArray data = buffer.data();
+    const int headerEnd = data.indexOf('\n', data.indexOf(",LZF,"));
+    QVERIFY(headerEnd > 0);
+    data[headerEnd + 1] = 0x7;
+
+    const bool oldLazyTileLoading = KisImageConfig(true).lazyTileLoading();
+    KisImageConfig(false).setLazyTileLoading(true);
+
+    QBuffer corruptedBuffer(&data);
+    corruptedBuffer.open(QIODevice::ReadOnly);
+    KisTiledDataManager dstDM(1, &defaultPixel);
+    const bool result = dstDM.read(&corruptedBuffer);
+
+    KisImageConfig(false).setLazyTileLoading(oldLazyTileLoading);
+
+    // the file is rejected, like with the eager decompression
+    QVERIFY(!result);
+}
+
+void KisTiledDataManagerTest::testLazyCopy()
+{
+    quint8 defaultPixel = 0;
+    quint8 oddPixel1 = 128;
+    quint8 oddPixel2 = 129;
+
+    QRect rect(0, 0, 256, 256);
+    QRect holeRect(64, 64, 64, 64);
+
+    KisTiledDataManager srcDM(1, &defaultPixel);
+    srcDM.clear(rect, &oddPixel1);
+
+    // the tiles of the copy are created on the first access only
+    KisTiledDataManager dstDM(srcDM);
+    QCOMPARE(dstDM.extent(), srcDM.extent());
+
+    // changes in the source should not reach the pinned tiles
+    srcDM.clear(holeRect, &oddPixel2);
+
+    quint8 buffer[256 * 256];
+    dstDM.readBytes(buffer, rect.x(), rect.y(), rect.width(), rect.height());
+    QVERIFY(checkHole(buffer, oddPixel1, holeRect, oddPixel1, rect));
+
+    KisTiledDataManager dstDM2(srcDM);
+    QVERIFY(checkTilesShared(&srcDM, &dstDM2, false, false, QRect(0, 0, 4, 4)));
+
+    // the copied tiles must not become a part of the first transaction
+    KisMementoSP memento = dstDM2.getMemento();
+    dstDM2.clear(holeRect, &oddPixel1);
+    dstDM2.commit();
+
+    dstDM2.readBytes(buffer, rect.x(), rect.y(), rect.width(), rect.height());
+    QVERIFY(checkHole(buffer, oddPixel1, holeRect, oddPixel1, rect));
+
+    dstDM2.rollback(memento);
+    QCOMPARE(dstDM2.extent(), rect);
+
+    dstDM2.readBytes(buffer, rect.x(), rect.y(), rect.width(), rect.height());
+    QVERIFY(checkHole(buffer, oddPixel2, holeRect, oddPixel1, rect));
+}
+
 void KisTiledDataManagerTest::benchmarkReadOnlyTileLazy()
 {
     quint8 defaultPixel = 0;
@@ -52,6 +52,10 @@ private Q_SLOTS:
     void testTransactions();
     void testPurgeHistory();
     void testUndoSetDefaultPixel();
+    void testWriteReadManyTiles();
+    void testLazyRead();
+    void testLazyReadCorrupted();
+    void testLazyCopy();
 
     void benchmarkReadOnlyTileLazy();
     void benchmarkSharedPointers();
@@ -89,7 +89,7 @@ static quint32 pack_pb_line (const QByteArray &src,
 
 
 // from gimp's psd-util.c
-quint32 decode_packbits(const char *src, char* dst, quint16 packed_len, quint32 unpacked_len)
+quint32 decode_packbits(const char *src, char* dst, quint32 packed_len, quint32 unpacked_len)
 {
     /*
      *  Decode a PackBits chunk.
@@ -170,7 +170,7 @@ quint32 decode_packbits(const char *src, char* dst, quint16 packed_len, quint32
     if (unpack_left > 0)
     {
         /* Pad with zeros to end of output buffer */
-        for (n = 0; n < pack_left; ++n)
+        for (n = 0; n < unpack_left; ++n)
         {
             *dst = 0;
             dst++;
@@ -198,6 +198,11 @@ quint32 decode_packbits(const char *src, char* dst, quint16 packed_len, quint32
     return return_val;
 }
 
+void Compression::decodePackBits(const char *src, quint32 packedLength, char *dst, quint32 unpackedLength)
+{
+    decode_packbits(src, dst, packedLength, unpackedLength);
+}
+
 QByteArray Compression::uncompress(quint32 unpacked_len, QByteArray bytes, Compression::CompressionType compressionType)
 {
     if (unpacked_len > 30000) return QByteArray();
@@ -247,10 +252,11 @@ QByteArray Compression::compress(QByteArray bytes, Compression::CompressionType
         return bytes;
     case RLE:
     {
-        QByteArray dst;
+        // reserve space for the worst case, when every run is a literal one
+        QByteArray dst(bytes.size() + bytes.size() / 128 + 1, 0);
         int packed_len = pack_pb_line(bytes, dst);
-        Q_ASSERT(packed_len == dst.size());
-        Q_UNUSED(packed_len);
+        KIS_ASSERT_RECOVER_NOOP(packed_len <= dst.size());
+        dst.resize(packed_len);
         return dst;
     }
     case ZIP:
@@ -34,6 +34,13 @@ public:
     };
 
     static QByteArray uncompress(quint32 unpacked_len, QByteArray bytes, CompressionType compressionType);
+
+    /**
+     * Decodes one PackBits-compressed row from \p src directly into \p dst,
+     * which should be able to hold \p unpackedLength bytes. Unlike uncompress()
+     * it does no allocations, so it can be used for decoding rows in parallel.
+     */
+    static void decodePackBits(const char *src, quint32 packedLength, char *dst, quint32 unpackedLength);
     static QByteArray compress(QByteArray bytes, CompressionType compressionType);
 };
 
@@ -45,9 +45,11 @@ struct KoQuaZipStore::Private {
     QuaZip *archive {0};
     QuaZipFile *currentFile {0};
     int compressionLevel {Z_DEFAULT_COMPRESSION};
+    KoStore::EntryCompression entryCompression {KoStore::DeflatedEntry};
     bool usingSaveFile {false};
     QByteArray cache;
     QBuffer buffer;
+    qint64 lastWrittenCrc {-1};
 };
 
 
@@ -97,6 +99,11 @@ void KoQuaZipStore::setCompressionEnabled(bool enabled)
     }
 }
 
+void KoQuaZipStore::setEntryCompression(EntryCompression compression)
+{
+    dd->entryCompression = compression;
+}
+
 qint64 KoQuaZipStore::write(const char *_data, qint64 _len)
 {
     Q_D(KoStore);
@@ -124,6 +131,11 @@ QStringList KoQuaZipStore::directoryList() const
     return dd->archive->getFileNameList();
 }
 
+qint64 KoQuaZipStore::lastWrittenCrc() const
+{
+    return dd->lastWrittenCrc;
+}
+
 void KoQuaZipStore::init(const QByteArray &appIdentification)
 {
     Q_D(KoStore);
@@ -188,7 +200,14 @@ bool KoQuaZipStore::openWrite(const QString &name)
     dd->currentFile = new QuaZipFile(dd->archive);
     QuaZipNewInfo newInfo(fixedPath);
     newInfo.setPermissions(QFileDevice::ReadOwner | QFileDevice::ReadGroup | QFileDevice::ReadOther);
-    bool r = dd->currentFile->open(QIODevice::WriteOnly, newInfo, 0, 0, Z_DEFLATED, dd->compressionLevel);
+
+    bool r = false;
+    if (dd->entryCompression == StoredEntry) {
+        r = dd->currentFile->open(QIODevice::WriteOnly, newInfo, 0, 0, 0, Z_NO_COMPRESSION);
+    } else {
+        r = dd->currentFile->open(QIODevice::WriteOnly, newInfo, 0, 0, Z_DEFLATED, dd->compressionLevel);
+    }
+
     if (!r) {
         qWarning() << "Could not open" << name << dd->currentFile->getZipError();
     }
@@ -200,6 +219,89 @@ bool KoQuaZipStore::openWrite(const QString &name)
     return r;
 }
 
+bool KoQuaZipStore::copyRawEntryImpl(KoStore *source, const QString &sourceName, const QString &name,
+                                     qint64 expectedSize, qint64 expectedCrc)
+{
+    Q_D(KoStore);
+
+    /**
+     * The entry is copied in chunks, so that huge layers
+     * are never loaded into memory as a whole
+     */
+    const qint64 chunkSize = 1024 * 1024;
+
+    KoQuaZipStore *zipSource = dynamic_cast<KoQuaZipStore*>(source);
+    if (!zipSource) return false;
+
+    QString fixedSourcePath = sourceName;
+    fixedSourcePath.replace("//", "/");
+
+    QString fixedPath = name;
+    fixedPath.replace("//", "/");
+
+    QuaZip *sourceArchive = zipSource->dd->archive;
+
+    QuaZipFileInfo64 info;
+    if (!sourceArchive->setCurrentFile(fixedSourcePath) ||
+        !sourceArchive->getCurrentFileInfo(&info)) {
+
+        return false;
+    }
+
+    if (expectedSize >= 0 && quint64(expectedSize) != info.uncompressedSize) {
+        return false;
+    }
+
+    if (expectedCrc >= 0 && quint32(expectedCrc) != info.crc) {
+        return false;
+    }
+
+    int method = 0;
+    int level = 0;
+
+    QuaZipFile sourceFile(sourceArchive);
+    if (!sourceFile.open(QIODevice::ReadOnly, &method, &level, true)) {
+        return false;
+    }
+
+    QuaZipNewInfo newInfo(fixedPath);
+    newInfo.setPermissions(QFileDevice::ReadOwner | QFileDevice::ReadGroup | QFileDevice::ReadOther);
+    newInfo.uncompressedSize = info.uncompressedSize;
+
+    QuaZipFile file(dd->archive);
+    if (!file.open(QIODevice::WriteOnly, newInfo, 0, info.crc, method, level, true)) {
+        qWarning() << "Could not open" << name << file.getZipError();
+        return false;
+    }
+
+    QByteArray chunk;
+    quint64 bytesCopied = 0;
+    bool result = true;
+
+    while (result && bytesCopied < info.compressedSize) {
+        chunk = sourceFile.read(qMin(chunkSize, qint64(info.compressedSize - bytesCopied)));
+
+        result = !chunk.isEmpty() && file.write(chunk) == chunk.size();
+        bytesCopied += chunk.size();
+    }
+
+    sourceFile.close();
+    file.close();
+
+    result = result && file.getZipError() == ZIP_OK;
+
+    if (!result) {
+        /**
+         * A part of the entry has already been written into the
+         * archive, so it cannot be written once again
+         */
+        qWarning() << "Could not copy" << sourceName << "into" << name;
+        d->good = false;
+    }
+
+    return result;
+}
+
 bool KoQuaZipStore::openRead(const QString &name)
 {
     Q_D(KoStore);
@@ -244,6 +346,10 @@ bool KoQuaZipStore::closeWrite()
         qWarning() << "Could not write buffer to the file";
         r = false;
     }
+
+    dd->lastWrittenCrc = r ?
+        qint64(crc32(0L, reinterpret_cast<const Bytef*>(dd->cache.constData()), dd->cache.size())) : -1;
+
     dd->buffer.close();
     dd->currentFile->close();
     d->stream = 0;
@@ -37,15 +37,20 @@ public:
     ~KoQuaZipStore() override;
 
     void setCompressionEnabled(bool enabled) override;
+    void setEntryCompression(EntryCompression compression) override;
     qint64 write(const char* _data, qint64 _len) override;
 
     QStringList directoryList() const override;
 
+    qint64 lastWrittenCrc() const override;
+
 protected:
     void init(const QByteArray& appIdentification);
     bool doFinalize() override;
     bool openWrite(const QString& name) override;
     bool openRead(const QString& name) override;
+    bool copyRawEntryImpl(KoStore *source, const QString &sourceName, const QString &name,
+                          qint64 expectedSize, qint64 expectedCrc) override;
     bool closeWrite() override;
     bool closeRead() override;
     bool enterRelativeDirectory(const QString& dirName) override;
@@ -180,6 +180,41 @@ bool KoStore::open(const QString & _name)
     return true;
 }
 
+bool KoStore::copyRawEntry(KoStore *source, const QString &sourceName, const QString &name,
+                           qint64 expectedSize, qint64 expectedCrc)
+{
+    Q_D(KoStore);
+
+    if (d->mode != Write || d->isOpen) {
+        warnStore << "KoStore: Can not copy a file into a store that is opened for reading or has an open file";
+        return false;
+    }
+
+    if (!source || source->mode() != Read || source->isOpen()) {
+        return false;
+    }
+
+    const QString fileName = d->toExternalNaming(name);
+    const QString sourceFileName = source->d_func()->toExternalNaming(sourceName);
+
+    if (d->filesList.contains(fileName)) {
+        warnStore << "KoStore: Duplicate filename" << fileName;
+        return false;
+    }
+
+    if (!copyRawEntryImpl(source, sourceFileName, fileName, expectedSize, expectedCrc)) {
+        return false;
+    }
+
+    d->filesList.append(fileName);
+    return true;
+}
+
+qint64 KoStore::lastWrittenCrc() const
+{
+    return -1;
+}
+
 bool KoStore::isOpen() const
 {
     Q_D(const KoStore);
@@ -437,6 +472,10 @@ void KoStore::setCompressionEnabled(bool /*e*/)
 {
 }
 
+void KoStore::setEntryCompression(EntryCompression /*compression*/)
+{
+}
+
 void KoStore::setSubstitution(const QString &name, const QString &substitution)
 {
     Q_D(KoStore);
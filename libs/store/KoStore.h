@@ -264,6 +264,46 @@ public:
      */
     virtual void setCompressionEnabled(bool e);
 
+    /**
+     * Compression method of the entries written into the store
+     */
+    enum EntryCompression {
+        DeflatedEntry, ///< the entry is deflated with the level set by setCompressionEnabled()
+        StoredEntry    ///< the entry is stored as is, use it for the data that is compressed already
+    };
+
+    /**
+     * Set the compression method of the entries opened for writing after
+     * this call. Only supported by the ZIP backend. Stored entries skip
+     * zlib completely, which is much faster than deflating data that
+     * cannot be compressed any further.
+     */
+    virtual void setEntryCompression(EntryCompression compression);
+
+    /**
+     * Copy the file @p sourceName of the @p source store into the file
+     * @p name of this store as is, without decompressing and compressing
+     * it again. Only supported by the ZIP backend, the source store must
+     * be opened for reading and this store for writing.
+     *
+     * @param expectedSize if not negative, the file is copied only if its
+     *        uncompressed size is equal to this value
+     * @param expectedCrc if not negative, the file is copied only if the
+     *        CRC-32 of its uncompressed data is equal to this value
+     * @return true on success. If the file cannot be copied, nothing is
+     *         written and the caller should write the file in the usual
+     *         way. If reading or writing fails in the middle of copying,
+     *         the store becomes bad.
+     */
+    bool copyRawEntry(KoStore *source, const QString &sourceName, const QString &name,
+                      qint64 expectedSize = -1, qint64 expectedCrc = -1);
+
+    /**
+     * @return the CRC-32 of the data of the file that has been written and
+     *         closed last, or -1 if the backend doesn't calculate it
+     */
+    virtual qint64 lastWrittenCrc() const;
+
     /// When reading, in the paths in the store where name occurs, substitution is used.
     void setSubstitution(const QString &name, const QString &substitution);
 
@@ -294,6 +334,22 @@ protected:
      */
     virtual bool openRead(const QString &name) = 0;
 
+    /**
+     * Copy the file @p sourceName of @p source into the file @p name of
+     * this store without recompressing it. Both names are "absolute paths"
+     * in the corresponding archives.
+     * @return true on success
+     */
+    virtual bool copyRawEntryImpl(KoStore *source, const QString &sourceName, const QString &name,
+                                  qint64 expectedSize, qint64 expectedCrc) {
+        Q_UNUSED(source);
+        Q_UNUSED(sourceName);
+        Q_UNUSED(name);
+        Q_UNUSED(expectedSize);
+        Q_UNUSED(expectedCrc);
+        return false;
+    }
+
     /**
      * @return true on success
      */
@@ -36,6 +36,14 @@ struct KRITAUI_NO_EXPORT KisAsyncAnimationRendererBase::Private
     bool isCancelled = false;
     QRegion requestedRegion;
 
+    /**
+     * Set by the worker thread when the frame has been regenerated. The
+     * timeout covers only the waiting for the frame, the processing in
+     * frameCompletedCallback() may take any time (e.g. a streaming
+     * renderer may block until the encoder takes the frame).
+     */
+    QAtomicInt frameIsReady;
+
     static const int WAITING_FOR_FRAME_TIMEOUT = 30000;
 };
 
@@ -43,7 +51,7 @@ KisAsyncAnimationRendererBase::KisAsyncAnimationRendererBase(QObject *parent)
     : QObject(parent),
       m_d(new Private())
 {
-    connect(&m_d->regenerationTimeout, SIGNAL(timeout()), SLOT(slotFrameRegenerationCancelled()));
+    connect(&m_d->regenerationTimeout, SIGNAL(timeout()), SLOT(slotFrameRegenerationTimedOut()));
     m_d->regenerationTimeout.setSingleShot(true);
     m_d->regenerationTimeout.setInterval(Private::WAITING_FOR_FRAME_TIMEOUT);
 }
@@ -61,6 +69,7 @@ void KisAsyncAnimationRendererBase::startFrameRegeneration(KisImageSP image, int
     m_d->requestedFrame = frame;
     m_d->isCancelled = false;
     m_d->requestedRegion = !regionOfInterest.isEmpty() ? regionOfInterest : image->bounds();
+    m_d->frameIsReady = 0;
 
     KisImageAnimationInterface *animation = m_d->requestedImage->animationInterface();
 
@@ -102,6 +111,14 @@ void KisAsyncAnimationRendererBase::slotFrameRegenerationCancelled()
     frameCancelledCallback(m_d->requestedFrame);
 }
 
+void KisAsyncAnimationRendererBase::slotFrameRegenerationTimedOut()
+{
+    // the frame is already being processed by frameCompletedCallback()
+    if (m_d->frameIsReady) return;
+
+    slotFrameRegenerationCancelled();
+}
+
 void KisAsyncAnimationRendererBase::slotFrameRegenerationFinished(int frame)
 {
     // We might have already cancelled the regeneration. We don't check
@@ -113,6 +130,7 @@ void KisAsyncAnimationRendererBase::slotFrameRegenerationFinished(int frame)
     // probably a bit too strict...
     KIS_SAFE_ASSERT_RECOVER_NOOP(QThread::currentThread() != this->thread());
 
+    m_d->frameIsReady = 1;
     frameCompletedCallback(frame, m_d->requestedRegion);
 }
 
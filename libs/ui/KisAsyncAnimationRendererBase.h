@@ -73,6 +73,7 @@ Q_SIGNALS:
 
 private Q_SLOTS:
     void slotFrameRegenerationCancelled();
+    void slotFrameRegenerationTimedOut();
     void slotFrameRegenerationFinished(int frame);
 
 protected Q_SLOTS:
@@ -109,7 +110,8 @@ protected:
      *        the frame was cancelled.
      *
      * The rendering of the frame can be either cancelled by the image itself or
-     * by receiving a timeout signal (10 seconds).
+     * by receiving a timeout signal (30 seconds). The timeout is counted only
+     * until the frame is ready, it doesn't cover frameCompletedCallback().
      *
      * NOTE: the slot is called in the GUI thread. Don't forget to call
      *       notifyFrameCancelled() in he end of your call.
@@ -212,13 +212,29 @@ void KisFrameCacheStore::saveFrame(int frameId, KisOpenGLUpdateInfoSP info, cons
             } else if (*uniqueness < 0.5) {
                 FrameInfoSP baseFrameInfo = m_d->savedFrames[m_d->lastSavedFullFrameId];
 
-                KisFrameDataSerializer::subtractFrames(frame, m_d->lastSavedFullFrame);
-                frameInfo = toQShared(new FrameInfo(info->dirtyImageRect(),
-                                                    imageBounds,
-                                                    info->levelOfDetail(),
-                                                    m_d->serializer,
-                                                    baseFrameInfo,
-                                                    frame));
+                /**
+                 * Only the tiles that differ from the keyframe are stored,
+                 * the rest of them are taken from the keyframe on loading.
+                 * The uniqueness is estimated on a small sample of pixels
+                 * only, so the frames may still happen to be equal.
+                 */
+                const bool framesAreSame =
+                    KisFrameDataSerializer::subtractFramesSparse(frame, m_d->lastSavedFullFrame);
+
+                if (framesAreSame) {
+                    frameInfo = toQShared(new FrameInfo(info->dirtyImageRect(),
+                                                        imageBounds,
+                                                        info->levelOfDetail(),
+                                                        m_d->serializer,
+                                                        baseFrameInfo));
+                } else {
+                    frameInfo = toQShared(new FrameInfo(info->dirtyImageRect(),
+                                                        imageBounds,
+                                                        info->levelOfDetail(),
+                                                        m_d->serializer,
+                                                        baseFrameInfo,
+                                                        frame));
+                }
             }
         }
     }
@@ -286,8 +302,13 @@ KisOpenGLUpdateInfoSP KisFrameCacheStore::loadFrame(int frameId, const KisOpenGL
         const KisFrameDataSerializer::Frame &baseFrame = m_d->lastLoadedBaseFrame;
         KIS_SAFE_ASSERT_RECOVER_RETURN_VALUE(baseFrame.isValid(), KisOpenGLUpdateInfoSP());
 
-        frame = m_d->serializer.loadFrame(frameInfo->frameDataId(), builder.textureInfoPool());
-        KisFrameDataSerializer::addFrames(frame, baseFrame);
+        // the difference frame contains only the tiles that have changed
+        const KisFrameDataSerializer::Frame diffFrame =
+            m_d->serializer.loadFrame(frameInfo->frameDataId(), builder.textureInfoPool());
+        KIS_SAFE_ASSERT_RECOVER_RETURN_VALUE(diffFrame.isValid(), KisOpenGLUpdateInfoSP());
+
+        frame = baseFrame.clone();
+        KisFrameDataSerializer::addFramesSparse(frame, diffFrame);
         break;
     }
     }
@@ -37,7 +37,10 @@ typedef KisSharedPtr<KisOpenGLUpdateInfo> KisOpenGLUpdateInfoSP;
  *    KisFrameDataSerializer::Frame format.
  *
  * 2) Calculate differences between the frames and decide which
- *    frame will be a keyframe for other frames.
+ *    frame will be a keyframe for other frames. A difference frame
+ *    stores only the tiles that differ from its keyframe. The keyframe
+ *    data is shared by all the frames based on it and is removed only
+ *    when the last of them is forgotten.
  *
  * 3) The keyframes will be used as a base for difference
  *    calculation and stored in a short in-memory cache to avoid
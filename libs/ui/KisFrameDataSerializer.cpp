@@ -254,6 +254,12 @@ void KisFrameDataSerializer::forgetFrame(int frameId)
     QFile::remove(framePath);
 }
 
+qint64 KisFrameDataSerializer::frameDataSize(int frameId) const
+{
+    const QString framePath = m_d->filePathForFrame(frameId);
+    return QFileInfo(framePath).size();
+}
+
 boost::optional<qreal> KisFrameDataSerializer::estimateFrameUniqueness(const KisFrameDataSerializer::Frame &lhs, const KisFrameDataSerializer::Frame &rhs, qreal portion)
 {
     if (lhs.pixelSize != rhs.pixelSize) return boost::none;
@@ -314,12 +320,17 @@ bool processData(T *dst, const T *src, int numUnits)
 
 
 template<template <typename U> class OpPolicy>
-bool KisFrameDataSerializer::processFrames(KisFrameDataSerializer::Frame &dst, const KisFrameDataSerializer::Frame &src)
+bool KisFrameDataSerializer::processFrames(KisFrameDataSerializer::Frame &dst, const KisFrameDataSerializer::Frame &src,
+                                           std::vector<bool> *tilesAreSame)
 {
     bool framesAreSame = true;
 
     KIS_SAFE_ASSERT_RECOVER_RETURN_VALUE(estimateFrameUniqueness(src, dst, 0.0), false);
 
+    if (tilesAreSame) {
+        tilesAreSame->assign(src.frameTiles.size(), true);
+    }
+
     for (int i = 0; i < int(src.frameTiles.size()); i++) {
         const FrameTile &srcTile = src.frameTiles[i];
         FrameTile &dstTile = dst.frameTiles[i];
@@ -330,14 +341,20 @@ bool KisFrameDataSerializer::processFrames(KisFrameDataSerializer::Frame &dst, c
         const quint64 *srcDataPtr = reinterpret_cast<const quint64*>(srcTile.data.data());
         quint64 *dstDataPtr = reinterpret_cast<quint64*>(dstTile.data.data());
 
-        framesAreSame &= processData<OpPolicy>(dstDataPtr, srcDataPtr, numQWords);
+        bool tileIsSame = processData<OpPolicy>(dstDataPtr, srcDataPtr, numQWords);
 
 
         const int tailBytes = numBytes % 8;
         const quint8 *srcTailDataPtr = srcTile.data.data() + numBytes - tailBytes;
         quint8 *dstTailDataPtr = dstTile.data.data() + numBytes - tailBytes;
 
-        framesAreSame &= processData<OpPolicy>(dstTailDataPtr, srcTailDataPtr, tailBytes);
+        tileIsSame &= processData<OpPolicy>(dstTailDataPtr, srcTailDataPtr, tailBytes);
+
+        if (tilesAreSame) {
+            (*tilesAreSame)[i] = tileIsSame;
+        }
+
+        framesAreSame &= tileIsSame;
     }
 
     return framesAreSame;
@@ -353,3 +370,61 @@ void KisFrameDataSerializer::addFrames(KisFrameDataSerializer::Frame &dst, const
     // TODO: don't spend time on calculation of "framesAreSame" in this case
     (void) processFrames<std::plus>(dst, src);
 }
+
+bool KisFrameDataSerializer::subtractFramesSparse(KisFrameDataSerializer::Frame &dst, const KisFrameDataSerializer::Frame &src)
+{
+    std::vector<bool> tilesAreSame;
+
+    if (!estimateFrameUniqueness(src, dst, 0.0)) return false;
+
+    const bool framesAreSame = processFrames<std::minus>(dst, src, &tilesAreSame);
+
+    std::vector<FrameTile> changedTiles;
+
+    for (int i = 0; i < int(dst.frameTiles.size()); i++) {
+        if (!tilesAreSame[i]) {
+            changedTiles.push_back(std::move(dst.frameTiles[i]));
+        }
+    }
+
+    dst.frameTiles = std::move(changedTiles);
+
+    return framesAreSame;
+}
+
+void KisFrameDataSerializer::addFramesSparse(KisFrameDataSerializer::Frame &dst, const KisFrameDataSerializer::Frame &src)
+{
+    KIS_SAFE_ASSERT_RECOVER_RETURN(src.pixelSize == dst.pixelSize);
+
+    /**
+     * The tiles of the sparse frame go in the same order as in the full
+     * one, so we can just skip the tiles that are not present in it
+     */
+    auto dstIt = dst.frameTiles.begin();
+
+    for (auto srcIt = src.frameTiles.begin(); srcIt != src.frameTiles.end(); ++srcIt) {
+        const FrameTile &srcTile = *srcIt;
+
+        while (dstIt != dst.frameTiles.end() &&
+               (dstIt->col != srcTile.col || dstIt->row != srcTile.row)) {
+            ++dstIt;
+        }
+
+        KIS_SAFE_ASSERT_RECOVER_RETURN(dstIt != dst.frameTiles.end());
+        KIS_SAFE_ASSERT_RECOVER_RETURN(dstIt->rect == srcTile.rect);
+
+        const int numBytes = srcTile.rect.width() * srcTile.rect.height() * src.pixelSize;
+        const int numQWords = numBytes / 8;
+
+        const quint64 *srcDataPtr = reinterpret_cast<const quint64*>(srcTile.data.data());
+        quint64 *dstDataPtr = reinterpret_cast<quint64*>(dstIt->data.data());
+
+        (void) processData<std::plus>(dstDataPtr, srcDataPtr, numQWords);
+
+        const int tailBytes = numBytes % 8;
+        const quint8 *srcTailDataPtr = srcTile.data.data() + numBytes - tailBytes;
+        quint8 *dstTailDataPtr = dstIt->data.data() + numBytes - tailBytes;
+
+        (void) processData<std::plus>(dstTailDataPtr, srcTailDataPtr, tailBytes);
+    }
+}
@@ -119,13 +119,36 @@ public:
     bool hasFrame(int frameId) const;
     void forgetFrame(int frameId);
 
+    /**
+     * \return the size of the frame data stored on disk in bytes
+     */
+    qint64 frameDataSize(int frameId) const;
+
     static boost::optional<qreal> estimateFrameUniqueness(const Frame &lhs, const Frame &rhs, qreal portion);
     static bool subtractFrames(Frame &dst, const Frame &src);
     static void addFrames(Frame &dst, const Frame &src);
 
+    /**
+     * Subtracts \p src from \p dst and removes the tiles that became
+     * empty, that is, the tiles that are equal in both frames. The
+     * resulting sparse difference frame can be restored back with
+     * addFramesSparse().
+     *
+     * \return true if the frames are equal, that is, no tiles are left
+     *         in \p dst
+     */
+    static bool subtractFramesSparse(Frame &dst, const Frame &src);
+
+    /**
+     * Adds a sparse difference frame \p src, generated by
+     * subtractFramesSparse(), to the full frame \p dst
+     */
+    static void addFramesSparse(Frame &dst, const Frame &src);
+
 private:
     template<template <typename U> class OpPolicy>
-    static bool processFrames(KisFrameDataSerializer::Frame &dst, const KisFrameDataSerializer::Frame &src);
+    static bool processFrames(KisFrameDataSerializer::Frame &dst, const KisFrameDataSerializer::Frame &src,
+                              std::vector<bool> *tilesAreSame = 0);
 
 private:
     Q_DISABLE_COPY(KisFrameDataSerializer)
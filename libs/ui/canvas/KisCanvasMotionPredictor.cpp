@@ -0,0 +1,129 @@
+/*
+ *  Copyright (c) 2020 Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "KisCanvasMotionPredictor.h"
+
+#include <QtMath>
+
+#include "kis_algebra_2d.h"
+
+namespace {
+
+/// the weight of the newest sample in the smoothed velocity
+const qreal smoothingFactor = 0.5;
+
+/// the maximum zoom change the prediction may extrapolate to
+const qreal maxZoomExtrapolation = 2.0;
+
+/// the margin around the visible rect where the updates are not deferred
+const qreal staleUpdatesMargin = 0.25;
+
+qreal rectScale(const QRectF &rc)
+{
+    return std::sqrt(qMax(1e-6, rc.width() * rc.height()));
+}
+
+}
+
+KisCanvasMotionPredictor::KisCanvasMotionPredictor()
+{
+}
+
+int KisCanvasMotionPredictor::resetTimeout()
+{
+    return 200;
+}
+
+void KisCanvasMotionPredictor::addSample(const QRectF &visibleRect, qint64 time)
+{
+    if (m_lastTime < 0 || visibleRect.isEmpty() ||
+        time - m_lastTime > resetTimeout() || time < m_lastTime) {
+
+        m_velocity = QPointF();
+        m_zoomVelocity = 0.0;
+        m_lastRect = visibleRect;
+        m_lastTime = time;
+        return;
+    }
+
+    /**
+     * Several events can come in the same millisecond, just
+     * wait for the next one to have some meaningful interval
+     */
+    const qint64 dt = time - m_lastTime;
+    if (dt <= 0) {
+        m_lastRect = visibleRect;
+        return;
+    }
+
+    const QPointF velocity = (visibleRect.center() - m_lastRect.center()) / dt;
+    const qreal zoomVelocity = std::log2(rectScale(visibleRect) / rectScale(m_lastRect)) / dt;
+
+    m_velocity = smoothingFactor * velocity + (1.0 - smoothingFactor) * m_velocity;
+    m_zoomVelocity = smoothingFactor * zoomVelocity + (1.0 - smoothingFactor) * m_zoomVelocity;
+
+    m_lastRect = visibleRect;
+    m_lastTime = time;
+}
+
+void KisCanvasMotionPredictor::reset()
+{
+    m_lastRect = QRectF();
+    m_lastTime = -1;
+    m_velocity = QPointF();
+    m_zoomVelocity = 0.0;
+}
+
+bool KisCanvasMotionPredictor::isMoving() const
+{
+    return m_lastTime >= 0 &&
+        (!qFuzzyIsNull(m_velocity.x()) ||
+         !qFuzzyIsNull(m_velocity.y()) ||
+         !qFuzzyIsNull(m_zoomVelocity));
+}
+
+QRectF KisCanvasMotionPredictor::predictedRect(int lookAhead) const
+{
+    if (!isMoving()) return m_lastRect;
+
+    const qreal scale = qBound(1.0 / maxZoomExtrapolation,
+                               std::pow(2.0, m_zoomVelocity * lookAhead),
+                               maxZoomExtrapolation);
+
+    const QPointF center = m_lastRect.center() + m_velocity * lookAhead;
+    const QSizeF size = m_lastRect.size() * scale;
+
+    QRectF predicted(QPointF(), size);
+    predicted.moveCenter(center);
+
+    return m_lastRect | predicted;
+}
+
+QRect KisCanvasMotionPredictor::prefetchRect(int lookAhead, const QRect &imageRect) const
+{
+    return KisAlgebra2D::blowRect(predictedRect(lookAhead), staleUpdatesMargin).toAlignedRect() & imageRect;
+}
+
+QRect KisCanvasMotionPredictor::staleUpdatesFilterRect(const QRectF &visibleRect, const QRect &imageRect)
+{
+    const QRect filterRect =
+        KisAlgebra2D::blowRect(visibleRect, staleUpdatesMargin).toAlignedRect() & imageRect;
+
+    return filterRect != imageRect ? filterRect : QRect();
+}
@@ -0,0 +1,97 @@
+/*
+ *  Copyright (c) 2020 Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef KISCANVASMOTIONPREDICTOR_H
+#define KISCANVASMOTIONPREDICTOR_H
+
+#include <QRect>
+#include <QRectF>
+#include <QPointF>
+
+#include "kritaui_export.h"
+
+/**
+ * Tracks the visible part of the image while the user pans and zooms
+ * the canvas and extrapolates where the viewport is going to be in the
+ * near future.
+ *
+ * The velocity of the viewport center and the rate of the zoom are
+ * smoothed over the recent samples, so a single jerky event does not
+ * throw the prediction far away. The motion is considered to be stopped
+ * if there were no samples for resetTimeout() milliseconds.
+ */
+class KRITAUI_EXPORT KisCanvasMotionPredictor
+{
+public:
+    KisCanvasMotionPredictor();
+
+    /**
+     * Registers the visible rect of the image (in image pixels)
+     * at time \p time (in milliseconds)
+     */
+    void addSample(const QRectF &visibleRect, qint64 time);
+
+    /**
+     * Forgets the motion history, e.g. when a new image is loaded
+     */
+    void reset();
+
+    /**
+     * \return true if the viewport is currently moving or zooming
+     */
+    bool isMoving() const;
+
+    /**
+     * \return the area the viewport is going to sweep over in the next
+     *         \p lookAhead milliseconds, that is, the union of the
+     *         current and the extrapolated visible rects. If the viewport
+     *         is not moving, returns the current visible rect.
+     */
+    QRectF predictedRect(int lookAhead) const;
+
+    /**
+     * \return the area where the stale updates should be prefetched:
+     *         predictedRect() grown by the same margin as the
+     *         stale updates filter and clipped by \p imageRect
+     */
+    QRect prefetchRect(int lookAhead, const QRect &imageRect) const;
+
+    /**
+     * \return the area around \p visibleRect whose updates are converted
+     *         into the canvas cache immediately, that is, \p visibleRect
+     *         grown by 25% and clipped by \p imageRect. If the area
+     *         covers the whole image, returns an empty rect, which means
+     *         that no updates should be deferred.
+     */
+    static QRect staleUpdatesFilterRect(const QRectF &visibleRect, const QRect &imageRect);
+
+    static int resetTimeout();
+
+private:
+    QRectF m_lastRect;
+    qint64 m_lastTime = -1;
+
+    /// the velocity of the viewport center, in image pixels per ms
+    QPointF m_velocity;
+
+    /// the rate of the visible rect growth, in log2(scale) per ms
+    qreal m_zoomVelocity = 0.0;
+};
+
+#endif // KISCANVASMOTIONPREDICTOR_H
@@ -0,0 +1,447 @@
+/*
+ *  Copyright (c) 2020 Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "KisDisplayConversionLut.h"
+
+#include <algorithm>
+
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <KoColorSpace.h>
+#include <KoColorSpaceMaths.h>
+#include <KoColorSpaceRegistry.h>
+#include <KoColorModelStandardIds.h>
+
+#include "kis_assert.h"
+#include "kis_pointer_utils.h"
+
+namespace {
+
+const int gridSize = 33;
+const int gridStrideZ = 3;
+const int gridStrideY = gridSize * gridStrideZ;
+const int gridStrideX = gridSize * gridStrideY;
+
+/**
+ * The cache is tiny: normally there is one table per opened
+ * image/monitor pair
+ */
+const int maxCachedTables = 8;
+
+/**
+ * The max difference (in 8-bit levels) from the full conversion
+ * the table is allowed to have on the test colors
+ */
+const int maxAllowedError = 2;
+
+struct CacheKey {
+    const KoColorSpace *srcColorSpace;
+    const KoColorSpace *dstColorSpace;
+    int renderingIntent;
+    int conversionFlags;
+
+    bool operator==(const CacheKey &rhs) const {
+        return srcColorSpace == rhs.srcColorSpace &&
+            dstColorSpace == rhs.dstColorSpace &&
+            renderingIntent == rhs.renderingIntent &&
+            conversionFlags == rhs.conversionFlags;
+    }
+};
+
+uint qHash(const CacheKey &key, uint seed = 0)
+{
+    return ::qHash(key.srcColorSpace, seed) ^
+        ::qHash(key.dstColorSpace, seed) ^
+        ::qHash(key.renderingIntent, seed) ^
+        ::qHash(key.conversionFlags, seed);
+}
+
+struct TableCache {
+    QMutex mutex;
+    QHash<CacheKey, KisDisplayConversionLutSP> tables;
+};
+
+Q_GLOBAL_STATIC(TableCache, s_cache)
+
+inline void splitGridValue(quint16 value, int &index, qint32 &fraction)
+{
+    // value * (gridSize - 1) / 65535 in 16.16 fixed point
+    const quint32 scaled = (quint64(value) * (gridSize - 1) * 0x10001) >> 16;
+    index = scaled >> 16;
+    fraction = scaled & 0xFFFF;
+}
+
+}
+
+KisDisplayConversionLutSP KisDisplayConversionLut::fetch(const KoColorSpace *srcColorSpace,
+                                                         const KoColorSpace *dstColorSpace,
+                                                         KoColorConversionTransformation::Intent renderingIntent,
+                                                         KoColorConversionTransformation::ConversionFlags conversionFlags)
+{
+    if (!isSupported(srcColorSpace, dstColorSpace)) {
+        return KisDisplayConversionLutSP();
+    }
+
+    const CacheKey key = {srcColorSpace, dstColorSpace, int(renderingIntent), int(conversionFlags)};
+
+    TableCache *cache = s_cache;
+    QMutexLocker l(&cache->mutex);
+
+    KisDisplayConversionLutSP table = cache->tables.value(key);
+
+    if (!table) {
+        if (cache->tables.size() >= maxCachedTables) {
+            cache->tables.clear();
+        }
+
+        table = toQShared(new KisDisplayConversionLut(srcColorSpace, dstColorSpace,
+                                                      renderingIntent, conversionFlags));
+
+        // the invalid tables are cached as well, to not check them again
+        cache->tables.insert(key, table);
+    }
+
+    return table->isValid() ? table : KisDisplayConversionLutSP();
+}
+
+bool KisDisplayConversionLut::isSupported(const KoColorSpace *srcColorSpace,
+                                          const KoColorSpace *dstColorSpace)
+{
+    if (!srcColorSpace || !dstColorSpace ||
+        !srcColorSpace->profile() || !dstColorSpace->profile()) {
+
+        return false;
+    }
+
+    if (srcColorSpace->colorModelId() != RGBAColorModelID ||
+        dstColorSpace->colorModelId() != RGBAColorModelID) {
+
+        return false;
+    }
+
+    if ((srcColorSpace->colorDepthId() != Integer8BitsColorDepthID &&
+         srcColorSpace->colorDepthId() != Integer16BitsColorDepthID) ||
+        dstColorSpace->colorDepthId() != Integer8BitsColorDepthID) {
+
+        return false;
+    }
+
+    // the conversion between equal spaces is a simple copy anyway
+    return !(*srcColorSpace == *dstColorSpace);
+}
+
+KisDisplayConversionLut::KisDisplayConversionLut(const KoColorSpace *srcColorSpace,
+                                                 const KoColorSpace *dstColorSpace,
+                                                 KoColorConversionTransformation::Intent renderingIntent,
+                                                 KoColorConversionTransformation::ConversionFlags conversionFlags)
+    : m_srcColorSpace(srcColorSpace),
+      m_dstColorSpace(dstColorSpace)
+{
+    KIS_SAFE_ASSERT_RECOVER_RETURN(isSupported(srcColorSpace, dstColorSpace));
+
+    /**
+     * The grid is converted in 16-bit spaces with the same profiles to
+     * avoid rounding the nodes of the grid to 8-bit values
+     */
+    KoColorSpaceRegistry *registry = KoColorSpaceRegistry::instance();
+
+    const KoColorSpace *srcGridColorSpace =
+        registry->colorSpace(RGBAColorModelID.id(), Integer16BitsColorDepthID.id(), srcColorSpace->profile());
+    const KoColorSpace *dstGridColorSpace =
+        registry->colorSpace(RGBAColorModelID.id(), Integer16BitsColorDepthID.id(), dstColorSpace->profile());
+
+    KIS_SAFE_ASSERT_RECOVER_RETURN(srcGridColorSpace && dstGridColorSpace);
+
+    initShaper(srcGridColorSpace, dstGridColorSpace, renderingIntent, conversionFlags);
+
+    /**
+     * The nodes of the grid are uniform in the shaped values, so the
+     * source values of the nodes are found with the inverse shaper
+     */
+    QVector<quint16> gridValues(gridSize);
+
+    for (int i = 0; i < gridSize; i++) {
+        const quint16 shapedValue = qRound(i * 65535.0 / (gridSize - 1));
+        gridValues[i] = std::lower_bound(m_shaper.constBegin(), m_shaper.constEnd(), shapedValue) -
+            m_shaper.constBegin();
+    }
+
+    const int numNodes = gridSize * gridSize * gridSize;
+
+    QVector<quint16> srcGrid(numNodes * 4);
+    QVector<quint16> dstGrid(numNodes * 4);
+
+    quint16 *node = srcGrid.data();
+
+    for (int x = 0; x < gridSize; x++) {
+        for (int y = 0; y < gridSize; y++) {
+            for (int z = 0; z < gridSize; z++) {
+                node[0] = gridValues[x];
+                node[1] = gridValues[y];
+                node[2] = gridValues[z];
+                node[3] = 0xFFFF;
+                node += 4;
+            }
+        }
+    }
+
+    srcGridColorSpace->convertPixelsTo(reinterpret_cast<const quint8*>(srcGrid.constData()),
+                                       reinterpret_cast<quint8*>(dstGrid.data()),
+                                       dstGridColorSpace, numNodes,
+                                       renderingIntent, conversionFlags);
+
+    m_table.resize(numNodes * 3);
+
+    for (int i = 0; i < numNodes; i++) {
+        m_table[i * 3 + 0] = dstGrid[i * 4 + 0];
+        m_table[i * 3 + 1] = dstGrid[i * 4 + 1];
+        m_table[i * 3 + 2] = dstGrid[i * 4 + 2];
+    }
+
+    if (!validate(srcGridColorSpace, renderingIntent, conversionFlags)) {
+        m_table.clear();
+        m_shaper.clear();
+    }
+}
+
+void KisDisplayConversionLut::initShaper(const KoColorSpace *srcGridColorSpace,
+                                         const KoColorSpace *dstGridColorSpace,
+                                         KoColorConversionTransformation::Intent renderingIntent,
+                                         KoColorConversionTransformation::ConversionFlags conversionFlags)
+{
+    const int numValues = 65536;
+
+    m_shaper.resize(numValues);
+
+    /**
+     * The shaper is the response of the conversion on the neutral
+     * axis. In the shaped values the conversion of the grays becomes
+     * linear, and the conversion of the other colors close to linear,
+     * so a coarse grid is enough even for strongly curved conversions,
+     * like the one from a linear space into a gamma-encoded monitor.
+     */
+    QVector<quint16> srcRamp(numValues * 4);
+    QVector<quint16> dstRamp(numValues * 4);
+
+    for (int i = 0; i < numValues; i++) {
+        srcRamp[i * 4 + 0] = i;
+        srcRamp[i * 4 + 1] = i;
+        srcRamp[i * 4 + 2] = i;
+        srcRamp[i * 4 + 3] = 0xFFFF;
+    }
+
+    srcGridColorSpace->convertPixelsTo(reinterpret_cast<const quint8*>(srcRamp.constData()),
+                                       reinterpret_cast<quint8*>(dstRamp.data()),
+                                       dstGridColorSpace, numValues,
+                                       renderingIntent, conversionFlags);
+
+    auto response = [&dstRamp] (int i) {
+        return (qint64(dstRamp[i * 4 + 0]) + dstRamp[i * 4 + 1] + dstRamp[i * 4 + 2]) / 3;
+    };
+
+    const qint64 black = response(0);
+    const qint64 white = response(numValues - 1);
+
+    // degenerate or inverting conversions get no shaping at all
+    if (white - black < 256) {
+        for (int i = 0; i < numValues; i++) {
+            m_shaper[i] = i;
+        }
+        return;
+    }
+
+    quint16 lastValue = 0;
+
+    for (int i = 0; i < numValues; i++) {
+        const qint64 value = ((response(i) - black) * 0xFFFF + (white - black) / 2) / (white - black);
+
+        // the shaper should be monotonic to have an inverse
+        lastValue = qMax(lastValue, quint16(qBound<qint64>(0, value, 0xFFFF)));
+        m_shaper[i] = lastValue;
+    }
+
+    m_shaper[numValues - 1] = 0xFFFF;
+}
+
+bool KisDisplayConversionLut::validate(const KoColorSpace *srcGridColorSpace,
+                                       KoColorConversionTransformation::Intent renderingIntent,
+                                       KoColorConversionTransformation::ConversionFlags conversionFlags) const
+{
+    /**
+     * The test colors are the neutral and the primary ramps (densely
+     * sampled in the shadows, where the curved conversions are the
+     * hardest for the table) and a set of pseudo-random colors
+     */
+    QVector<quint16> samples;
+
+    auto addSample = [&samples] (quint16 r, quint16 g, quint16 b) {
+        samples << r << g << b << 0xFFFF;
+    };
+
+    for (int i = 0; i < 65536; i += (i < 4096 ? 16 : 256)) {
+        addSample(i, i, i);
+        addSample(i, 0, 0);
+        addSample(0, i, 0);
+        addSample(0, 0, i);
+    }
+    addSample(0xFFFF, 0xFFFF, 0xFFFF);
+
+    quint32 seed = 1;
+    auto nextRandom = [&seed] () {
+        seed = seed * 1103515245 + 12345;
+        return quint16(seed >> 16);
+    };
+
+    for (int i = 0; i < 4096; i++) {
+        const quint16 r = nextRandom();
+        const quint16 g = nextRandom();
+        const quint16 b = nextRandom();
+        addSample(r, g, b);
+    }
+
+    const int numPixels = samples.size() / 4;
+
+    QVector<quint8> src(numPixels * m_srcColorSpace->pixelSize());
+    srcGridColorSpace->convertPixelsTo(reinterpret_cast<const quint8*>(samples.constData()),
+                                       src.data(), m_srcColorSpace, numPixels,
+                                       renderingIntent, conversionFlags);
+
+    QVector<quint8> reference(numPixels * m_dstColorSpace->pixelSize());
+    QVector<quint8> result(numPixels * m_dstColorSpace->pixelSize());
+
+    m_srcColorSpace->convertPixelsTo(src.constData(), reference.data(), m_dstColorSpace, numPixels,
+                                     renderingIntent, conversionFlags);
+    convertPixels(src.constData(), result.data(), numPixels);
+
+    for (int i = 0; i < reference.size(); i++) {
+        if (qAbs(int(reference[i]) - int(result[i])) > maxAllowedError) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool KisDisplayConversionLut::isValid() const
+{
+    return !m_table.isEmpty();
+}
+
+const KoColorSpace *KisDisplayConversionLut::srcColorSpace() const
+{
+    return m_srcColorSpace;
+}
+
+const KoColorSpace *KisDisplayConversionLut::dstColorSpace() const
+{
+    return m_dstColorSpace;
+}
+
+void KisDisplayConversionLut::convertPixels(const quint8 *src, quint8 *dst, int numPixels) const
+{
+    KIS_SAFE_ASSERT_RECOVER_RETURN(!m_table.isEmpty());
+
+    if (m_srcColorSpace->colorDepthId() == Integer8BitsColorDepthID) {
+        convertPixelsImpl<quint8>(src, dst, numPixels);
+    } else {
+        convertPixelsImpl<quint16>(src, dst, numPixels);
+    }
+}
+
+template <typename SrcChannel>
+void KisDisplayConversionLut::convertPixelsImpl(const quint8 *src, quint8 *dst, int numPixels) const
+{
+    const SrcChannel *srcPixel = reinterpret_cast<const SrcChannel*>(src);
+
+    for (int i = 0; i < numPixels; i++) {
+        interpolate(KoColorSpaceMaths<SrcChannel, quint16>::scaleToA(srcPixel[0]),
+                    KoColorSpaceMaths<SrcChannel, quint16>::scaleToA(srcPixel[1]),
+                    KoColorSpaceMaths<SrcChannel, quint16>::scaleToA(srcPixel[2]),
+                    dst);
+
+        dst[3] = KoColorSpaceMaths<SrcChannel, quint8>::scaleToA(srcPixel[3]);
+
+        srcPixel += 4;
+        dst += 4;
+    }
+}
+
+inline void KisDisplayConversionLut::interpolate(quint16 c0, quint16 c1, quint16 c2, quint8 *dst) const
+{
+    int x, y, z;
+    qint32 fx, fy, fz;
+
+    const quint16 *shaper = m_shaper.constData();
+
+    splitGridValue(shaper[c0], x, fx);
+    splitGridValue(shaper[c1], y, fy);
+    splitGridValue(shaper[c2], z, fz);
+
+    const qint32 *base = m_table.constData() + x * gridStrideX + y * gridStrideY + z * gridStrideZ;
+
+    /**
+     * Tetrahedral interpolation: walk from the base node to the opposite
+     * corner of the cell along the axes sorted by their fraction. The
+     * fractions of the walked edges are the weights.
+     */
+    int offset1, offset2;
+    qint32 weight1, weight2, weight3;
+
+    if (fx >= fy) {
+        if (fy >= fz) {
+            offset1 = gridStrideX; offset2 = gridStrideX + gridStrideY;
+            weight1 = fx; weight2 = fy; weight3 = fz;
+        } else if (fx >= fz) {
+            offset1 = gridStrideX; offset2 = gridStrideX + gridStrideZ;
+            weight1 = fx; weight2 = fz; weight3 = fy;
+        } else {
+            offset1 = gridStrideZ; offset2 = gridStrideZ + gridStrideX;
+            weight1 = fz; weight2 = fx; weight3 = fy;
+        }
+    } else {
+        if (fx >= fz) {
+            offset1 = gridStrideY; offset2 = gridStrideY + gridStrideX;
+            weight1 = fy; weight2 = fx; weight3 = fz;
+        } else if (fy >= fz) {
+            offset1 = gridStrideY; offset2 = gridStrideY + gridStrideZ;
+            weight1 = fy; weight2 = fz; weight3 = fx;
+        } else {
+            offset1 = gridStrideZ; offset2 = gridStrideZ + gridStrideY;
+            weight1 = fz; weight2 = fy; weight3 = fx;
+        }
+    }
+
+    const int offset3 = gridStrideX + gridStrideY + gridStrideZ;
+
+    for (int ch = 0; ch < 3; ch++) {
+        const qint64 v0 = base[ch];
+        const qint64 v1 = base[offset1 + ch];
+        const qint64 v2 = base[offset2 + ch];
+        const qint64 v3 = base[offset3 + ch];
+
+        const qint64 value = v0 +
+            (((v1 - v0) * (weight1 - weight2) +
+              (v2 - v0) * (weight2 - weight3) +
+              (v3 - v0) * weight3 + 0x8000) >> 16);
+
+        dst[ch] = KoColorSpaceMaths<quint16, quint8>::scaleToA(quint16(qBound<qint64>(0, value, 0xFFFF)));
+    }
+}
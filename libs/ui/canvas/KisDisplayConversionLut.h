@@ -0,0 +1,118 @@
+/*
+ *  Copyright (c) 2020 Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef KISDISPLAYCONVERSIONLUT_H
+#define KISDISPLAYCONVERSIONLUT_H
+
+#include <QVector>
+#include <QSharedPointer>
+
+#include <KoColorConversionTransformation.h>
+
+#include "kritaui_export.h"
+
+class KoColorSpace;
+
+class KisDisplayConversionLut;
+typedef QSharedPointer<KisDisplayConversionLut> KisDisplayConversionLutSP;
+
+/**
+ * A precalculated 3D lookup table for converting the image data into
+ * the monitor color space.
+ *
+ * The table stores the result of the full color conversion for a
+ * 33x33x33 grid of 16-bit color values. The pixels are converted by
+ * tetrahedral interpolation in this grid, the same way LCMS evaluates
+ * its own optimized pipelines, so the result differs from the full
+ * conversion by no more than a rounding error.
+ *
+ * Before the lookup the channels pass through a 1D shaper curve, which
+ * is the transfer curve of the conversion measured on the neutral axis.
+ * It moves the nodes of the grid where the conversion is curved, e.g.
+ * into the shadows of linear source spaces. If the table still cannot
+ * reproduce the full conversion with the rounding error precision (it
+ * is checked on a set of test colors), fetch() returns null and the
+ * full conversion should be used.
+ *
+ * Only integer RGBA source spaces and the 8-bit RGBA destination (that
+ * is, what the canvas displays) are supported. The tables are cached per
+ * (source, destination, intent, flags) combination, so they are rebuilt
+ * only when the profiles or the conversion options change.
+ */
+class KRITAUI_EXPORT KisDisplayConversionLut
+{
+public:
+    /**
+     * \return a (cached) table for the conversion or null if the
+     *         conversion is not supported or is not needed at all
+     */
+    static KisDisplayConversionLutSP fetch(const KoColorSpace *srcColorSpace,
+                                           const KoColorSpace *dstColorSpace,
+                                           KoColorConversionTransformation::Intent renderingIntent,
+                                           KoColorConversionTransformation::ConversionFlags conversionFlags);
+
+    /**
+     * Creates the table. Prefer fetch(), which returns cached tables.
+     * Check isValid() before using the created table.
+     */
+    KisDisplayConversionLut(const KoColorSpace *srcColorSpace,
+                            const KoColorSpace *dstColorSpace,
+                            KoColorConversionTransformation::Intent renderingIntent,
+                            KoColorConversionTransformation::ConversionFlags conversionFlags);
+
+    /**
+     * \return true if the table reproduces the full conversion
+     */
+    bool isValid() const;
+
+    const KoColorSpace* srcColorSpace() const;
+    const KoColorSpace* dstColorSpace() const;
+
+    /**
+     * Converts \p numPixels pixels from \p src in the source color space
+     * into \p dst in the destination color space
+     */
+    void convertPixels(const quint8 *src, quint8 *dst, int numPixels) const;
+
+    static bool isSupported(const KoColorSpace *srcColorSpace,
+                            const KoColorSpace *dstColorSpace);
+
+private:
+    template <typename SrcChannel>
+    void convertPixelsImpl(const quint8 *src, quint8 *dst, int numPixels) const;
+
+    inline void interpolate(quint16 c0, quint16 c1, quint16 c2, quint8 *dst) const;
+
+    void initShaper(const KoColorSpace *srcGridColorSpace,
+                    const KoColorSpace *dstGridColorSpace,
+                    KoColorConversionTransformation::Intent renderingIntent,
+                    KoColorConversionTransformation::ConversionFlags conversionFlags);
+
+    bool validate(const KoColorSpace *srcGridColorSpace,
+                  KoColorConversionTransformation::Intent renderingIntent,
+                  KoColorConversionTransformation::ConversionFlags conversionFlags) const;
+
+private:
+    const KoColorSpace *m_srcColorSpace;
+    const KoColorSpace *m_dstColorSpace;
+    QVector<quint16> m_shaper;
+    QVector<qint32> m_table;
+};
+
+#endif // KISDISPLAYCONVERSIONLUT_H
@@ -21,6 +21,7 @@
 
 #include "kis_canvas2.h"
 
+#include <algorithm>
 #include <functional>
 #include <numeric>
 
@@ -33,6 +34,10 @@
 #include <QDesktopWidget>
 #include <QScreen>
 #include <QWindow>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QElapsedTimer>
+#include <QSharedPointer>
 
 #include <kis_debug.h>
 
@@ -99,7 +104,11 @@
 #include "opengl/kis_opengl_canvas_debugger.h"
 
 #include "kis_algebra_2d.h"
+#include "krita_utils.h"
 #include "kis_image_signal_router.h"
+#include "kis_idle_watcher.h"
+#include "kis_spontaneous_job.h"
+#include "KisCanvasMotionPredictor.h"
 
 #include "KisSnapPixelStrategy.h"
 
@@ -117,6 +126,7 @@ public:
         , toolProxy(parent)
         , displayColorConverter(resourceManager, view)
         , regionOfInterestUpdateCompressor(100, KisSignalCompressor::FIRST_INACTIVE)
+        , staleUpdatesIdleWatcher(500 /*ms*/)
     {
     }
 
@@ -159,6 +169,47 @@ public:
     QRect renderingLimit;
     int isBatchUpdateActive = 0;
 
+    /**
+     * The updates outside staleUpdatesFilterRect (the visible area grown
+     * by 25%) are not converted into the canvas cache right away. They are
+     * accumulated in staleUpdatesRegion and are processed either when
+     * they become visible or when the image becomes idle. Empty filter
+     * rect means that all the updates are processed immediately.
+     */
+    QMutex staleUpdatesLock;
+    QRect staleUpdatesFilterRect;
+    QRegion staleUpdatesRegion;
+    KisIdleWatcher staleUpdatesIdleWatcher;
+
+    /**
+     * While the user pans or zooms the canvas, the stale updates in the
+     * area the viewport is predicted to move to are processed ahead of
+     * time. staleUpdatesPrefetchRect is the latest prediction; prefetch
+     * jobs drop the rects that left it (the prediction was wrong) back
+     * into staleUpdatesRegion. staleUpdatesPrefetchPixels is the amount
+     * of pixels scheduled for prefetching but not yet uploaded to the
+     * canvas. staleUpdatesPrefetchConvertedPixels is the part of them
+     * that has already been converted and waits in the updates
+     * compressor for the upload.
+     */
+    QRect staleUpdatesPrefetchRect;
+    QAtomicInt staleUpdatesPrefetchPixels;
+    QAtomicInt staleUpdatesPrefetchConvertedPixels;
+
+    /**
+     * The stale updates are converted by the image's workers, so the
+     * jobs may still be running (or queued) when the canvas is deleted.
+     * They access the canvas only through this handle under its lock,
+     * and the destructor of the canvas detaches it.
+     */
+    struct StaleUpdatesCanvasHandle {
+        QMutex lock;
+        KisCanvas2 *canvas = 0;
+    };
+    QSharedPointer<StaleUpdatesCanvasHandle> staleUpdatesCanvasHandle;
+    KisCanvasMotionPredictor motionPredictor;
+    QElapsedTimer motionTimer;
+
     bool effectiveLodAllowedInImage() {
         return lodAllowedInImage && !bootstrapLodBlocked;
     }
@@ -191,6 +242,33 @@ KoShapeManager* fetchShapeManagerFromNode(KisNodeSP node)
 
     return shapeManager;
 }
+
+class KisFlushStaleCanvasUpdatesJob : public KisSpontaneousJob
+{
+public:
+    KisFlushStaleCanvasUpdatesJob(std::function<void()> func, int levelOfDetail)
+        : m_func(func),
+          m_levelOfDetail(levelOfDetail)
+    {
+    }
+
+    bool overrides(const KisSpontaneousJob *otherJob) override {
+        Q_UNUSED(otherJob);
+        return false;
+    }
+
+    void run() override {
+        m_func();
+    }
+
+    int levelOfDetail() const override {
+        return m_levelOfDetail;
+    }
+
+private:
+    std::function<void()> m_func;
+    int m_levelOfDetail;
+};
 }
 
 KisCanvas2::KisCanvas2(KisCoordinatesConverter *coordConverter, KoCanvasResourceProvider *resourceManager, KisView *view, KoShapeControllerBase *sc)
@@ -203,6 +281,10 @@ KisCanvas2::KisCanvas2(KisCoordinatesConverter *coordConverter, KoCanvasResource
      * light.
      */
     m_d->bootstrapLodBlocked = true;
+
+    m_d->staleUpdatesCanvasHandle.reset(new KisCanvas2Private::StaleUpdatesCanvasHandle());
+    m_d->staleUpdatesCanvasHandle->canvas = this;
+
     connect(view->mainWindow(), SIGNAL(guiLoadingFinished()), SLOT(bootstrapFinished()));
     connect(view->mainWindow(), SIGNAL(screenChanged()), SLOT(slotConfigChanged()));
 
@@ -261,6 +343,7 @@ void KisCanvas2::setup()
     connect(this, SIGNAL(sigContinueResizeImage(qint32,qint32)), SLOT(finishResizingImage(qint32,qint32)));
 
     connect(&m_d->regionOfInterestUpdateCompressor, SIGNAL(timeout()), SLOT(slotUpdateRegionOfInterest()));
+    connect(&m_d->staleUpdatesIdleWatcher, SIGNAL(startedIdleMode()), SLOT(slotFlushStaleUpdates()));
 
     connect(m_d->view->document(), SIGNAL(sigReferenceImagesChanged()), this, SLOT(slotReferenceImagesChanged()));
 
@@ -292,6 +375,13 @@ KisCanvas2::~KisCanvas2()
     if (m_d->animationPlayer->isPlaying()) {
         m_d->animationPlayer->forcedStopOnExit();
     }
+
+    {
+        // waits for the stale updates job that is currently running (if any)
+        QMutexLocker l(&m_d->staleUpdatesCanvasHandle->lock);
+        m_d->staleUpdatesCanvasHandle->canvas = 0;
+    }
+
     delete m_d;
 }
 
@@ -575,6 +665,9 @@ void KisCanvas2::initializeImage()
     m_d->coordinatesConverter->setImage(image);
     m_d->toolProxy.initializeImage(image);
 
+    m_d->staleUpdatesIdleWatcher.setTrackedImage(image);
+    m_d->motionPredictor.reset();
+
     connect(image, SIGNAL(sigImageUpdated(QRect)), SLOT(startUpdateCanvasProjection(QRect)), Qt::DirectConnection);
     connect(image->signalRouter(), SIGNAL(sigNotifyBatchUpdateStarted()), SLOT(slotBeginUpdatesBatch()), Qt::DirectConnection);
     connect(image->signalRouter(), SIGNAL(sigNotifyBatchUpdateEnded()), SLOT(slotEndUpdatesBatch()), Qt::DirectConnection);
@@ -783,6 +876,26 @@ void KisCanvas2::finishResizingImage(qint32 w, qint32 h)
 }
 
 void KisCanvas2::startUpdateCanvasProjection(const QRect & rc)
+{
+    QRect visibleRect = rc;
+
+    {
+        QMutexLocker l(&m_d->staleUpdatesLock);
+
+        const QRect &filterRect = m_d->staleUpdatesFilterRect;
+
+        if (!filterRect.isEmpty() && !filterRect.contains(rc)) {
+            visibleRect = rc & filterRect;
+            m_d->staleUpdatesRegion += QRegion(rc).subtracted(QRegion(visibleRect));
+        }
+    }
+
+    if (!visibleRect.isEmpty()) {
+        startUpdateCanvasProjectionImpl(visibleRect);
+    }
+}
+
+void KisCanvas2::startUpdateCanvasProjectionImpl(const QRect &rc)
 {
     KisUpdateInfoSP info = m_d->canvasWidget->startUpdateCanvasProjection(rc, m_d->channelFlags);
     if (m_d->projectionUpdatesCompressor.putUpdateInfo(info)) {
@@ -810,15 +923,42 @@ void KisCanvas2::updateCanvasProjection()
     };
 
     auto uploadData = [this, tryIssueCanvasUpdates](const QVector<KisUpdateInfoSP> &infoObjects) {
+        KisLatencyTracer *tracer = KisLatencyTracer::instance();
+        KisLatencyTracer::TraceIds traceIds;
+
+        const qint64 uploadStartTime = tracer->isEnabled() ? KisLatencyTracer::now() : 0;
+
+        if (tracer->isEnabled()) {
+            Q_FOREACH (KisUpdateInfoSP info, infoObjects) {
+                if (info->traceIds().isEmpty()) continue;
+
+                tracer->addEvent(KisLatencyTracer::CanvasCompressor, info->traceIds(),
+                                 info->traceCreationTime(), uploadStartTime);
+                traceIds += info->traceIds();
+            }
+        }
+
         QVector<QRect> viewportRects = m_d->canvasWidget->updateCanvasProjection(infoObjects);
         const QRect vRect = std::accumulate(viewportRects.constBegin(), viewportRects.constEnd(),
                                             QRect(), std::bit_or<QRect>());
 
+        if (!traceIds.isEmpty()) {
+            const qint64 uploadEndTime = KisLatencyTracer::now();
+            tracer->addEvent(KisLatencyTracer::CanvasUpload, traceIds, uploadStartTime, uploadEndTime);
+            tracer->finishTraces(traceIds, uploadEndTime);
+        }
+
         tryIssueCanvasUpdates(vRect);
     };
 
     bool shouldExplicitlyIssueUpdates = false;
 
+    /**
+     * The prefetched updates are put into the compressor before they are
+     * counted as converted, so all the counted ones are uploaded below
+     */
+    const int prefetchedPixels = m_d->staleUpdatesPrefetchConvertedPixels.fetchAndStoreOrdered(0);
+
     QVector<KisUpdateInfoSP> infoObjects;
     KisUpdateInfoList originalInfoObjects;
     m_d->projectionUpdatesCompressor.takeUpdateInfo(originalInfoObjects);
@@ -860,6 +1000,10 @@ void KisCanvas2::updateCanvasProjection()
     } else if (shouldExplicitlyIssueUpdates) {
         tryIssueCanvasUpdates(m_d->coordinatesConverter->imageRectInImagePixels());
     }
+
+    if (prefetchedPixels) {
+        m_d->staleUpdatesPrefetchPixels.fetchAndAddOrdered(-prefetchedPixels);
+    }
 }
 
 void KisCanvas2::slotBeginUpdatesBatch()
@@ -962,6 +1106,8 @@ void KisCanvas2::notifyZoomChanged()
     updateCanvas(); // update the canvas, because that isn't done when zooming using KoZoomAction
 
     m_d->regionOfInterestUpdateCompressor.start();
+
+    prefetchStaleUpdates();
 }
 
 QRect KisCanvas2::regionOfInterest() const
@@ -983,6 +1129,212 @@ void KisCanvas2::slotUpdateRegionOfInterest()
     if (m_d->regionOfInterest != oldRegionOfInterest) {
         emit sigRegionOfInterestChanged(m_d->regionOfInterest);
     }
+
+    updateStaleUpdatesFilter();
+}
+
+void KisCanvas2::updateStaleUpdatesFilter()
+{
+    /**
+     * The region of interest is reset to the whole image as soon as
+     * the viewport comes close to the image border, so the filter is
+     * calculated from the viewport itself.
+     *
+     * In wrap-around mode the image is visible outside the viewport
+     * rect, so all the updates should be processed immediately
+     */
+    const QRect filterRect = !wrapAroundViewingMode() ?
+        KisCanvasMotionPredictor::staleUpdatesFilterRect(
+            m_d->coordinatesConverter->widgetRectInImagePixels(),
+            m_d->coordinatesConverter->imageRectInImagePixels()) :
+        QRect();
+
+    {
+        QMutexLocker l(&m_d->staleUpdatesLock);
+        m_d->staleUpdatesFilterRect = filterRect;
+    }
+
+    flushStaleUpdates(filterRect);
+}
+
+void KisCanvas2::slotFlushStaleUpdates()
+{
+    flushStaleUpdates(QRect());
+}
+
+void KisCanvas2::flushStaleUpdates(const QRect &rc)
+{
+    QVector<QRect> rects;
+
+    {
+        QMutexLocker l(&m_d->staleUpdatesLock);
+
+        const QRegion region = rc.isEmpty() ?
+            m_d->staleUpdatesRegion : m_d->staleUpdatesRegion & rc;
+
+        if (region.isEmpty()) return;
+
+        m_d->staleUpdatesRegion -= region;
+        rects = region.rects();
+    }
+
+    scheduleStaleUpdates(rects, false);
+}
+
+void KisCanvas2::prefetchStaleUpdates()
+{
+    /**
+     * How far ahead (in ms) the viewport motion is extrapolated. It
+     * should be comparable with the time needed to convert and upload
+     * the tiles, otherwise they will still be missing when the viewport
+     * arrives.
+     */
+    const int lookAhead = 300;
+
+    /**
+     * The memory budget of the prefetching: every prefetched pixel holds
+     * a converted copy of the image data until it is uploaded to the
+     * canvas. 4M pixels are about 16 MiB of 8-bit data.
+     */
+    const int maxPrefetchPixels = 4 * 1024 * 1024;
+
+    if (!m_d->motionTimer.isValid()) {
+        m_d->motionTimer.start();
+    }
+
+    const QRectF visibleRect = m_d->coordinatesConverter->widgetRectInImagePixels();
+    m_d->motionPredictor.addSample(visibleRect, m_d->motionTimer.elapsed());
+
+    if (!m_d->motionPredictor.isMoving()) return;
+
+    const QRect imageRect = m_d->coordinatesConverter->imageRectInImagePixels();
+    const QRect predictedRect = m_d->motionPredictor.prefetchRect(lookAhead, imageRect);
+
+    QVector<QRect> rects;
+
+    {
+        QMutexLocker l(&m_d->staleUpdatesLock);
+
+        m_d->staleUpdatesPrefetchRect = predictedRect;
+
+        if (m_d->staleUpdatesFilterRect.isEmpty()) return;
+
+        const QRegion region = m_d->staleUpdatesRegion & predictedRect;
+        if (region.isEmpty()) return;
+
+        /**
+         * The region is split into tile-sized patches, so that a single
+         * huge rect would neither exhaust the budget nor block the
+         * smaller rects from being prefetched
+         */
+        const int patchSize = KisConfig(true).openGLTextureSize();
+        rects = KritaUtils::splitRegionIntoPatches(region, QSize(patchSize, patchSize));
+
+        /**
+         * The rects closest to the current viewport are needed first
+         */
+        const QPointF center = visibleRect.center();
+        std::sort(rects.begin(), rects.end(),
+                  [center] (const QRect &lhs, const QRect &rhs) {
+                      return kisSquareDistance(QPointF(lhs.center()), center) <
+                          kisSquareDistance(QPointF(rhs.center()), center);
+                  });
+
+        int budget = maxPrefetchPixels - m_d->staleUpdatesPrefetchPixels;
+        QVector<QRect> fittingRects;
+
+        Q_FOREACH (const QRect &rc, rects) {
+            const int area = rc.width() * rc.height();
+            if (area > budget) continue;
+
+            budget -= area;
+            fittingRects << rc;
+        }
+
+        rects = fittingRects;
+        if (rects.isEmpty()) return;
+
+        Q_FOREACH (const QRect &rc, rects) {
+            m_d->staleUpdatesRegion -= rc;
+            m_d->staleUpdatesPrefetchPixels.fetchAndAddOrdered(rc.width() * rc.height());
+        }
+    }
+
+    scheduleStaleUpdates(rects, true);
+}
+
+bool KisCanvas2::acceptPrefetchedUpdate(const QRect &rc)
+{
+    QMutexLocker l(&m_d->staleUpdatesLock);
+
+    const bool isNeeded =
+        m_d->staleUpdatesFilterRect.isEmpty() ||
+        m_d->staleUpdatesFilterRect.intersects(rc) ||
+        m_d->staleUpdatesPrefetchRect.intersects(rc);
+
+    if (!isNeeded) {
+        m_d->staleUpdatesRegion += rc;
+        m_d->staleUpdatesPrefetchPixels.fetchAndAddOrdered(-rc.width() * rc.height());
+    }
+
+    return isNeeded;
+}
+
+void KisCanvas2::scheduleStaleUpdates(const QVector<QRect> &rects, bool isPrefetch)
+{
+    KisImageSP image = this->image();
+
+    if (!image) {
+        if (isPrefetch) {
+            QMutexLocker l(&m_d->staleUpdatesLock);
+
+            Q_FOREACH (const QRect &rc, rects) {
+                m_d->staleUpdatesRegion += rc;
+                m_d->staleUpdatesPrefetchPixels.fetchAndAddOrdered(-rc.width() * rc.height());
+            }
+        }
+        return;
+    }
+
+    /**
+     * The conversion of the stale updates is done by the image's
+     * workers, exactly like for the normal updates, to not block the
+     * GUI thread.
+     */
+    QSharedPointer<KisCanvas2Private::StaleUpdatesCanvasHandle> handle =
+        m_d->staleUpdatesCanvasHandle;
+
+    image->addSpontaneousJob(
+        new KisFlushStaleCanvasUpdatesJob(
+            [handle, rects, isPrefetch] () {
+                QMutexLocker l(&handle->lock);
+
+                KisCanvas2 *canvas = handle->canvas;
+                if (!canvas) return;
+
+                bool hasPrefetchedUpdates = false;
+
+                Q_FOREACH (const QRect &rc, rects) {
+                    if (!isPrefetch) {
+                        canvas->startUpdateCanvasProjectionImpl(rc);
+                    } else if (canvas->acceptPrefetchedUpdate(rc)) {
+                        canvas->startUpdateCanvasProjectionImpl(rc);
+
+                        // the budget is released when the update is uploaded
+                        canvas->m_d->staleUpdatesPrefetchConvertedPixels.fetchAndAddOrdered(rc.width() * rc.height());
+                        hasPrefetchedUpdates = true;
+                    }
+                }
+
+                /**
+                 * The upload may have started before the pixels were
+                 * counted, so request one more to release the budget
+                 */
+                if (hasPrefetchedUpdates) {
+                    emit canvas->sigCanvasCacheUpdated();
+                }
+            },
+            image->currentLevelOfDetail()));
 }
 
 void KisCanvas2::slotReferenceImagesChanged()
@@ -1081,6 +1433,8 @@ void KisCanvas2::documentOffsetMoved(const QPoint &documentOffset)
     updateCanvas();
 
     m_d->regionOfInterestUpdateCompressor.start();
+
+    prefetchStaleUpdates();
 }
 
 void KisCanvas2::slotConfigChanged()
@@ -1222,6 +1576,8 @@ void KisCanvas2::setWrapAroundViewingMode(bool value)
     }
 
     m_d->canvasWidget->setWrapAroundViewingMode(value);
+
+    updateStaleUpdatesFilter();
 }
 
 bool KisCanvas2::wrapAroundViewingMode() const
@@ -305,6 +305,8 @@ private Q_SLOTS:
     void slotReferenceImagesChanged();
 
     void slotImageColorSpaceChanged();
+
+    void slotFlushStaleUpdates();
 public:
 
     bool isPopupPaletteVisible() const;
@@ -335,6 +337,13 @@ private:
 
     void notifyLevelOfDetailChange();
 
+    void startUpdateCanvasProjectionImpl(const QRect &rc);
+    void updateStaleUpdatesFilter();
+    void flushStaleUpdates(const QRect &rc);
+    void prefetchStaleUpdates();
+    bool acceptPrefetchedUpdate(const QRect &rc);
+    void scheduleStaleUpdates(const QVector<QRect> &rects, bool isPrefetch);
+
     // Completes construction of canvas.
     // To be called by KisView in its constructor, once it has been setup enough
     // (to be defined what that means) for things KisCanvas2 expects from KisView
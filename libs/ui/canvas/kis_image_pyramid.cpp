@@ -18,6 +18,7 @@
 #include "kis_image_pyramid.h"
 
 #include <QBitArray>
+#include <QtConcurrentMap>
 #include <KoChannelInfo.h>
 #include <KoCompositeOp.h>
 #include <KoColorSpaceRegistry.h>
@@ -32,6 +33,8 @@
 #include "kis_debug.h"
 #include "kis_config.h"
 #include "kis_image_config.h"
+#include "krita_utils.h"
+#include "KisDisplayConversionLut.h"
 
 //#define DEBUG_PYRAMID
 
@@ -56,6 +59,46 @@
 #define ceiledSize(sz) QSize(ceil((sz).width()), ceil((sz).height()))
 #define isOdd(x) ((x) & 0x01)
 
+/**
+ * Size of the patches the pyramid is processed in when several threads
+ * are used. It is a multiple of the tile size, so the threads never write
+ * into the same tile.
+ */
+const qint32 PARALLEL_PATCH_SIZE = 256;
+
+/**
+ * Updates smaller than that are processed in the calling thread
+ */
+const qint32 MIN_PARALLEL_AREA = 256 * 256;
+
+/**
+ * Unpacks four 8-bit channels of a pixel into four 16-bit
+ * lanes of a 64-bit integer
+ */
+inline quint64 unpackPixel(const quint8 *src)
+{
+    quint32 pixel;
+    memcpy(&pixel, src, sizeof(pixel));
+
+    quint64 value = pixel;
+    value = (value | (value << 16)) & 0x0000FFFF0000FFFFULL;
+    value = (value | (value << 8)) & 0x00FF00FF00FF00FFULL;
+    return value;
+}
+
+/**
+ * Packs the lowest 8 bits of every 16-bit lane back into a pixel
+ */
+inline void packPixel(quint64 value, quint8 *dst)
+{
+    value &= 0x00FF00FF00FF00FFULL;
+    value = (value | (value >> 8)) & 0x0000FFFF0000FFFFULL;
+    value = (value | (value >> 16)) & 0x00000000FFFFFFFFULL;
+
+    const quint32 pixel = value;
+    memcpy(dst, &pixel, sizeof(pixel));
+}
+
 /**
  * Aligns @p value to the lowest integer not smaller than @p value and
  * that is a divident of alignment
@@ -191,22 +234,8 @@ void KisImagePyramid::setImage(KisImageWSP newImage)
             retrieveImageData(rc);
         }
         else {
-            qint32 firstCol = rc.x() / patchWidth;
-            qint32 firstRow = rc.y() / patchHeight;
-
-            qint32 lastCol = (rc.x() + rc.width()) / patchWidth;
-            qint32 lastRow = (rc.y() + rc.height()) / patchHeight;
-
-            for(qint32 i = firstRow; i <= lastRow; i++) {
-                for(qint32 j = firstCol; j <= lastCol; j++) {
-                    QRect maxPatchRect(j * patchWidth,
-                                       i * patchHeight,
-                                       patchWidth, patchHeight);
-                    QRect patchRect = rc & maxPatchRect;
-                    retrieveImageData(patchRect);
-                }
-            }
-
+            retrieveImageDataInPatches(
+                KritaUtils::splitRectIntoPatches(rc, QSize(patchWidth, patchHeight)));
         }
         //TODO: check whether there is needed recalculateCache()
     }
@@ -221,7 +250,44 @@ void KisImagePyramid::setImageSize(qint32 w, qint32 h)
 
 void KisImagePyramid::updateCache(const QRect &dirtyImageRect)
 {
-    retrieveImageData(dirtyImageRect);
+    if (dirtyImageRect.width() * dirtyImageRect.height() < MIN_PARALLEL_AREA) {
+        retrieveImageData(dirtyImageRect);
+    } else {
+        retrieveImageDataInPatches(
+            KritaUtils::splitRectIntoPatches(dirtyImageRect,
+                                             QSize(PARALLEL_PATCH_SIZE, PARALLEL_PATCH_SIZE)));
+    }
+}
+
+void KisImagePyramid::retrieveImageDataInPatches(const QVector<QRect> &patches)
+{
+    /**
+     * The display filter is not guaranteed to be reentrant,
+     * so convert the data in the calling thread when it is active
+     */
+    const bool useDisplayFilter =
+        m_displayFilter && m_useOcio &&
+        m_originalImage->projection()->colorSpace()->colorModelId() == RGBAColorModelID;
+
+    if (useDisplayFilter || patches.size() < 2) {
+        Q_FOREACH (const QRect &rc, patches) {
+            retrieveImageData(rc);
+        }
+        return;
+    }
+
+    /**
+     * retrieveImageData() may reset the channel flags when they don't
+     * match the color space. Do that before spawning the threads.
+     */
+    if (m_channelFlags.size() != m_originalImage->projection()->colorSpace()->channelCount()) {
+        setChannelFlags(QBitArray());
+    }
+
+    QtConcurrent::blockingMap(patches,
+        [this] (const QRect &rc) {
+            retrieveImageData(rc);
+        });
 }
 
 void KisImagePyramid::retrieveImageData(const QRect &rect)
@@ -325,7 +391,16 @@ void KisImagePyramid::retrieveImageData(const QRect &rect)
         }
 
         QScopedArrayPointer<quint8> dst(new quint8[m_monitorColorSpace->pixelSize() * numPixels]);
-        projectionCs->convertPixelsTo(originalBytes.data(), dst.data(), m_monitorColorSpace, numPixels, m_renderingIntent, m_conversionFlags);
+
+        KisDisplayConversionLutSP conversionLut =
+            KisDisplayConversionLut::fetch(projectionCs, m_monitorColorSpace, m_renderingIntent, m_conversionFlags);
+
+        if (conversionLut) {
+            conversionLut->convertPixels(originalBytes.data(), dst.data(), numPixels);
+        } else {
+            projectionCs->convertPixelsTo(originalBytes.data(), dst.data(), m_monitorColorSpace, numPixels, m_renderingIntent, m_conversionFlags);
+        }
+
         originalBytes.swap(dst);
     }
 
@@ -377,6 +452,35 @@ QRect KisImagePyramid::downsampleByFactor2(const QRect& srcRect,
     qint32 dstWidth = srcWidth / 2;
     qint32 dstHeight = srcHeight / 2;
 
+    const QRect dstRect(dstX, dstY, dstWidth, dstHeight);
+
+    if (dstWidth * dstHeight < MIN_PARALLEL_AREA) {
+        downsamplePatch(dstRect, src, dst);
+    } else {
+        const QVector<QRect> patches =
+            KritaUtils::splitRectIntoPatches(dstRect,
+                                             QSize(PARALLEL_PATCH_SIZE, PARALLEL_PATCH_SIZE));
+
+        QtConcurrent::blockingMap(patches,
+            [this, src, dst] (const QRect &rc) {
+                downsamplePatch(rc, src, dst);
+            });
+    }
+
+    return dstRect;
+}
+
+void KisImagePyramid::downsamplePatch(const QRect &dstRect,
+                                      KisPaintDevice *src,
+                                      KisPaintDevice *dst)
+{
+    qint32 dstX, dstY, dstWidth, dstHeight;
+    dstRect.getRect(&dstX, &dstY, &dstWidth, &dstHeight);
+
+    const qint32 srcX = dstX * 2;
+    const qint32 srcY = dstY * 2;
+    const qint32 srcWidth = dstWidth * 2;
+
     KisHLineConstIteratorSP srcIt0 = src->createHLineConstIteratorNG(srcX, srcY, srcWidth);
     KisHLineConstIteratorSP srcIt1 = src->createHLineConstIteratorNG(srcX, srcY + 1, srcWidth);
     KisHLineIteratorSP dstIt = dst->createHLineIteratorNG(dstX, dstY, dstWidth);
@@ -403,7 +507,6 @@ QRect KisImagePyramid::downsampleByFactor2(const QRect& srcRect,
         srcIt1->nextRow();
         dstIt->nextRow();
     }
-    return QRect(dstX, dstY, dstWidth, dstHeight);
 }
 
 void  KisImagePyramid::downsamplePixels(const quint8 *srcRow0,
@@ -412,26 +515,20 @@ void  KisImagePyramid::downsamplePixels(const quint8 *srcRow0,
                                         qint32 numSrcPixels)
 {
     /**
-     * FIXME (mandatory): Use SSE and friends here.
+     * All four channels are averaged at once: every channel gets its
+     * own 16-bit lane of a 64-bit integer, so the sum of four pixels
+     * cannot overflow into the neighbouring channel. The result is
+     * exactly the same as of the per-channel (a + b + c + d) / 4.
      */
 
-    qint16 b = 0;
-    qint16 g = 0;
-    qint16 r = 0;
-    qint16 a = 0;
-
     static const qint32 pixelSize = 4; // This is preview argb8 mode
 
     for (qint32 i = 0; i < numSrcPixels / 2; i++) {
-        b = srcRow0[0] + srcRow1[0] + srcRow0[4] + srcRow1[4];
-        g = srcRow0[1] + srcRow1[1] + srcRow0[5] + srcRow1[5];
-        r = srcRow0[2] + srcRow1[2] + srcRow0[6] + srcRow1[6];
-        a = srcRow0[3] + srcRow1[3] + srcRow0[7] + srcRow1[7];
-
-        dstRow[0] = b / 4;
-        dstRow[1] = g / 4;
-        dstRow[2] = r / 4;
-        dstRow[3] = a / 4;
+        const quint64 sum =
+            unpackPixel(srcRow0) + unpackPixel(srcRow0 + pixelSize) +
+            unpackPixel(srcRow1) + unpackPixel(srcRow1 + pixelSize);
+
+        packPixel(sum >> 2, dstRow);
 
         dstRow += pixelSize;
         srcRow0 += 2 * pixelSize;
@@ -29,7 +29,7 @@
 #include "kis_projection_backend.h"
 
 
-class KisImagePyramid : QObject, public KisProjectionBackend
+class KRITAUI_EXPORT KisImagePyramid : QObject, public KisProjectionBackend
 {
     Q_OBJECT
 
@@ -76,6 +76,13 @@ public:
 private:
 
     void retrieveImageData(const QRect &rect);
+
+    /**
+     * Retrieves the image data for every patch. The patches are
+     * processed in parallel whenever it is safe to do so.
+     */
+    void retrieveImageDataInPatches(const QVector<QRect> &patches);
+
     void rebuildPyramid();
     void clearPyramid();
 
@@ -87,6 +94,13 @@ private:
     QRect downsampleByFactor2(const QRect& srcRect,
                               KisPaintDevice* src, KisPaintDevice* dst);
 
+    /**
+     * Fills @dstRect of @dst paint device with the downsampled
+     * pixels of @src. Different patches can be processed concurrently.
+     */
+    void downsamplePatch(const QRect &dstRect,
+                         KisPaintDevice* src, KisPaintDevice* dst);
+
     /**
      * Auxiliary function. Downsamples two lines in @srcRow0
      * and @srcRow1 into one line @dstRow
@@ -33,7 +33,7 @@ class KisDisplayFilter;
  * More than that this object can perform some scaling operations
  * that are based on "patches" paradigm
  */
-class KisProjectionBackend
+class KRITAUI_EXPORT KisProjectionBackend
 {
 public:
     virtual ~KisProjectionBackend();
@@ -30,13 +30,30 @@ struct KisUpdateInfoSPStaticRegistrar {
 static KisUpdateInfoSPStaticRegistrar __registrar;
 
 KisUpdateInfo::KisUpdateInfo()
+    : m_traceCreationTime(0)
 {
+    if (KisLatencyTracer::instance()->isEnabled()) {
+        m_traceIds = KisLatencyTracer::currentTraces();
+        if (!m_traceIds.isEmpty()) {
+            m_traceCreationTime = KisLatencyTracer::now();
+        }
+    }
 }
 
 KisUpdateInfo::~KisUpdateInfo()
 {
 }
 
+const KisLatencyTracer::TraceIds &KisUpdateInfo::traceIds() const
+{
+    return m_traceIds;
+}
+
+qint64 KisUpdateInfo::traceCreationTime() const
+{
+    return m_traceCreationTime;
+}
+
 QRect KisUpdateInfo::dirtyViewportRect()
 {
     return QRect();
@@ -27,6 +27,7 @@
 #include "opengl/kis_texture_tile_update_info.h"
 
 #include "kis_ui_types.h"
+#include "KisLatencyTracer.h"
 
 class KRITAUI_EXPORT KisUpdateInfo : public KisShared
 {
@@ -37,6 +38,22 @@ public:
     virtual QRect dirtyViewportRect();
     virtual QRect dirtyImageRect() const = 0;
     virtual int levelOfDetail() const = 0;
+
+    /**
+     * The latency traces that were current in the thread where
+     * the update info has been created
+     */
+    const KisLatencyTracer::TraceIds& traceIds() const;
+
+    /**
+     * The time when the update info has been created (in microseconds,
+     * see KisLatencyTracer::now()). Valid only when traceIds() is not empty.
+     */
+    qint64 traceCreationTime() const;
+
+private:
+    KisLatencyTracer::TraceIds m_traceIds;
+    qint64 m_traceCreationTime;
 };
 
 Q_DECLARE_METATYPE(KisUpdateInfoSP)
@@ -87,7 +104,7 @@ private:
 };
 
 
-class KisPPUpdateInfo : public KisUpdateInfo
+class KRITAUI_EXPORT KisPPUpdateInfo : public KisUpdateInfo
 {
 public:
     enum TransferType {
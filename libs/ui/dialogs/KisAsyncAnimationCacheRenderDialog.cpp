@@ -63,7 +63,8 @@ QList<int> calcDirtyFramesList(KisAnimationFrameCacheSP cache, const KisTimeRang
 
 }
 
-int KisAsyncAnimationCacheRenderDialog::calcFirstDirtyFrame(KisAnimationFrameCacheSP cache, const KisTimeRange &playbackRange, const KisTimeRange &skipRange)
+int KisAsyncAnimationCacheRenderDialog::calcFirstDirtyFrame(KisAnimationFrameCacheSP cache, const KisTimeRange &playbackRange, const KisTimeRange &skipRange,
+                                                            const QSet<int> &framesInProgress)
 {
     int result = -1;
 
@@ -87,7 +88,9 @@ int KisAsyncAnimationCacheRenderDialog::calcFirstDirtyFrame(KisAnimationFrameCac
                 }
             }
 
-            if (cache->frameStatus(frame) != KisAnimationFrameCache::Cached) {
+            if (cache->frameStatus(frame) != KisAnimationFrameCache::Cached &&
+                !framesInProgress.contains(frame)) {
+
                 result = frame;
                 break;
             }
@@ -22,6 +22,8 @@
 #include "KisAsyncAnimationRenderDialogBase.h"
 #include "kis_types.h"
 
+#include <QSet>
+
 
 class KisAsyncAnimationCacheRenderDialog : public KisAsyncAnimationRenderDialogBase
 {
@@ -29,7 +31,13 @@ public:
     KisAsyncAnimationCacheRenderDialog(KisAnimationFrameCacheSP cache, const KisTimeRange &range, int busyWait = 200);
     ~KisAsyncAnimationCacheRenderDialog();
 
-    static int calcFirstDirtyFrame(KisAnimationFrameCacheSP cache, const KisTimeRange &playbackRange, const KisTimeRange &skipRange);
+    /**
+     * @return the first frame in \p playbackRange that is not cached yet, skipping
+     *         the frames in \p skipRange and \p framesInProgress, or -1 if all of
+     *         them are cached
+     */
+    static int calcFirstDirtyFrame(KisAnimationFrameCacheSP cache, const KisTimeRange &playbackRange, const KisTimeRange &skipRange,
+                                   const QSet<int> &framesInProgress = QSet<int>());
 
 protected:
     QList<int> calcDirtyFrames() const override;
@@ -111,6 +111,15 @@ public:
      */
     bool batchMode() const;
 
+    /**
+     * @brief calculates how many clones of \p image fit into the memory
+     *        limit set by the user
+     *
+     * The memory overhead of a clone is estimated using "projections"
+     * metric of the statistics server.
+     */
+    static int calculateNumberMemoryAllowedClones(KisImageSP image);
+
 private Q_SLOTS:
     void slotFrameCompleted(int frame);
     void slotFrameCancelled(int frame);
@@ -19,10 +19,13 @@
 #include "kis_animation_cache_populator.h"
 
 #include <functional>
+#include <memory>
+#include <vector>
 
 #include <QTimer>
 #include <QMutex>
 #include <QtConcurrent>
+#include <QtMath>
 
 #include "kis_config.h"
 #include "kis_config_notifier.h"
@@ -39,6 +42,7 @@
 #include "KisViewManager.h"
 #include "kis_node_manager.h"
 #include "kis_keyframe_channel.h"
+#include "kis_image_config.h"
 
 #include "KisAsyncAnimationCacheRenderer.h"
 #include "dialogs/KisAsyncAnimationCacheRenderDialog.h"
@@ -69,6 +73,36 @@ struct KisAnimationCachePopulator::Private
     KisAsyncAnimationCacheRenderer regenerator;
     bool calculateAnimationCacheInBackground = true;
 
+    /**
+     * The helpers regenerate other frames of the same cache concurrently
+     * with the main regenerator. Each of them works on its own clone of
+     * the image, the way KisAsyncAnimationRenderDialogBase does it. The
+     * clones are dropped as soon as the frames of the original image
+     * change or there is nothing left to regenerate.
+     */
+    struct HelperRenderer {
+        HelperRenderer(KisImageSP _image)
+            : renderer(new KisAsyncAnimationCacheRenderer()),
+              image(_image)
+        {
+        }
+
+        std::unique_ptr<KisAsyncAnimationCacheRenderer> renderer;
+        KisImageSP image;
+        int frame = -1;
+    };
+
+    std::vector<HelperRenderer> helpers;
+    KisAnimationFrameCacheSP helpersCache;
+    KisTimeRange helpersSkipRange;
+    KisSignalAutoConnectionsStore helpersConnections;
+
+    /**
+     * The frames being regenerated by the main regenerator
+     * or by the helpers right now
+     */
+    QSet<int> framesInProgress;
+
 
 
     enum State {
@@ -179,15 +213,156 @@ struct KisAnimationCachePopulator::Private
         KisImageAnimationInterface *animation = image->animationInterface();
         KisTimeRange currentRange = animation->fullClipRange();
 
-        const int frame = KisAsyncAnimationCacheRenderDialog::calcFirstDirtyFrame(cache, currentRange, skipRange);
+        const int frame = KisAsyncAnimationCacheRenderDialog::calcFirstDirtyFrame(cache, currentRange, skipRange, framesInProgress);
 
         if (frame >= 0) {
-            return regenerate(cache, frame);
+            if (state == WaitingForFrame) return false;
+
+            // the clones should be created before the image starts
+            // switching its time in the main regenerator
+            initializeHelpers(cache, skipRange, frame);
+
+            const bool result = regenerate(cache, frame);
+
+            if (result) {
+                startHelpers();
+            }
+
+            return result;
         }
 
         return false;
     }
 
+    void initializeHelpers(KisAnimationFrameCacheSP cache, const KisTimeRange &skipRange, int mainFrame)
+    {
+        if (helpersCache == cache) {
+            helpersSkipRange = skipRange;
+            return;
+        }
+
+        dropHelpers();
+
+        KisImageSP image = cache->image();
+        if (!image) return;
+
+        // there should be at least one more frame to regenerate
+        const KisTimeRange range = image->animationInterface()->fullClipRange();
+        QSet<int> busyFrames = framesInProgress;
+        busyFrames.insert(mainFrame);
+        if (KisAsyncAnimationCacheRenderDialog::calcFirstDirtyFrame(cache, range, skipRange, busyFrames) < 0) return;
+
+        KisImageConfig cfg(true);
+
+        const int numAllowedHelpers =
+            KisAsyncAnimationRenderDialogBase::calculateNumberMemoryAllowedClones(image);
+        const int numHelpers = qMin(cfg.frameRenderingClones() - 1, numAllowedHelpers);
+        if (numHelpers <= 0) return;
+
+        const int numThreadsPerWorker = qMax(1, qCeil(qreal(cfg.maxNumberOfThreads()) / (numHelpers + 1)));
+
+        /**
+         * The image can be cloned only when no stroke is running. If the
+         * user is painting, the helpers will be created on the next round.
+         */
+        if (!image->tryBarrierLock(true)) return;
+
+        for (int i = 0; i < numHelpers; i++) {
+            KisImageSP clone = image->clone(true);
+            clone->setWorkingThreadsLimit(numThreadsPerWorker);
+
+            helpers.emplace_back(clone);
+            HelperRenderer &helper = helpers.back();
+
+            QObject::connect(helper.renderer.get(), SIGNAL(sigFrameCompleted(int)), q, SLOT(slotHelperFrameCompleted(int)));
+            QObject::connect(helper.renderer.get(), SIGNAL(sigFrameCancelled(int)), q, SLOT(slotHelperFrameCancelled(int)));
+        }
+
+        image->unlock();
+
+        helpersCache = cache;
+        helpersSkipRange = skipRange;
+
+        helpersConnections.addConnection(image->animationInterface(), SIGNAL(sigFramesChanged(KisTimeRange,QRect)),
+                                         q, SLOT(slotHelpersInvalidated()));
+    }
+
+    void startHelpers()
+    {
+        if (!helpersCache) return;
+
+        // the helpers pause together with the main regenerator
+        if (state != WaitingForFrame && state != BetweenFrames) return;
+
+        KisImageSP image = helpersCache->image();
+        if (!image) {
+            dropHelpers();
+            return;
+        }
+
+        const KisTimeRange range = image->animationInterface()->fullClipRange();
+        bool hasActiveHelpers = false;
+
+        for (auto &helper : helpers) {
+            if (!helper.renderer->isActive()) {
+                const int frame =
+                    KisAsyncAnimationCacheRenderDialog::calcFirstDirtyFrame(helpersCache, range,
+                                                                            helpersSkipRange,
+                                                                            framesInProgress);
+                if (frame < 0) continue;
+
+                helper.frame = frame;
+                framesInProgress.insert(frame);
+
+                helper.renderer->setFrameCache(helpersCache);
+                helper.renderer->startFrameRegeneration(helper.image, frame);
+            }
+
+            hasActiveHelpers = true;
+        }
+
+        if (!hasActiveHelpers) {
+            dropHelpers();
+        }
+    }
+
+    void finishHelperFrame(int frame)
+    {
+        framesInProgress.remove(frame);
+
+        for (auto &helper : helpers) {
+            if (helper.frame == frame) {
+                helper.frame = -1;
+                break;
+            }
+        }
+    }
+
+    void dropHelpers()
+    {
+        helpersConnections.clear();
+
+        for (auto &helper : helpers) {
+            helper.renderer->disconnect(q);
+
+            if (helper.renderer->isActive()) {
+                helper.renderer->cancelCurrentFrameRendering();
+            }
+
+            if (helper.frame >= 0) {
+                framesInProgress.remove(helper.frame);
+            }
+
+            // wait until the cancelled regeneration stroke is finished
+            helper.image->barrierLock(true);
+            helper.image->unlock();
+        }
+
+        helpers.clear();
+        helpersCache.clear();
+        helpersSkipRange = KisTimeRange();
+    }
+
     bool regenerate(KisAnimationFrameCacheSP cache, int frame)
     {
         if (state == WaitingForFrame) {
@@ -202,6 +377,7 @@ struct KisAnimationCachePopulator::Private
          */
         enterState(WaitingForFrame);
 
+        framesInProgress.insert(frame);
         regenerator.setFrameCache(cache);
 
         // if we ever decide to add ROI to background cache
@@ -270,15 +446,17 @@ KisAnimationCachePopulator::KisAnimationCachePopulator(KisPart *part)
 {
     connect(&m_d->timer, SIGNAL(timeout()), this, SLOT(slotTimer()));
 
-    connect(&m_d->regenerator, SIGNAL(sigFrameCancelled(int)), SLOT(slotRegeneratorFrameCancelled()));
-    connect(&m_d->regenerator, SIGNAL(sigFrameCompleted(int)), SLOT(slotRegeneratorFrameReady()));
+    connect(&m_d->regenerator, SIGNAL(sigFrameCancelled(int)), SLOT(slotRegeneratorFrameCancelled(int)));
+    connect(&m_d->regenerator, SIGNAL(sigFrameCompleted(int)), SLOT(slotRegeneratorFrameReady(int)));
 
     connect(KisConfigNotifier::instance(), SIGNAL(configChanged()), SLOT(slotConfigChanged()));
     slotConfigChanged();
 }
 
 KisAnimationCachePopulator::~KisAnimationCachePopulator()
-{}
+{
+    m_d->dropHelpers();
+}
 
 bool KisAnimationCachePopulator::regenerate(KisAnimationFrameCacheSP cache, int frame)
 {
@@ -298,20 +476,46 @@ void KisAnimationCachePopulator::slotRequestRegeneration()
     m_d->enterState(Private::WaitingForIdle);
 }
 
-void KisAnimationCachePopulator::slotRegeneratorFrameCancelled()
+void KisAnimationCachePopulator::slotRegeneratorFrameCancelled(int frame)
 {
+    m_d->framesInProgress.remove(frame);
+
     KIS_ASSERT_RECOVER_RETURN(m_d->state == Private::WaitingForFrame);
     m_d->enterState(Private::NotWaitingForAnything);
+    m_d->dropHelpers();
 }
 
-void KisAnimationCachePopulator::slotRegeneratorFrameReady()
+void KisAnimationCachePopulator::slotRegeneratorFrameReady(int frame)
 {
+    m_d->framesInProgress.remove(frame);
     m_d->enterState(Private::BetweenFrames);
 }
 
+void KisAnimationCachePopulator::slotHelperFrameCompleted(int frame)
+{
+    m_d->finishHelperFrame(frame);
+    m_d->startHelpers();
+}
+
+void KisAnimationCachePopulator::slotHelperFrameCancelled(int frame)
+{
+    m_d->finishHelperFrame(frame);
+    m_d->dropHelpers();
+}
+
+void KisAnimationCachePopulator::slotHelpersInvalidated()
+{
+    m_d->dropHelpers();
+}
+
 void KisAnimationCachePopulator::slotConfigChanged()
 {
     KisConfig cfg(true);
     m_d->calculateAnimationCacheInBackground = cfg.calculateAnimationCacheInBackground();
+
+    if (!m_d->calculateAnimationCacheInBackground) {
+        m_d->dropHelpers();
+    }
+
     QTimer::singleShot(1000, this, SLOT(slotRequestRegeneration()));
 }
@@ -45,8 +45,12 @@ public Q_SLOTS:
 private Q_SLOTS:
     void slotTimer();
 
-    void slotRegeneratorFrameCancelled();
-    void slotRegeneratorFrameReady();
+    void slotRegeneratorFrameCancelled(int frame);
+    void slotRegeneratorFrameReady(int frame);
+
+    void slotHelperFrameCompleted(int frame);
+    void slotHelperFrameCancelled(int frame);
+    void slotHelpersInvalidated();
 
     void slotConfigChanged();
 
@@ -1786,6 +1786,16 @@ void KisConfig::setCompressKra(bool compress)
     m_cfg.writeEntry("compressLayersInKra", compress);
 }
 
+bool KisConfig::incrementalKraSave(bool defaultValue) const
+{
+    return (defaultValue ? true : m_cfg.readEntry("incrementalKraSave", true));
+}
+
+void KisConfig::setIncrementalKraSave(bool value)
+{
+    m_cfg.writeEntry("incrementalKraSave", value);
+}
+
 bool KisConfig::toolOptionsInDocker(bool defaultValue) const
 {
     return (defaultValue ? true : m_cfg.readEntry("ToolOptionsInDocker", true));
@@ -1889,6 +1899,16 @@ void KisConfig::setEnableBrushSpeedLogging(bool value) const
     m_cfg.writeEntry("enableBrushSpeedLogging", value);
 }
 
+QString KisConfig::strokeRecordingDirectory(bool defaultValue) const
+{
+    return (defaultValue ? QString() : m_cfg.readEntry("strokeRecordingDirectory", QString()));
+}
+
+void KisConfig::setStrokeRecordingDirectory(const QString &value) const
+{
+    m_cfg.writeEntry("strokeRecordingDirectory", value);
+}
+
 void KisConfig::setEnableAmdVectorizationWorkaround(bool value)
 {
     m_cfg.writeEntry("amdDisableVectorWorkaround", value);
@@ -516,6 +516,9 @@ public:
     bool compressKra(bool defaultValue = false) const;
     void setCompressKra(bool compress);
 
+    bool incrementalKraSave(bool defaultValue = false) const;
+    void setIncrementalKraSave(bool value);
+
     bool toolOptionsInDocker(bool defaultValue = false) const;
     void setToolOptionsInDocker(bool inDocker);
 
@@ -537,6 +540,13 @@ public:
     void setEnableBrushSpeedLogging(bool value) const;
     bool enableBrushSpeedLogging(bool defaultValue = false) const;
 
+    /**
+     * A directory where every freehand stroke is recorded for the replay
+     * benchmark. Empty string means that recording is disabled.
+     */
+    void setStrokeRecordingDirectory(const QString &value) const;
+    QString strokeRecordingDirectory(bool defaultValue = false) const;
+
     void setEnableAmdVectorizationWorkaround(bool value);
     bool enableAmdVectorizationWorkaround(bool defaultValue = false) const;
 
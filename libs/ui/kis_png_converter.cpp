@@ -56,6 +56,7 @@
 #include <kis_iterator_ng.h>
 #include <kis_layer.h>
 #include <kis_paint_device.h>
+#include <KisBandedDeviceReader.h>
 #include <kis_transaction.h>
 #include <kis_paint_layer.h>
 #include <kis_group_layer.h>
@@ -905,26 +906,23 @@ KisImportExportErrorCode KisPNGConverter::buildFile(QIODevice* iodevice, const Q
 {
     KIS_SAFE_ASSERT_RECOVER_RETURN_VALUE(device, ImportExportCodes::InternalError);
 
-    if (!options.alpha) {
-        KisPaintDeviceSP tmp = new KisPaintDevice(device->colorSpace());
-        KoColor c(options.transparencyFillColor, device->colorSpace());
-        tmp->fill(imageRect, c);
-        KisPainter gc(tmp);
-        gc.bitBlt(imageRect.topLeft(), device, imageRect);
-        gc.end();
-        device = tmp;
-    }
+    /**
+     * The device is never flattened or converted as a whole. Instead,
+     * its rows are streamed through KisBandedDeviceReader, which does
+     * the filling and the conversion into dstCS band by band.
+     */
+    const KoColorSpace *dstCS = device->colorSpace();
 
-    if (device->colorSpace()->colorDepthId() == Float16BitsColorDepthID
-            || device->colorSpace()->colorDepthId() == Float32BitsColorDepthID
-            || device->colorSpace()->colorDepthId() == Float64BitsColorDepthID
+    if (dstCS->colorDepthId() == Float16BitsColorDepthID
+            || dstCS->colorDepthId() == Float32BitsColorDepthID
+            || dstCS->colorDepthId() == Float64BitsColorDepthID
             || options.saveAsHDR) {
 
-        const KoColorSpace *dstCS =
+        dstCS =
             KoColorSpaceRegistry::instance()->colorSpace(
-                device->colorSpace()->colorModelId().id(),
+                dstCS->colorModelId().id(),
                 Integer16BitsColorDepthID.id(),
-                device->colorSpace()->profile());
+                dstCS->profile());
 
         if (options.saveAsHDR) {
             dstCS =
@@ -933,13 +931,6 @@ KisImportExportErrorCode KisPNGConverter::buildFile(QIODevice* iodevice, const Q
                         Integer16BitsColorDepthID.id(),
                         KoColorSpaceRegistry::instance()->p2020PQProfile());
         }
-
-        KisPaintDeviceSP tmp = new KisPaintDevice(device->colorSpace());
-        tmp->makeCloneFromRough(device, imageRect);
-        tmp->convertTo(dstCS);
-
-        device = tmp;
-
     }
 
     KIS_SAFE_ASSERT_RECOVER(!options.saveAsHDR || !options.forceSRGB) {
@@ -951,12 +942,22 @@ KisImportExportErrorCode KisPNGConverter::buildFile(QIODevice* iodevice, const Q
     }
 
     QStringList colormodels = QStringList() << RGBAColorModelID.id() << GrayAColorModelID.id();
-    if (options.forceSRGB || !colormodels.contains(device->colorSpace()->colorModelId().id())) {
-        const KoColorSpace* cs = KoColorSpaceRegistry::instance()->colorSpace(RGBAColorModelID.id(), device->colorSpace()->colorDepthId().id(), "sRGB built-in - (lcms internal)");
-        device = new KisPaintDevice(*device);
-        device->convertTo(cs);
+    if (options.forceSRGB || !colormodels.contains(dstCS->colorModelId().id())) {
+        dstCS = KoColorSpaceRegistry::instance()->colorSpace(RGBAColorModelID.id(), dstCS->colorDepthId().id(), "sRGB built-in - (lcms internal)");
     }
 
+    const KoColor fillColor(options.transparencyFillColor, device->colorSpace());
+
+    auto createReader = [device, imageRect, dstCS, fillColor, options] () {
+        KisBandedDeviceReader *reader = new KisBandedDeviceReader(device, imageRect, dstCS);
+
+        if (!options.alpha) {
+            reader->setFillColor(fillColor);
+        }
+
+        return reader;
+    };
+
     // Initialize structures
     png_structp png_ptr =  png_create_write_struct(PNG_LIBPNG_VER_STRING, 0, 0, 0);
     if (!png_ptr) {
@@ -1001,40 +1002,45 @@ KisImportExportErrorCode KisPNGConverter::buildFile(QIODevice* iodevice, const Q
     png_set_compression_method(png_ptr, 8);
     png_set_compression_buffer_size(png_ptr, 8192);
 
-    int color_nb_bits = 8 * device->pixelSize() / device->channelCount();
-    int color_type = getColorTypeforColorSpace(device->colorSpace(), options.alpha);
+    int color_nb_bits = 8 * dstCS->pixelSize() / dstCS->channelCount();
+    int color_type = getColorTypeforColorSpace(dstCS, options.alpha);
 
     Q_ASSERT(color_type > -1);
 
     // Try to compute a table of color if the colorspace is RGB8f
     QScopedArrayPointer<png_color> palette;
     int num_palette = 0;
-    if (!options.alpha && options.tryToSaveAsIndexed && KoID(device->colorSpace()->id()) == KoID("RGBA")) { // png doesn't handle indexed images and alpha, and only have indexed for RGB8
+    if (!options.alpha && options.tryToSaveAsIndexed && KoID(dstCS->id()) == KoID("RGBA")) { // png doesn't handle indexed images and alpha, and only have indexed for RGB8
         palette.reset(new png_color[255]);
 
-        KisSequentialIterator it(device, imageRect);
+        QScopedPointer<KisBandedDeviceReader> reader(createReader());
 
         bool toomuchcolor = false;
-        while (it.nextPixel()) {
-            const quint8* c = it.oldRawData();
-            bool findit = false;
-            for (int i = 0; i < num_palette; i++) {
-                if (palette[i].red == c[2] &&
-                        palette[i].green == c[1] &&
-                        palette[i].blue == c[0]) {
-                    findit = true;
-                    break;
-                }
-            }
-            if (!findit) {
-                if (num_palette == 255) {
-                    toomuchcolor = true;
-                    break;
+        while (!toomuchcolor && reader->nextBand()) {
+            for (int y = reader->bandTop(); !toomuchcolor && y <= reader->bandBottom(); y++) {
+                const quint8 *c = reader->row(y);
+
+                for (int x = 0; x < imageRect.width(); x++, c += 4) {
+                    bool findit = false;
+                    for (int i = 0; i < num_palette; i++) {
+                        if (palette[i].red == c[2] &&
+                                palette[i].green == c[1] &&
+                                palette[i].blue == c[0]) {
+                            findit = true;
+                            break;
+                        }
+                    }
+                    if (!findit) {
+                        if (num_palette == 255) {
+                            toomuchcolor = true;
+                            break;
+                        }
+                        palette[num_palette].red = c[2];
+                        palette[num_palette].green = c[1];
+                        palette[num_palette].blue = c[0];
+                        num_palette++;
+                    }
                 }
-                palette[num_palette].red = c[2];
-                palette[num_palette].green = c[1];
-                palette[num_palette].blue = c[0];
-                num_palette++;
             }
         }
 
@@ -1068,7 +1074,7 @@ KisImportExportErrorCode KisPNGConverter::buildFile(QIODevice* iodevice, const Q
 
     // set sRGB only if the profile is sRGB  -- http://www.w3.org/TR/PNG/#11sRGB says sRGB and iCCP should not both be present
 
-    bool sRGB = device->colorSpace()->profile()->name().contains(QLatin1String("srgb"), Qt::CaseInsensitive);
+    bool sRGB = dstCS->profile()->name().contains(QLatin1String("srgb"), Qt::CaseInsensitive);
     /*
      * This automatically writes the correct gamma and chroma chunks along with the sRGB chunk, but firefox's
      * color management is bugged, so once you give it any incentive to start color managing an sRGB image it
@@ -1151,7 +1157,7 @@ KisImportExportErrorCode KisPNGConverter::buildFile(QIODevice* iodevice, const Q
     }
 
     // Save the color profile
-    const KoColorProfile* colorProfile = device->colorSpace()->profile();
+    const KoColorProfile* colorProfile = dstCS->profile();
     QByteArray colorProfileData = colorProfile->rawData();
     if (!sRGB || options.saveSRGBProfile) {
 
@@ -1271,101 +1277,89 @@ KisImportExportErrorCode KisPNGConverter::buildFile(QIODevice* iodevice, const Q
     // Write the PNG
     //     png_write_png(png_ptr, info_ptr, PNG_TRANSFORM_IDENTITY, 0);
 
-    struct RowPointersStruct {
-        RowPointersStruct(const QSize &size, int pixelSize)
-            : numRows(size.height())
-        {
-            rows = new png_byte*[numRows];
-
-            for (int i = 0; i < numRows; i++) {
-                rows[i] = new png_byte[size.width() * pixelSize];
-            }
-        }
-
-        ~RowPointersStruct() {
-            for (int i = 0; i < numRows; i++) {
-                delete[] rows[i];
-            }
-            delete[] rows;
-        }
-
-        const int numRows = 0;
-        png_byte** rows = 0;
-    };
-
-
-    // Fill the data structure
-    RowPointersStruct rowPointers(imageRect.size(), device->pixelSize());
-
-    int row = 0;
-    for (int y = imageRect.y(); y < imageRect.y() + imageRect.height(); y++, row++) {
-        KisHLineConstIteratorSP it = device->createHLineConstIteratorNG(imageRect.x(), y, imageRect.width());
-
-        switch (color_type) {
-        case PNG_COLOR_TYPE_GRAY:
-        case PNG_COLOR_TYPE_GRAY_ALPHA:
-            if (color_nb_bits == 16) {
-                quint16 *dst = reinterpret_cast<quint16 *>(rowPointers.rows[row]);
-                do {
-                    const quint16 *d = reinterpret_cast<const quint16 *>(it->oldRawData());
-                    *(dst++) = d[0];
-                    if (options.alpha) *(dst++) = d[1];
-                } while (it->nextPixel());
-            } else {
-                quint8 *dst = rowPointers.rows[row];
-                do {
-                    const quint8 *d = it->oldRawData();
-                    *(dst++) = d[0];
-                    if (options.alpha) *(dst++) = d[1];
-                } while (it->nextPixel());
-            }
-            break;
-        case PNG_COLOR_TYPE_RGB:
-        case PNG_COLOR_TYPE_RGB_ALPHA:
-            if (color_nb_bits == 16) {
-                quint16 *dst = reinterpret_cast<quint16 *>(rowPointers.rows[row]);
-                do {
-                    const quint16 *d = reinterpret_cast<const quint16 *>(it->oldRawData());
-                    *(dst++) = d[2];
-                    *(dst++) = d[1];
-                    *(dst++) = d[0];
-                    if (options.alpha) *(dst++) = d[3];
-                } while (it->nextPixel());
-            } else {
-                quint8 *dst = rowPointers.rows[row];
-                do {
-                    const quint8 *d = it->oldRawData();
-                    *(dst++) = d[2];
-                    *(dst++) = d[1];
-                    *(dst++) = d[0];
-                    if (options.alpha) *(dst++) = d[3];
-                } while (it->nextPixel());
-            }
-            break;
-        case PNG_COLOR_TYPE_PALETTE: {
-            quint8 *dst = rowPointers.rows[row];
-            KisPNGWriteStream writestream(dst, color_nb_bits);
-            do {
-                const quint8 *d = it->oldRawData();
-                int i;
-                for (i = 0; i < num_palette; i++) {
-                    if (palette[i].red == d[2] &&
-                            palette[i].green == d[1] &&
-                            palette[i].blue == d[0]) {
-                        break;
+    // Write the rows as soon as they are converted, only a few bands
+    // of the image are kept in memory at any time
+    QVector<png_byte> rowBuffer(imageRect.width() * dstCS->pixelSize());
+    const int width = imageRect.width();
+
+    // interlaced images need all the rows in every pass
+    const int numPasses = png_set_interlace_handling(png_ptr);
+
+    for (int pass = 0; pass < numPasses; pass++) {
+        QScopedPointer<KisBandedDeviceReader> reader(createReader());
+
+        while (reader->nextBand()) {
+            for (int y = reader->bandTop(); y <= reader->bandBottom(); y++) {
+                const quint8 *src = reader->row(y);
+
+                switch (color_type) {
+                case PNG_COLOR_TYPE_GRAY:
+                case PNG_COLOR_TYPE_GRAY_ALPHA:
+                    if (color_nb_bits == 16) {
+                        quint16 *dst = reinterpret_cast<quint16 *>(rowBuffer.data());
+                        const quint16 *d = reinterpret_cast<const quint16 *>(src);
+                        for (int x = 0; x < width; x++, d += 2) {
+                            *(dst++) = d[0];
+                            if (options.alpha) *(dst++) = d[1];
+                        }
+                    } else {
+                        quint8 *dst = rowBuffer.data();
+                        const quint8 *d = src;
+                        for (int x = 0; x < width; x++, d += 2) {
+                            *(dst++) = d[0];
+                            if (options.alpha) *(dst++) = d[1];
+                        }
+                    }
+                    break;
+                case PNG_COLOR_TYPE_RGB:
+                case PNG_COLOR_TYPE_RGB_ALPHA:
+                    if (color_nb_bits == 16) {
+                        quint16 *dst = reinterpret_cast<quint16 *>(rowBuffer.data());
+                        const quint16 *d = reinterpret_cast<const quint16 *>(src);
+                        for (int x = 0; x < width; x++, d += 4) {
+                            *(dst++) = d[2];
+                            *(dst++) = d[1];
+                            *(dst++) = d[0];
+                            if (options.alpha) *(dst++) = d[3];
+                        }
+                    } else {
+                        quint8 *dst = rowBuffer.data();
+                        const quint8 *d = src;
+                        for (int x = 0; x < width; x++, d += 4) {
+                            *(dst++) = d[2];
+                            *(dst++) = d[1];
+                            *(dst++) = d[0];
+                            if (options.alpha) *(dst++) = d[3];
+                        }
+                    }
+                    break;
+                case PNG_COLOR_TYPE_PALETTE: {
+                    quint8 *dst = rowBuffer.data();
+                    KisPNGWriteStream writestream(dst, color_nb_bits);
+                    const quint8 *d = src;
+                    for (int x = 0; x < width; x++, d += 4) {
+                        int i;
+                        for (i = 0; i < num_palette; i++) {
+                            if (palette[i].red == d[2] &&
+                                    palette[i].green == d[1] &&
+                                    palette[i].blue == d[0]) {
+                                break;
+                            }
+                        }
+                        writestream.setNextValue(i);
                     }
                 }
-                writestream.setNextValue(i);
-            } while (it->nextPixel());
-        }
-            break;
-        default:
-            return ImportExportCodes::FormatColorSpaceUnsupported;
+                    break;
+                default:
+                    png_destroy_write_struct(&png_ptr, &info_ptr);
+                    return ImportExportCodes::FormatColorSpaceUnsupported;
+                }
+
+                png_write_row(png_ptr, rowBuffer.data());
+            }
         }
     }
 
-    png_write_image(png_ptr, rowPointers.rows);
-
     // Writing is over
     png_write_end(png_ptr, info_ptr);
 
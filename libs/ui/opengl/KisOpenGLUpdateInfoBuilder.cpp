@@ -23,6 +23,8 @@
 
 #include "KisProofingConfiguration.h"
 
+#include <algorithm>
+#include <QtConcurrentMap>
 #include <QReadWriteLock>
 #include <QReadLocker>
 #include <QWriteLocker>
@@ -151,16 +153,6 @@ KisOpenGLUpdateInfoSP KisOpenGLUpdateInfoBuilder::buildUpdateInfo(const QRect &r
                                                      m_d->pool));
             // Don't update empty tiles
             if (tileInfo->valid()) {
-                tileInfo->retrieveData(projection, channelFlags, m_d->onlyOneChannelSelected, m_d->selectedChannelIndex);
-
-                if (convertColorSpace) {
-                    if (m_d->proofingTransform) {
-                        tileInfo->proofTo(m_d->conversionOptions.m_destinationColorSpace, m_d->proofingConfig->conversionFlags, m_d->proofingTransform.data());
-                    } else {
-                        tileInfo->convertTo(m_d->conversionOptions.m_destinationColorSpace, m_d->conversionOptions.m_renderingIntent, m_d->conversionOptions.m_conversionFlags);
-                    }
-                }
-
                 info->tileList.append(tileInfo);
             }
             else {
@@ -169,6 +161,46 @@ KisOpenGLUpdateInfoSP KisOpenGLUpdateInfoBuilder::buildUpdateInfo(const QRect &r
         }
     }
 
+    KisDisplayConversionLutSP conversionLut;
+
+    if (convertColorSpace && !m_d->proofingTransform) {
+        conversionLut = KisDisplayConversionLut::fetch(projection->colorSpace(),
+                                                       m_d->conversionOptions.m_destinationColorSpace,
+                                                       m_d->conversionOptions.m_renderingIntent,
+                                                       m_d->conversionOptions.m_conversionFlags);
+    }
+
+    auto fetchTileData =
+        [&] (KisTextureTileUpdateInfoSP tileInfo) {
+            tileInfo->retrieveData(projection, channelFlags, m_d->onlyOneChannelSelected, m_d->selectedChannelIndex);
+
+            if (convertColorSpace) {
+                if (m_d->proofingTransform) {
+                    tileInfo->proofTo(m_d->conversionOptions.m_destinationColorSpace, m_d->proofingConfig->conversionFlags, m_d->proofingTransform.data());
+                } else if (conversionLut && tileInfo->patchColorSpace() == conversionLut->srcColorSpace()) {
+                    tileInfo->convertTo(*conversionLut);
+                } else {
+                    tileInfo->convertTo(m_d->conversionOptions.m_destinationColorSpace, m_d->conversionOptions.m_renderingIntent, m_d->conversionOptions.m_conversionFlags);
+                }
+            }
+        };
+
+    /**
+     * Reading and converting of the tiles is independent, so it is
+     * distributed over the global thread pool. The proofing transform
+     * is shared between all the tiles and is not reentrant, so the
+     * proofed tiles are processed in the calling thread.
+     */
+    const bool canProcessInParallel =
+        info->tileList.size() > 1 &&
+        !(convertColorSpace && m_d->proofingTransform);
+
+    if (canProcessInParallel) {
+        QtConcurrent::blockingMap(info->tileList, fetchTileData);
+    } else {
+        std::for_each(info->tileList.begin(), info->tileList.end(), fetchTileData);
+    }
+
     info->assignDirtyImageRect(rect);
     info->assignLevelOfDetail(levelOfDetail);
     return info;
@@ -25,6 +25,12 @@
 
 #include <QMutex>
 #include <QMutexLocker>
+#include <QReadWriteLock>
+#include <QReadLocker>
+#include <QWriteLocker>
+#include <QAtomicInt>
+#include <QThread>
+#include <QThreadPool>
 #include <QSharedPointer>
 #include <QApplication>
 
@@ -38,6 +44,7 @@
 const int minPoolChunk = 32; // 8 MiB (default, with tilesize 256)
 const int maxPoolChunk = 128; // 32 MiB (default, with tilesize 256)
 const int freeThreshold = 64; // 16 MiB (default, with tilesize 256)
+const int maxPoolShards = 8;
 
 
 /**
@@ -50,34 +57,95 @@ const int freeThreshold = 64; // 16 MiB (default, with tilesize 256)
  * is returned back to the operating system. Please note, that there
  * is *no way* of reclaiming even unused pool memory until *all* the
  * allocated chunks are free'd.
+ *
+ * The pool is thread-safe. The update info builder allocates the chunks
+ * from the workers of the global thread pool, so the memory is split into
+ * one shard per worker (but not more than maxPoolShards). Each thread
+ * allocates from its own shard, which makes the threads almost never wait
+ * for each other. The reservation limits of the pool are divided between
+ * the shards, so the total amount of reserved memory does not depend on
+ * the number of the shards. The index of the shard is stored in a small
+ * header in front of every chunk, so the chunk can be free'd from any
+ * thread.
  */
 class KRITAUI_EXPORT KisTextureTileInfoPoolSingleSize
 {
+    /**
+     * The header keeps the index of the shard. It is 16 bytes long to
+     * keep the alignment of the chunk's data suitable for any pixel type.
+     */
+    static const int chunkHeaderSize = 16;
+
+    struct Shard {
+        Shard(int chunkSize, int minChunks, int maxChunks)
+            : pool(chunkSize + chunkHeaderSize, minChunks, maxChunks)
+        {
+        }
+
+        QMutex mutex;
+        boost::pool<boost::default_user_allocator_new_delete> pool;
+    };
+
 public:
     KisTextureTileInfoPoolSingleSize(int tileWidth, int tileHeight, int pixelSize)
         : m_chunkSize(tileWidth * tileHeight * pixelSize),
-          m_pool(m_chunkSize, minPoolChunk, maxPoolChunk),
           m_numAllocations(0),
           m_maxAllocations(0),
           m_numFrees(0)
     {
+        const int numShards = qBound(1, QThreadPool::globalInstance()->maxThreadCount(), maxPoolShards);
+
+        const int shardMinChunks = qMax(1, minPoolChunk / numShards);
+        const int shardMaxChunks = qMax(shardMinChunks, maxPoolChunk / numShards);
+
+        for (int i = 0; i < numShards; i++) {
+            m_shards.append(new Shard(m_chunkSize, shardMinChunks, shardMaxChunks));
+        }
+    }
+
+    ~KisTextureTileInfoPoolSingleSize() {
+        qDeleteAll(m_shards);
     }
 
     quint8* malloc() {
-        m_numAllocations++;
-        m_maxAllocations = qMax(m_maxAllocations, m_numAllocations);
+        const int numAllocations = m_numAllocations.fetchAndAddOrdered(1) + 1;
+
+        int maxAllocations = m_maxAllocations.loadAcquire();
+        while (numAllocations > maxAllocations &&
+               !m_maxAllocations.testAndSetOrdered(maxAllocations, numAllocations)) {
+
+            maxAllocations = m_maxAllocations.loadAcquire();
+        }
+
+        const int shardIndex = currentShardIndex();
+        Shard *shard = m_shards[shardIndex];
 
-        return (quint8*)m_pool.malloc();
+        quint8 *ptr = 0;
+
+        {
+            QMutexLocker l(&shard->mutex);
+            ptr = (quint8*)shard->pool.malloc();
+        }
+
+        *reinterpret_cast<int*>(ptr) = shardIndex;
+        return ptr + chunkHeaderSize;
     }
 
     bool free(quint8 *ptr) {
-        m_numAllocations--;
-        m_numFrees++;
-        m_pool.free(ptr);
+        ptr -= chunkHeaderSize;
+        Shard *shard = m_shards[*reinterpret_cast<int*>(ptr)];
+
+        {
+            QMutexLocker l(&shard->mutex);
+            shard->pool.free(ptr);
+        }
+
+        m_numFrees.ref();
+        const int numAllocations = m_numAllocations.fetchAndAddOrdered(-1) - 1;
 
-        KIS_ASSERT_RECOVER_NOOP(m_numAllocations >= 0);
+        KIS_ASSERT_RECOVER_NOOP(numAllocations >= 0);
 
-        return !m_numAllocations && m_maxAllocations > freeThreshold;
+        return !numAllocations && m_maxAllocations.loadAcquire() > freeThreshold;
     }
 
     int chunkSize() const {
@@ -85,24 +153,41 @@ public:
     }
 
     int numFrees() const {
-        return m_numFrees;
+        return m_numFrees.loadAcquire();
     }
 
     void tryPurge(int numFrees) {
+        Q_FOREACH (Shard *shard, m_shards) {
+            shard->mutex.lock();
+        }
+
         // checking numFrees here is asserting that there were no frees
         // between the time we originally indicated the purge and now.
-        if (numFrees == m_numFrees && !m_numAllocations) {
-            m_pool.purge_memory();
-            m_maxAllocations = 0;
+        if (numFrees == m_numFrees.loadAcquire() && !m_numAllocations.loadAcquire()) {
+            Q_FOREACH (Shard *shard, m_shards) {
+                shard->pool.purge_memory();
+            }
+            m_maxAllocations.storeRelease(0);
+        }
+
+        Q_FOREACH (Shard *shard, m_shards) {
+            shard->mutex.unlock();
         }
     }
 
 private:
+    int currentShardIndex() const {
+        return qHash(reinterpret_cast<quintptr>(QThread::currentThreadId())) % m_shards.size();
+    }
+
+private:
+    Q_DISABLE_COPY(KisTextureTileInfoPoolSingleSize)
+
     const int m_chunkSize;
-    boost::pool<boost::default_user_allocator_new_delete> m_pool;
-    int m_numAllocations;
-    int m_maxAllocations;
-    int m_numFrees;
+    QVector<Shard*> m_shards;
+    QAtomicInt m_numAllocations;
+    QAtomicInt m_maxAllocations;
+    QAtomicInt m_numFrees;
 };
 
 class KisTextureTileInfoPool;
@@ -150,26 +235,14 @@ public:
      * Alloc a tile with the specified pixel size
      */
     quint8* malloc(int pixelSize) {
-        QMutexLocker l(&m_mutex);
-
-        if (m_pools.size() <= pixelSize) {
-            m_pools.resize(pixelSize + 1);
-        }
-
-        if (!m_pools[pixelSize]) {
-            m_pools[pixelSize] =
-                new KisTextureTileInfoPoolSingleSize(m_tileWidth, m_tileHeight, pixelSize);
-        }
-
-        return m_pools[pixelSize]->malloc();
+        return poolForPixelSize(pixelSize)->malloc();
     }
 
     /**
      * Free a tile with the specified pixel size
      */
     void free(quint8 *ptr, int pixelSize) {
-        QMutexLocker l(&m_mutex);
-        KisTextureTileInfoPoolSingleSize *pool = m_pools[pixelSize];
+        KisTextureTileInfoPoolSingleSize *pool = existingPool(pixelSize);
         if (pool->free(ptr)) {
             emit purge(pixelSize, pool->numFrees());
         }
@@ -179,20 +252,47 @@ public:
      * \return the length of the chunks stored in the pool
      */
     int chunkSize(int pixelSize) const {
-        QMutexLocker l(&m_mutex);
-        return m_pools[pixelSize]->chunkSize();
+        return existingPool(pixelSize)->chunkSize();
     }
 
     void tryPurge(int pixelSize, int numFrees) {
-        QMutexLocker l(&m_mutex);
-        m_pools[pixelSize]->tryPurge(numFrees);
+        existingPool(pixelSize)->tryPurge(numFrees);
     }
 
 Q_SIGNALS:
     void purge(int pixelSize, int numFrees);
 
 private:
-    mutable QMutex m_mutex;
+    KisTextureTileInfoPoolSingleSize* existingPool(int pixelSize) const {
+        QReadLocker l(&m_lock);
+        return m_pools[pixelSize];
+    }
+
+    KisTextureTileInfoPoolSingleSize* poolForPixelSize(int pixelSize) {
+        {
+            QReadLocker l(&m_lock);
+
+            if (pixelSize < m_pools.size() && m_pools[pixelSize]) {
+                return m_pools[pixelSize];
+            }
+        }
+
+        QWriteLocker l(&m_lock);
+
+        if (m_pools.size() <= pixelSize) {
+            m_pools.resize(pixelSize + 1);
+        }
+
+        if (!m_pools[pixelSize]) {
+            m_pools[pixelSize] =
+                new KisTextureTileInfoPoolSingleSize(m_tileWidth, m_tileHeight, pixelSize);
+        }
+
+        return m_pools[pixelSize];
+    }
+
+private:
+    mutable QReadWriteLock m_lock;
     const int m_tileWidth;
     const int m_tileHeight;
     QVector<KisTextureTileInfoPoolSingleSize*> m_pools;
@@ -30,6 +30,7 @@
 #include <KoChannelInfo.h>
 #include <kis_lod_transform.h>
 #include "kis_texture_tile_info_pool.h"
+#include "KisDisplayConversionLut.h"
 
 
 class KisTextureTileUpdateInfo;
@@ -241,6 +242,26 @@ public:
         }
     }
 
+    /**
+     * Converts the patch using a precalculated display conversion
+     * table. The table must be built for the patch's color space.
+     */
+    void convertTo(const KisDisplayConversionLut &conversionLut)
+    {
+        KIS_SAFE_ASSERT_RECOVER_RETURN(conversionLut.srcColorSpace() == m_patchColorSpace);
+
+        if (m_patchRect.isValid()) {
+            const KoColorSpace *dstCS = conversionLut.dstColorSpace();
+            const qint32 numPixels = m_patchRect.width() * m_patchRect.height();
+            DataBuffer conversionCache(dstCS->pixelSize(), m_pool);
+
+            conversionLut.convertPixels(m_patchPixels.data(), conversionCache.data(), numPixels);
+
+            m_patchColorSpace = dstCS;
+            conversionCache.swap(m_patchPixels);
+        }
+    }
+
     void proofTo(const KoColorSpace* dstCS,
                    KoColorConversionTransformation::ConversionFlags conversionFlags,
                    KoColorConversionTransformation *proofingTransform)
@@ -0,0 +1,173 @@
+/*
+ *  Copyright (c) 2020 Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "KisCanvasMotionPredictorTest.h"
+
+#include <QRegion>
+
+#include "canvas/KisCanvasMotionPredictor.h"
+
+void KisCanvasMotionPredictorTest::testStill()
+{
+    KisCanvasMotionPredictor predictor;
+
+    const QRectF rc(100, 100, 800, 600);
+
+    predictor.addSample(rc, 0);
+    predictor.addSample(rc, 16);
+    predictor.addSample(rc, 32);
+
+    QVERIFY(!predictor.isMoving());
+    QCOMPARE(predictor.predictedRect(300), rc);
+}
+
+void KisCanvasMotionPredictorTest::testPanning()
+{
+    KisCanvasMotionPredictor predictor;
+
+    QRectF rc(100, 100, 800, 600);
+
+    // moving right by 1 px/ms
+    for (int time = 0; time <= 160; time += 16) {
+        predictor.addSample(rc, time);
+        rc.translate(16, 0);
+    }
+    rc.translate(-16, 0);
+
+    QVERIFY(predictor.isMoving());
+
+    const QRectF predicted = predictor.predictedRect(300);
+
+    QVERIFY(predicted.contains(rc));
+    QCOMPARE(predicted.top(), rc.top());
+    QCOMPARE(predicted.bottom(), rc.bottom());
+    QCOMPARE(predicted.left(), rc.left());
+    QVERIFY(qAbs(predicted.right() - (rc.right() + 300)) < 1.0);
+}
+
+void KisCanvasMotionPredictorTest::testZooming()
+{
+    KisCanvasMotionPredictor predictor;
+
+    QRectF rc(0, 0, 800, 600);
+
+    // zooming out, the visible area grows
+    for (int time = 0; time <= 160; time += 16) {
+        predictor.addSample(rc, time);
+        rc = QRectF(rc.topLeft() - QPointF(8, 6), rc.size() + QSizeF(16, 12));
+    }
+    rc = QRectF(rc.topLeft() + QPointF(8, 6), rc.size() - QSizeF(16, 12));
+
+    QVERIFY(predictor.isMoving());
+
+    const QRectF predicted = predictor.predictedRect(300);
+
+    QVERIFY(predicted.contains(rc));
+    QVERIFY(predicted.width() > rc.width());
+    QVERIFY(predicted.height() > rc.height());
+
+    // the extrapolation of the zoom is limited
+    QVERIFY(predicted.width() <= 2.0 * rc.width() + 1.0);
+}
+
+void KisCanvasMotionPredictorTest::testStopAfterTimeout()
+{
+    KisCanvasMotionPredictor predictor;
+
+    predictor.addSample(QRectF(0, 0, 800, 600), 0);
+    predictor.addSample(QRectF(16, 0, 800, 600), 16);
+    QVERIFY(predictor.isMoving());
+
+    const QRectF rc(32, 0, 800, 600);
+    predictor.addSample(rc, 16 + KisCanvasMotionPredictor::resetTimeout() + 1);
+
+    QVERIFY(!predictor.isMoving());
+    QCOMPARE(predictor.predictedRect(300), rc);
+}
+
+void KisCanvasMotionPredictorTest::testFilterRectAtImageBorder()
+{
+    const QRect imageRect(0, 0, 4000, 3000);
+
+    // zoomed into the top-left corner of the image
+    const QRectF visibleRect(0, 0, 800, 600);
+    const QRect filterRect = KisCanvasMotionPredictor::staleUpdatesFilterRect(visibleRect, imageRect);
+
+    QVERIFY(!filterRect.isEmpty());
+    QVERIFY(imageRect.contains(filterRect));
+    QVERIFY(filterRect.contains(visibleRect.toAlignedRect()));
+    QCOMPARE(filterRect, QRect(0, 0, 1000, 750));
+
+    // the viewport partially outside the right border
+    const QRectF outerRect(3600, 1000, 800, 600);
+    QCOMPARE(KisCanvasMotionPredictor::staleUpdatesFilterRect(outerRect, imageRect),
+             QRect(3400, 850, 600, 900));
+
+    // the whole image is visible, nothing should be deferred
+    QVERIFY(KisCanvasMotionPredictor::staleUpdatesFilterRect(QRectF(-100, -100, 4200, 3200), imageRect).isEmpty());
+    QVERIFY(KisCanvasMotionPredictor::staleUpdatesFilterRect(QRectF(200, 200, 3600, 2600), imageRect).isEmpty());
+}
+
+void KisCanvasMotionPredictorTest::testPrefetchAtImageBorder()
+{
+    const QRect imageRect(0, 0, 4000, 3000);
+
+    KisCanvasMotionPredictor predictor;
+
+    // the viewport touches the top-left corner and moves right by 1 px/ms
+    QRectF rc(0, 0, 800, 600);
+    for (int time = 0; time <= 160; time += 16) {
+        predictor.addSample(rc, time);
+        rc.translate(16, 0);
+    }
+    rc.translate(-16, 0);
+
+    QVERIFY(predictor.isMoving());
+
+    const QRect filterRect = KisCanvasMotionPredictor::staleUpdatesFilterRect(rc, imageRect);
+    const QRect prefetchRect = predictor.prefetchRect(300, imageRect);
+
+    QVERIFY(!filterRect.isEmpty());
+    QVERIFY(imageRect.contains(prefetchRect));
+    QCOMPARE(prefetchRect.left(), 0);
+    QCOMPARE(prefetchRect.top(), 0);
+    QVERIFY(prefetchRect.right() > filterRect.right());
+
+    // the stale updates ahead of the viewport are prefetched
+    const QRegion staleRegion = QRegion(imageRect) - filterRect;
+    QVERIFY(!(staleRegion & prefetchRect).isEmpty());
+
+    // moving towards the border, the prediction is clipped by the image
+    KisCanvasMotionPredictor backwardPredictor;
+
+    rc = QRectF(160, 0, 800, 600);
+    for (int time = 0; time <= 160; time += 16) {
+        backwardPredictor.addSample(rc, time);
+        rc.translate(-16, 0);
+    }
+
+    QVERIFY(backwardPredictor.isMoving());
+    QVERIFY(backwardPredictor.predictedRect(300).left() < 0);
+
+    const QRect clippedRect = backwardPredictor.prefetchRect(300, imageRect);
+    QVERIFY(imageRect.contains(clippedRect));
+    QCOMPARE(clippedRect.left(), 0);
+}
+
+QTEST_MAIN(KisCanvasMotionPredictorTest)
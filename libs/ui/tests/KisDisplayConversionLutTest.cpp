@@ -0,0 +1,218 @@
+/*
+ *  Copyright (c) 2020 Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "KisDisplayConversionLutTest.h"
+
+#include <KoColorSpace.h>
+#include <KoColorSpaceRegistry.h>
+#include <KoColorModelStandardIds.h>
+
+#include "canvas/KisDisplayConversionLut.h"
+
+namespace {
+
+const KoColorSpace* wideGamutSpace(const KoID &depth)
+{
+    return KoColorSpaceRegistry::instance()->colorSpace(RGBAColorModelID.id(), depth.id(),
+                                                        KoColorSpaceRegistry::instance()->p2020G10Profile());
+}
+
+QVector<quint8> randomPixels(const KoColorSpace *cs, int numPixels)
+{
+    QVector<quint8> pixels(cs->pixelSize() * numPixels);
+
+    qsrand(1);
+    for (int i = 0; i < pixels.size(); i++) {
+        pixels[i] = qrand() & 0xFF;
+    }
+
+    return pixels;
+}
+
+}
+
+void KisDisplayConversionLutTest::testSupportedSpaces()
+{
+    const KoColorSpace *rgb8 = KoColorSpaceRegistry::instance()->rgb8();
+    const KoColorSpace *rgb16 = KoColorSpaceRegistry::instance()->rgb16();
+    const KoColorSpace *monitor = wideGamutSpace(Integer8BitsColorDepthID);
+
+    QVERIFY(KisDisplayConversionLut::isSupported(rgb8, monitor));
+    QVERIFY(KisDisplayConversionLut::isSupported(rgb16, monitor));
+
+    // the conversion is not needed at all
+    QVERIFY(!KisDisplayConversionLut::isSupported(rgb8, rgb8));
+
+    // not an 8-bit destination
+    QVERIFY(!KisDisplayConversionLut::isSupported(rgb8, wideGamutSpace(Integer16BitsColorDepthID)));
+
+    // not an RGB source
+    QVERIFY(!KisDisplayConversionLut::isSupported(KoColorSpaceRegistry::instance()->lab16(), monitor));
+}
+
+void KisDisplayConversionLutTest::testCache()
+{
+    const KoColorSpace *rgb8 = KoColorSpaceRegistry::instance()->rgb8();
+    const KoColorSpace *monitor = wideGamutSpace(Integer8BitsColorDepthID);
+
+    KisDisplayConversionLutSP lut1 =
+        KisDisplayConversionLut::fetch(rgb8, monitor,
+                                       KoColorConversionTransformation::internalRenderingIntent(),
+                                       KoColorConversionTransformation::internalConversionFlags());
+
+    KisDisplayConversionLutSP lut2 =
+        KisDisplayConversionLut::fetch(rgb8, monitor,
+                                       KoColorConversionTransformation::internalRenderingIntent(),
+                                       KoColorConversionTransformation::internalConversionFlags());
+
+    KisDisplayConversionLutSP lut3 =
+        KisDisplayConversionLut::fetch(rgb8, monitor,
+                                       KoColorConversionTransformation::IntentAbsoluteColorimetric,
+                                       KoColorConversionTransformation::internalConversionFlags());
+
+    QVERIFY(lut1);
+    QCOMPARE(lut1, lut2);
+    QVERIFY(lut1 != lut3);
+}
+
+void KisDisplayConversionLutTest::testConversion_data()
+{
+    QTest::addColumn<QString>("srcDepth");
+
+    QTest::newRow("8bit") << Integer8BitsColorDepthID.id();
+    QTest::newRow("16bit") << Integer16BitsColorDepthID.id();
+}
+
+void KisDisplayConversionLutTest::testConversion()
+{
+    QFETCH(QString, srcDepth);
+
+    const KoColorSpace *srcCs =
+        KoColorSpaceRegistry::instance()->colorSpace(RGBAColorModelID.id(), srcDepth, 0);
+    const KoColorSpace *dstCs = wideGamutSpace(Integer8BitsColorDepthID);
+
+    const KoColorConversionTransformation::Intent intent =
+        KoColorConversionTransformation::internalRenderingIntent();
+    const KoColorConversionTransformation::ConversionFlags flags =
+        KoColorConversionTransformation::internalConversionFlags();
+
+    KisDisplayConversionLutSP lut = KisDisplayConversionLut::fetch(srcCs, dstCs, intent, flags);
+    QVERIFY(lut);
+
+    const int numPixels = 100000;
+    const QVector<quint8> src = randomPixels(srcCs, numPixels);
+
+    QVector<quint8> reference(dstCs->pixelSize() * numPixels);
+    QVector<quint8> result(dstCs->pixelSize() * numPixels);
+
+    srcCs->convertPixelsTo(src.constData(), reference.data(), dstCs, numPixels, intent, flags);
+    lut->convertPixels(src.constData(), result.data(), numPixels);
+
+    /**
+     * The interpolation in the table is allowed to differ
+     * from the full conversion by a rounding error only
+     */
+    int maxDifference = 0;
+    for (int i = 0; i < reference.size(); i++) {
+        maxDifference = qMax(maxDifference, qAbs(int(reference[i]) - int(result[i])));
+    }
+
+    QVERIFY2(maxDifference <= 2, QString("max difference: %1").arg(maxDifference).toLatin1());
+}
+
+void KisDisplayConversionLutTest::testLinearSourceShadows()
+{
+    /**
+     * The conversion from a linear space into an sRGB monitor is very
+     * steep in the shadows: the darkest 1% of the linear values take
+     * about 10% of the 8-bit levels. Without the shaper curve the
+     * table cannot follow it.
+     */
+    const KoColorSpace *srcCs = wideGamutSpace(Integer16BitsColorDepthID);
+    const KoColorSpace *dstCs = KoColorSpaceRegistry::instance()->rgb8();
+
+    const KoColorConversionTransformation::Intent intent =
+        KoColorConversionTransformation::internalRenderingIntent();
+    const KoColorConversionTransformation::ConversionFlags flags =
+        KoColorConversionTransformation::internalConversionFlags();
+
+    KisDisplayConversionLutSP lut = KisDisplayConversionLut::fetch(srcCs, dstCs, intent, flags);
+    QVERIFY(lut);
+
+    const int numPixels = 2048;
+    QVector<quint16> src(numPixels * 4);
+
+    for (int i = 0; i < numPixels; i++) {
+        src[i * 4 + 0] = i;
+        src[i * 4 + 1] = i;
+        src[i * 4 + 2] = i;
+        src[i * 4 + 3] = 0xFFFF;
+    }
+
+    QVector<quint8> reference(dstCs->pixelSize() * numPixels);
+    QVector<quint8> result(dstCs->pixelSize() * numPixels);
+
+    srcCs->convertPixelsTo(reinterpret_cast<const quint8*>(src.constData()), reference.data(),
+                           dstCs, numPixels, intent, flags);
+    lut->convertPixels(reinterpret_cast<const quint8*>(src.constData()), result.data(), numPixels);
+
+    int maxDifference = 0;
+    for (int i = 0; i < reference.size(); i++) {
+        maxDifference = qMax(maxDifference, qAbs(int(reference[i]) - int(result[i])));
+    }
+
+    QVERIFY2(maxDifference <= 1, QString("max difference: %1").arg(maxDifference).toLatin1());
+}
+
+void KisDisplayConversionLutTest::benchmarkLut()
+{
+    const KoColorSpace *srcCs = KoColorSpaceRegistry::instance()->rgb8();
+    const KoColorSpace *dstCs = wideGamutSpace(Integer8BitsColorDepthID);
+
+    KisDisplayConversionLutSP lut =
+        KisDisplayConversionLut::fetch(srcCs, dstCs,
+                                       KoColorConversionTransformation::internalRenderingIntent(),
+                                       KoColorConversionTransformation::internalConversionFlags());
+
+    const int numPixels = 256 * 256;
+    const QVector<quint8> src = randomPixels(srcCs, numPixels);
+    QVector<quint8> dst(dstCs->pixelSize() * numPixels);
+
+    QBENCHMARK {
+        lut->convertPixels(src.constData(), dst.data(), numPixels);
+    }
+}
+
+void KisDisplayConversionLutTest::benchmarkFullConversion()
+{
+    const KoColorSpace *srcCs = KoColorSpaceRegistry::instance()->rgb8();
+    const KoColorSpace *dstCs = wideGamutSpace(Integer8BitsColorDepthID);
+
+    const int numPixels = 256 * 256;
+    const QVector<quint8> src = randomPixels(srcCs, numPixels);
+    QVector<quint8> dst(dstCs->pixelSize() * numPixels);
+
+    QBENCHMARK {
+        srcCs->convertPixelsTo(src.constData(), dst.data(), dstCs, numPixels,
+                               KoColorConversionTransformation::internalRenderingIntent(),
+                               KoColorConversionTransformation::internalConversionFlags());
+    }
+}
+
+QTEST_MAIN(KisDisplayConversionLutTest)
@@ -219,4 +219,49 @@ void KisFrameSerializerTest::testFrameArithmetics()
     }
 }
 
+void KisFrameSerializerTest::testSparseFrameArithmetics()
+{
+    KisTextureTileInfoPoolRegistry poolRegistry;
+    KisTextureTileInfoPoolSP pool = poolRegistry.getPool(maxTileSize, maxTileSize);
+
+    KisFrameDataSerializer::Frame testFrame1 = generateTestFrame(2, pool);
+
+    {
+        KisFrameDataSerializer::Frame testFrame2 = generateTestFrame(2, pool);
+
+        const bool framesAreSame = KisFrameDataSerializer::subtractFramesSparse(testFrame2, testFrame1);
+        QVERIFY(framesAreSame);
+        QVERIFY(testFrame2.frameTiles.empty());
+    }
+
+    {
+        KisFrameDataSerializer::Frame testFrame2 = generateTestFrame(2, pool);
+
+        // change a single pixel in two of the tiles
+        *reinterpret_cast<qint32*>(testFrame2.frameTiles[3].data.data()) = 0;
+        *reinterpret_cast<qint32*>(testFrame2.frameTiles[7].data.data()) = 0;
+
+        KisFrameDataSerializer::Frame diffFrame = testFrame2.clone();
+
+        const bool framesAreSame = KisFrameDataSerializer::subtractFramesSparse(diffFrame, testFrame1);
+        QVERIFY(!framesAreSame);
+        QCOMPARE(int(diffFrame.frameTiles.size()), 2);
+        QCOMPARE(diffFrame.frameTiles[0].col, testFrame2.frameTiles[3].col);
+        QCOMPARE(diffFrame.frameTiles[1].col, testFrame2.frameTiles[7].col);
+
+        // the sparse frame survives serialization
+        KisFrameDataSerializer serializer;
+        const int diffFrameId = serializer.saveFrame(diffFrame);
+        KisFrameDataSerializer::Frame loadedDiffFrame = serializer.loadFrame(diffFrameId, pool);
+
+        KisFrameDataSerializer::Frame restoredFrame = testFrame1.clone();
+        KisFrameDataSerializer::addFramesSparse(restoredFrame, loadedDiffFrame);
+
+        boost::optional<qreal> result =
+            KisFrameDataSerializer::estimateFrameUniqueness(restoredFrame, testFrame2, 1.0);
+        QVERIFY(!!result);
+        QVERIFY(*result == 0.0);
+    }
+}
+
 QTEST_MAIN(KisFrameSerializerTest)
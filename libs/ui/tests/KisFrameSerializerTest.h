@@ -29,6 +29,7 @@ private Q_SLOTS:
     void testFrameDataSerialization();
     void testFrameUniquenessEstimation();
     void testFrameArithmetics();
+    void testSparseFrameArithmetics();
 
 };
 
@@ -0,0 +1,117 @@
+/*
+ *  Copyright (c) 2020 Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "KisImagePyramidBenchmark.h"
+
+#include <KoColor.h>
+#include <KoColorSpaceRegistry.h>
+#include <KoColorConversionTransformation.h>
+
+#include <kis_image.h>
+#include <kis_paint_device.h>
+#include <kis_update_info.h>
+
+#include "canvas/kis_image_pyramid.h"
+
+#define IMAGE_WIDTH 8000
+#define IMAGE_HEIGHT 6000
+#define PYRAMID_HEIGHT 8
+
+namespace {
+
+void initPyramid(KisImagePyramid &pyramid, KisImageSP image)
+{
+    pyramid.setMonitorProfile(KoColorSpaceRegistry::instance()->rgb8()->profile(),
+                              KoColorConversionTransformation::internalRenderingIntent(),
+                              KoColorConversionTransformation::internalConversionFlags());
+    pyramid.setImage(image);
+}
+
+void updatePyramid(KisImagePyramid &pyramid, const QRect &rc)
+{
+    pyramid.updateCache(rc);
+
+    KisPPUpdateInfoSP info = new KisPPUpdateInfo();
+    info->dirtyImageRectVar = rc;
+    pyramid.recalculateCache(info);
+}
+
+}
+
+void KisImagePyramidBenchmark::initTestCase()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    m_image = new KisImage(0, IMAGE_WIDTH, IMAGE_HEIGHT, cs, "pyramid benchmark");
+
+    /**
+     * Fill the projection with a pattern of differently colored
+     * blocks, so that the downsampling would not get uniform data only
+     */
+    KisPaintDeviceSP projection = m_image->projection();
+
+    const int blockSize = 96;
+    for (int y = 0; y < IMAGE_HEIGHT; y += blockSize) {
+        for (int x = 0; x < IMAGE_WIDTH; x += blockSize) {
+            const QColor color((x * 7 + y) % 256, (x + y * 3) % 256, (x ^ y) % 256,
+                               128 + (x + y) % 128);
+
+            projection->fill(QRect(x, y, blockSize, blockSize), KoColor(color, cs));
+        }
+    }
+}
+
+void KisImagePyramidBenchmark::cleanupTestCase()
+{
+    m_image = 0;
+}
+
+void KisImagePyramidBenchmark::benchmarkStrokeUpdates()
+{
+    KisImagePyramid pyramid(PYRAMID_HEIGHT);
+    initPyramid(pyramid, m_image);
+
+    /**
+     * Emulate the updates generated by a big brush moving
+     * diagonally across the canvas
+     */
+    QVector<QRect> dirtyRects;
+    for (int i = 0; i < 64; i++) {
+        const int size = 256 + (i % 5) * 64;
+        const QPoint center(300 + i * 110, 300 + i * 80);
+        dirtyRects << QRect(center - QPoint(size / 2, size / 2), QSize(size, size));
+    }
+
+    QBENCHMARK {
+        Q_FOREACH (const QRect &rc, dirtyRects) {
+            updatePyramid(pyramid, rc);
+        }
+    }
+}
+
+void KisImagePyramidBenchmark::benchmarkFullImageUpdate()
+{
+    KisImagePyramid pyramid(PYRAMID_HEIGHT);
+    initPyramid(pyramid, m_image);
+
+    QBENCHMARK {
+        updatePyramid(pyramid, m_image->bounds());
+    }
+}
+
+QTEST_MAIN(KisImagePyramidBenchmark)
@@ -0,0 +1,136 @@
+/*
+ *  Copyright (c) 2020 Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "KisOpenGLUpdateInfoBuilderBenchmark.h"
+
+#include <KoColor.h>
+#include <KoColorSpaceRegistry.h>
+#include <KoColorModelStandardIds.h>
+
+#include <kis_image.h>
+#include <kis_paint_device.h>
+
+#include "kis_update_info.h"
+
+#include "opengl/KisOpenGLUpdateInfoBuilder.h"
+#include "opengl/kis_texture_tile_info_pool.h"
+
+#define IMAGE_WIDTH 6000
+#define IMAGE_HEIGHT 4000
+
+namespace {
+
+const int textureSize = 256;
+const int textureBorder = 8;
+
+struct BuilderEnvironment
+{
+    BuilderEnvironment(const KoColorSpace *imageColorSpace)
+        : pool(poolRegistry.getPool(textureSize, textureSize))
+    {
+        builder.setTextureInfoPool(pool);
+
+        builder.setConversionOptions(
+            ConversionOptions(KoColorSpaceRegistry::instance()->rgb8(),
+                              KoColorConversionTransformation::internalRenderingIntent(),
+                              KoColorConversionTransformation::internalConversionFlags()));
+
+        builder.setTextureBorder(textureBorder);
+        builder.setEffectiveTextureSize(QSize(textureSize - 2 * textureBorder,
+                                              textureSize - 2 * textureBorder));
+
+        image = new KisImage(0, IMAGE_WIDTH, IMAGE_HEIGHT, imageColorSpace, "builder benchmark");
+
+        /**
+         * Fill the projection with differently colored blocks, so that
+         * the color conversion caches would not hide the real cost
+         */
+        KisPaintDeviceSP projection = image->projection();
+
+        const int blockSize = 100;
+        for (int y = 0; y < IMAGE_HEIGHT; y += blockSize) {
+            for (int x = 0; x < IMAGE_WIDTH; x += blockSize) {
+                const QColor color((x * 7 + y) % 256, (x + y * 3) % 256, (x ^ y) % 256);
+                projection->fill(QRect(x, y, blockSize, blockSize), KoColor(color, imageColorSpace));
+            }
+        }
+    }
+
+    KisTextureTileInfoPoolRegistry poolRegistry;
+    KisTextureTileInfoPoolSP pool;
+    KisOpenGLUpdateInfoBuilder builder;
+    KisImageSP image;
+};
+
+}
+
+void KisOpenGLUpdateInfoBuilderBenchmark::benchmarkFullCanvas_data()
+{
+    QTest::addColumn<QString>("colorModel");
+    QTest::addColumn<QString>("colorDepth");
+
+    QTest::newRow("rgb8") << RGBAColorModelID.id() << Integer8BitsColorDepthID.id();
+    QTest::newRow("rgb16") << RGBAColorModelID.id() << Integer16BitsColorDepthID.id();
+    QTest::newRow("rgbF32") << RGBAColorModelID.id() << Float32BitsColorDepthID.id();
+    QTest::newRow("cmyk8") << CMYKAColorModelID.id() << Integer8BitsColorDepthID.id();
+}
+
+void KisOpenGLUpdateInfoBuilderBenchmark::benchmarkFullCanvas()
+{
+    QFETCH(QString, colorModel);
+    QFETCH(QString, colorDepth);
+
+    const KoColorSpace *cs =
+        KoColorSpaceRegistry::instance()->colorSpace(colorModel, colorDepth, 0);
+    QVERIFY(cs);
+
+    BuilderEnvironment env(cs);
+
+    /**
+     * Emulates the refresh of the entire canvas, e.g. after
+     * applying a filter to the whole layer
+     */
+    QBENCHMARK {
+        KisOpenGLUpdateInfoSP info =
+            env.builder.buildUpdateInfo(env.image->bounds(), env.image, true);
+        QVERIFY(!info->tileList.isEmpty());
+    }
+}
+
+void KisOpenGLUpdateInfoBuilderBenchmark::benchmarkBrushStroke()
+{
+    BuilderEnvironment env(KoColorSpaceRegistry::instance()->rgb8());
+
+    QVector<QRect> dirtyRects;
+    for (int i = 0; i < 64; i++) {
+        const int size = 128 + (i % 4) * 64;
+        const QPoint center(200 + i * 80, 200 + i * 55);
+        dirtyRects << QRect(center - QPoint(size / 2, size / 2), QSize(size, size));
+    }
+
+    QBENCHMARK {
+        Q_FOREACH (const QRect &rc, dirtyRects) {
+            KisOpenGLUpdateInfoSP info =
+                env.builder.buildUpdateInfo(rc, env.image, true);
+            Q_UNUSED(info);
+        }
+    }
+}
+
+QTEST_MAIN(KisOpenGLUpdateInfoBuilderBenchmark)
@@ -0,0 +1,324 @@
+/*
+ *  Copyright (c) 2020 Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "KisStrokeReplayBenchmark.h"
+
+#include <QTest>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QtMath>
+
+#include <algorithm>
+
+#include "stroke_testing_utils.h"
+#include "testutil.h"
+#include "strokes/freehand_stroke.h"
+#include "strokes/KisFreehandStrokeInfo.h"
+#include "tool/KisFreehandStrokeRecording.h"
+#include "kis_resources_snapshot.h"
+#include "kis_canvas_resource_provider.h"
+#include "kis_distance_information.h"
+#include "kis_image.h"
+#include <brushengine/kis_paintop_preset.h>
+#include <brushengine/kis_paint_information.h>
+
+
+namespace {
+
+const QString defaultPreset = "testing_1000px_auto_deafult.kpp";
+const QString defaultRecording = "stroke_recording_sample.xml";
+
+/**
+ * Per-run statistics collected from the stroke callbacks. The callbacks
+ * are executed in the worker threads, so everything is guarded with
+ * a mutex.
+ */
+struct ReplayStats
+{
+    void reset() {
+        QMutexLocker l(&lock);
+
+        clock.start();
+        latencies.clear();
+        paintOpTime = 0;
+        updateTime = 0;
+        asyncUpdateTime = 0;
+        finishTime = 0;
+        strokeEndedTime = 0;
+        numDabs = 0;
+    }
+
+    qint64 now() const {
+        return clock.nsecsElapsed();
+    }
+
+    QMutex lock;
+    QElapsedTimer clock;
+
+    QVector<qint64> latencies;
+    qint64 paintOpTime = 0;
+    qint64 updateTime = 0;
+    qint64 asyncUpdateTime = 0;
+    qint64 finishTime = 0;
+    qint64 strokeEndedTime = 0;
+    int numDabs = 0;
+};
+
+/**
+ * Painting job that remembers the moment it has been submitted to the
+ * image, so that we could measure input-to-paint latency
+ */
+class TimedData : public FreehandStrokeStrategy::Data
+{
+public:
+    TimedData(const KisFreehandStrokeRecording::Event &event, qint64 _submitTime)
+        : FreehandStrokeStrategy::Data(event.strokeInfoId, event.pi1),
+          submitTime(_submitTime)
+    {
+        pi2 = event.pi2;
+        control1 = event.control1;
+        control2 = event.control2;
+
+        switch (event.type) {
+        case KisFreehandStrokeRecording::PaintLine:
+            type = LINE;
+            break;
+        case KisFreehandStrokeRecording::PaintBezierCurve:
+            type = CURVE;
+            break;
+        default:
+            type = POINT;
+            break;
+        }
+    }
+
+    qint64 submitTime;
+};
+
+class TimedFreehandStrokeStrategy : public FreehandStrokeStrategy
+{
+public:
+    TimedFreehandStrokeStrategy(KisResourcesSnapshotSP resources,
+                                KisFreehandStrokeInfo *strokeInfo,
+                                ReplayStats *stats)
+        : FreehandStrokeStrategy(resources, strokeInfo, kundo2_noi18n("Replayed Stroke")),
+          m_strokeInfo(strokeInfo),
+          m_stats(stats)
+    {
+    }
+
+    void doStrokeCallback(KisStrokeJobData *data) override {
+        const qint64 startTime = m_stats->now();
+        FreehandStrokeStrategy::doStrokeCallback(data);
+        const qint64 endTime = m_stats->now();
+
+        QMutexLocker l(&m_stats->lock);
+
+        if (TimedData *d = dynamic_cast<TimedData*>(data)) {
+            m_stats->paintOpTime += endTime - startTime;
+            m_stats->latencies.append(endTime - d->submitTime);
+        } else if (dynamic_cast<UpdateData*>(data)) {
+            m_stats->updateTime += endTime - startTime;
+        } else {
+            m_stats->asyncUpdateTime += endTime - startTime;
+        }
+    }
+
+    void finishStrokeCallback() override {
+        {
+            QMutexLocker l(&m_stats->lock);
+            m_stats->numDabs = m_strokeInfo->dragDistance->currentDabSeqNo();
+        }
+
+        const qint64 startTime = m_stats->now();
+        FreehandStrokeStrategy::finishStrokeCallback();
+        const qint64 endTime = m_stats->now();
+
+        QMutexLocker l(&m_stats->lock);
+        m_stats->finishTime += endTime - startTime;
+    }
+
+private:
+    KisFreehandStrokeInfo *m_strokeInfo;
+    ReplayStats *m_stats;
+};
+
+class StrokeReplayTester : public utils::StrokeTester
+{
+public:
+    StrokeReplayTester(const KisFreehandStrokeRecording &recording,
+                       const QString &presetFilename,
+                       const QString &externalPresetPath)
+        : StrokeTester("stroke_replay", QSize(5000, 5000), presetFilename),
+          m_recording(recording),
+          m_externalPresetPath(externalPresetPath)
+    {
+    }
+
+    void setRealTimeReplay(bool value) {
+        m_realTimeReplay = value;
+    }
+
+    ReplayStats& stats() {
+        return m_stats;
+    }
+
+protected:
+    using utils::StrokeTester::modifyResourceManager;
+    void modifyResourceManager(KoCanvasResourceProvider *manager,
+                               KisImageWSP image) override {
+        Q_UNUSED(image);
+
+        if (m_externalPresetPath.isEmpty()) return;
+
+        KisPaintOpPresetSP preset = new KisPaintOpPreset(m_externalPresetPath);
+        if (!preset->load()) {
+            qWarning() << "Failed to load preset" << m_externalPresetPath;
+            return;
+        }
+
+        QVariant v;
+        v.setValue(preset);
+        manager->setResource(KisCanvasResourceProvider::CurrentPaintOpPreset, v);
+    }
+
+    KisStrokeStrategy* createStroke(KisResourcesSnapshotSP resources,
+                                    KisImageWSP image) override {
+        Q_UNUSED(image);
+
+        m_stats.reset();
+
+        KisFreehandStrokeInfo *strokeInfo = new KisFreehandStrokeInfo();
+        return new TimedFreehandStrokeStrategy(resources, strokeInfo, &m_stats);
+    }
+
+    using utils::StrokeTester::addPaintingJobs;
+    void addPaintingJobs(KisImageWSP image,
+                         KisResourcesSnapshotSP resources) override {
+        Q_UNUSED(resources);
+
+        Q_FOREACH (const KisFreehandStrokeRecording::Event &event, m_recording.events()) {
+            if (m_realTimeReplay) {
+                const qint64 delay = qint64(event.timestamp) - m_stats.now() / 1000000;
+                if (delay > 0) {
+                    QThread::msleep(delay);
+                }
+            }
+
+            if (event.type == KisFreehandStrokeRecording::AsynchronousUpdate) {
+                image->addJob(strokeId(), new FreehandStrokeStrategy::UpdateData(event.forceUpdate));
+            } else {
+                image->addJob(strokeId(), new TimedData(event, m_stats.now()));
+            }
+        }
+
+        // the stroke is going to be ended right after we return
+        m_stats.strokeEndedTime = m_stats.now();
+    }
+
+private:
+    const KisFreehandStrokeRecording &m_recording;
+    QString m_externalPresetPath;
+    bool m_realTimeReplay = false;
+    ReplayStats m_stats;
+};
+
+qreal percentile(const QVector<qint64> &sortedValues, qreal portion)
+{
+    if (sortedValues.isEmpty()) return 0.0;
+
+    const int index = qBound(0, qCeil(portion * sortedValues.size()) - 1, sortedValues.size() - 1);
+    return sortedValues[index] / 1e6;
+}
+
+void reportStats(const QString &title, ReplayStats &stats, int strokeTime)
+{
+    QVector<qint64> latencies = stats.latencies;
+    std::sort(latencies.begin(), latencies.end());
+
+    const qreal dabsPerSecond = strokeTime > 0 ? 1000.0 * stats.numDabs / strokeTime : 0.0;
+
+    qDebug() << qPrintable(title);
+    qDebug() << qPrintable(QString("    Stroke time: %1 ms, dabs: %2, dabs/s: %3")
+                           .arg(strokeTime).arg(stats.numDabs).arg(dabsPerSecond, 0, 'f', 1));
+    qDebug() << qPrintable(QString("    Latency p50: %1 ms, p90: %2 ms, p99: %3 ms, max: %4 ms")
+                           .arg(percentile(latencies, 0.5), 0, 'f', 2)
+                           .arg(percentile(latencies, 0.9), 0, 'f', 2)
+                           .arg(percentile(latencies, 0.99), 0, 'f', 2)
+                           .arg(percentile(latencies, 1.0), 0, 'f', 2));
+    qDebug() << qPrintable(QString("    Paintop: %1 ms, update: %2 ms, async update: %3 ms, finish: %4 ms, end-to-done: %5 ms")
+                           .arg(stats.paintOpTime / 1e6, 0, 'f', 2)
+                           .arg(stats.updateTime / 1e6, 0, 'f', 2)
+                           .arg(stats.asyncUpdateTime / 1e6, 0, 'f', 2)
+                           .arg(stats.finishTime / 1e6, 0, 'f', 2)
+                           .arg((stats.clock.nsecsElapsed() - stats.strokeEndedTime) / 1e6, 0, 'f', 2));
+}
+
+void replayStroke(bool realTime)
+{
+    QString recordingPath = QString::fromLocal8Bit(qgetenv("KRITA_REPLAY_STROKE"));
+    if (recordingPath.isEmpty()) {
+        recordingPath = TestUtil::fetchDataFileLazy(defaultRecording);
+    }
+
+    KisFreehandStrokeRecording recording;
+    QVERIFY(recording.load(recordingPath));
+    QVERIFY(!recording.isEmpty());
+
+    const QString externalPreset = QString::fromLocal8Bit(qgetenv("KRITA_REPLAY_PRESET"));
+
+    QString presetFilename = defaultPreset;
+    if (!recording.presetName().isEmpty() &&
+        !TestUtil::fetchDataFileLazy(recording.presetName()).isEmpty()) {
+
+        presetFilename = recording.presetName();
+    }
+
+    StrokeReplayTester tester(recording, presetFilename, externalPreset);
+    tester.setRealTimeReplay(realTime);
+    tester.benchmark();
+
+    reportStats(QString("Replayed %1 (%2 events, %3 ms recorded) with %4")
+                .arg(QFileInfo(recordingPath).fileName())
+                .arg(recording.events().size())
+                .arg(recording.duration())
+                .arg(!externalPreset.isEmpty() ? externalPreset : presetFilename),
+                tester.stats(), tester.lastStrokeTime());
+}
+
+}
+
+#include <KoResourcePaths.h>
+
+void KisStrokeReplayBenchmark::initTestCase()
+{
+    KoResourcePaths::addResourceType("kis_brushes", "data", FILES_DATA_DIR);
+}
+
+void KisStrokeReplayBenchmark::testReplayAsFastAsPossible()
+{
+    replayStroke(false);
+}
+
+void KisStrokeReplayBenchmark::testReplayRealTime()
+{
+    replayStroke(true);
+}
+
+QTEST_MAIN(KisStrokeReplayBenchmark)
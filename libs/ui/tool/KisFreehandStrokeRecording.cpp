@@ -0,0 +1,250 @@
+/*
+ *  Copyright (c) 2020 Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "KisFreehandStrokeRecording.h"
+
+#include <QDomDocument>
+#include <QFile>
+
+#include "kis_debug.h"
+#include "kis_dom_utils.h"
+
+
+namespace {
+
+QString eventTypeToString(KisFreehandStrokeRecording::EventType type)
+{
+    switch (type) {
+    case KisFreehandStrokeRecording::PaintAt:
+        return "paintAt";
+    case KisFreehandStrokeRecording::PaintLine:
+        return "paintLine";
+    case KisFreehandStrokeRecording::PaintBezierCurve:
+        return "paintBezierCurve";
+    case KisFreehandStrokeRecording::AsynchronousUpdate:
+        return "update";
+    }
+
+    return QString();
+}
+
+bool eventTypeFromString(const QString &str, KisFreehandStrokeRecording::EventType *type)
+{
+    if (str == "paintAt") {
+        *type = KisFreehandStrokeRecording::PaintAt;
+    } else if (str == "paintLine") {
+        *type = KisFreehandStrokeRecording::PaintLine;
+    } else if (str == "paintBezierCurve") {
+        *type = KisFreehandStrokeRecording::PaintBezierCurve;
+    } else if (str == "update") {
+        *type = KisFreehandStrokeRecording::AsynchronousUpdate;
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+void savePaintInformation(QDomDocument &doc, QDomElement &parent,
+                          const QString &tag, const KisPaintInformation &pi)
+{
+    QDomElement e = doc.createElement(tag);
+    pi.toXML(doc, e);
+    parent.appendChild(e);
+}
+
+}
+
+KisFreehandStrokeRecording::KisFreehandStrokeRecording()
+{
+}
+
+void KisFreehandStrokeRecording::setPresetName(const QString &name)
+{
+    m_presetName = name;
+}
+
+QString KisFreehandStrokeRecording::presetName() const
+{
+    return m_presetName;
+}
+
+void KisFreehandStrokeRecording::addPaintAt(int timestamp, int strokeInfoId, const KisPaintInformation &pi)
+{
+    Event event;
+    event.type = PaintAt;
+    event.timestamp = timestamp;
+    event.strokeInfoId = strokeInfoId;
+    event.pi1 = pi;
+    m_events.append(event);
+}
+
+void KisFreehandStrokeRecording::addPaintLine(int timestamp, int strokeInfoId,
+                                              const KisPaintInformation &pi1,
+                                              const KisPaintInformation &pi2)
+{
+    Event event;
+    event.type = PaintLine;
+    event.timestamp = timestamp;
+    event.strokeInfoId = strokeInfoId;
+    event.pi1 = pi1;
+    event.pi2 = pi2;
+    m_events.append(event);
+}
+
+void KisFreehandStrokeRecording::addPaintBezierCurve(int timestamp, int strokeInfoId,
+                                                     const KisPaintInformation &pi1,
+                                                     const QPointF &control1,
+                                                     const QPointF &control2,
+                                                     const KisPaintInformation &pi2)
+{
+    Event event;
+    event.type = PaintBezierCurve;
+    event.timestamp = timestamp;
+    event.strokeInfoId = strokeInfoId;
+    event.pi1 = pi1;
+    event.control1 = control1;
+    event.control2 = control2;
+    event.pi2 = pi2;
+    m_events.append(event);
+}
+
+void KisFreehandStrokeRecording::addAsynchronousUpdate(int timestamp, bool forceUpdate)
+{
+    Event event;
+    event.type = AsynchronousUpdate;
+    event.timestamp = timestamp;
+    event.forceUpdate = forceUpdate;
+    m_events.append(event);
+}
+
+const QVector<KisFreehandStrokeRecording::Event> &KisFreehandStrokeRecording::events() const
+{
+    return m_events;
+}
+
+bool KisFreehandStrokeRecording::isEmpty() const
+{
+    return m_events.isEmpty();
+}
+
+int KisFreehandStrokeRecording::duration() const
+{
+    return !m_events.isEmpty() ? m_events.last().timestamp : 0;
+}
+
+bool KisFreehandStrokeRecording::save(const QString &fileName) const
+{
+    QDomDocument doc("freehand-stroke");
+    QDomElement root = doc.createElement("freehand-stroke");
+    root.setAttribute("version", 1);
+    root.setAttribute("preset", m_presetName);
+    doc.appendChild(root);
+
+    Q_FOREACH (const Event &event, m_events) {
+        QDomElement e = doc.createElement("event");
+        e.setAttribute("type", eventTypeToString(event.type));
+        e.setAttribute("time", event.timestamp);
+
+        if (event.type == AsynchronousUpdate) {
+            e.setAttribute("forceUpdate", int(event.forceUpdate));
+        } else {
+            e.setAttribute("strokeInfoId", event.strokeInfoId);
+            savePaintInformation(doc, e, "pi1", event.pi1);
+
+            if (event.type != PaintAt) {
+                savePaintInformation(doc, e, "pi2", event.pi2);
+            }
+
+            if (event.type == PaintBezierCurve) {
+                KisDomUtils::saveValue(&e, "control1", event.control1);
+                KisDomUtils::saveValue(&e, "control2", event.control2);
+            }
+        }
+
+        root.appendChild(e);
+    }
+
+    QFile file(fileName);
+    if (!file.open(QFile::WriteOnly)) {
+        warnUI << "Failed to save stroke recording:" << fileName << file.errorString();
+        return false;
+    }
+
+    file.write(doc.toByteArray());
+    return true;
+}
+
+bool KisFreehandStrokeRecording::load(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QFile::ReadOnly)) {
+        warnUI << "Failed to open stroke recording:" << fileName << file.errorString();
+        return false;
+    }
+
+    QDomDocument doc;
+    QString errorMessage;
+    if (!doc.setContent(&file, &errorMessage)) {
+        warnUI << "Failed to parse stroke recording:" << fileName << errorMessage;
+        return false;
+    }
+
+    QDomElement root = doc.documentElement();
+    if (root.tagName() != "freehand-stroke") {
+        warnUI << "Not a stroke recording:" << fileName;
+        return false;
+    }
+
+    m_presetName = root.attribute("preset");
+    m_events.clear();
+
+    for (QDomElement e = root.firstChildElement("event");
+         !e.isNull();
+         e = e.nextSiblingElement("event")) {
+
+        Event event;
+
+        if (!eventTypeFromString(e.attribute("type"), &event.type)) {
+            warnUI << "Unknown stroke recording event:" << e.attribute("type");
+            return false;
+        }
+
+        event.timestamp = KisDomUtils::toInt(e.attribute("time", "0"));
+
+        if (event.type == AsynchronousUpdate) {
+            event.forceUpdate = KisDomUtils::toInt(e.attribute("forceUpdate", "0"));
+        } else {
+            event.strokeInfoId = KisDomUtils::toInt(e.attribute("strokeInfoId", "0"));
+            event.pi1 = KisPaintInformation::fromXML(e.firstChildElement("pi1"));
+
+            if (event.type != PaintAt) {
+                event.pi2 = KisPaintInformation::fromXML(e.firstChildElement("pi2"));
+            }
+
+            if (event.type == PaintBezierCurve) {
+                KisDomUtils::loadValue(e, "control1", &event.control1);
+                KisDomUtils::loadValue(e, "control2", &event.control2);
+            }
+        }
+
+        m_events.append(event);
+    }
+
+    return true;
+}
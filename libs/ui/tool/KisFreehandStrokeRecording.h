@@ -0,0 +1,93 @@
+/*
+ *  Copyright (c) 2020 Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KISFREEHANDSTROKERECORDING_H
+#define KISFREEHANDSTROKERECORDING_H
+
+#include <QString>
+#include <QVector>
+#include <QPointF>
+
+#include <brushengine/kis_paint_information.h>
+#include "kritaui_export.h"
+
+/**
+ * A serializable log of the painting jobs KisToolFreehandHelper sends to
+ * FreehandStrokeStrategy. Every event keeps the full KisPaintInformation
+ * (pressure, tilt, rotation, speed, time) and the moment, relative to the
+ * start of the stroke, at which it was emitted, so that the stroke can later
+ * be replayed headless with the original timing.
+ *
+ * The recorder is enabled with "strokeRecordingDirectory" in kritarc.
+ */
+class KRITAUI_EXPORT KisFreehandStrokeRecording
+{
+public:
+    enum EventType {
+        PaintAt,
+        PaintLine,
+        PaintBezierCurve,
+        AsynchronousUpdate
+    };
+
+    struct Event {
+        EventType type = PaintAt;
+        int strokeInfoId = 0;
+        int timestamp = 0;
+        bool forceUpdate = false;
+
+        KisPaintInformation pi1;
+        KisPaintInformation pi2;
+        QPointF control1;
+        QPointF control2;
+    };
+
+public:
+    KisFreehandStrokeRecording();
+
+    void setPresetName(const QString &name);
+    QString presetName() const;
+
+    void addPaintAt(int timestamp, int strokeInfoId, const KisPaintInformation &pi);
+    void addPaintLine(int timestamp, int strokeInfoId,
+                      const KisPaintInformation &pi1,
+                      const KisPaintInformation &pi2);
+    void addPaintBezierCurve(int timestamp, int strokeInfoId,
+                             const KisPaintInformation &pi1,
+                             const QPointF &control1,
+                             const QPointF &control2,
+                             const KisPaintInformation &pi2);
+    void addAsynchronousUpdate(int timestamp, bool forceUpdate);
+
+    const QVector<Event>& events() const;
+    bool isEmpty() const;
+
+    /**
+     * Duration of the recorded stroke in milliseconds
+     */
+    int duration() const;
+
+    bool save(const QString &fileName) const;
+    bool load(const QString &fileName);
+
+private:
+    QString m_presetName;
+    QVector<Event> m_events;
+};
+
+#endif // KISFREEHANDSTROKERECORDING_H
@@ -20,6 +20,9 @@
 
 #include <QTimer>
 #include <QQueue>
+#include <QDateTime>
+#include <QScopedPointer>
+#include <QDir>
 
 #include <klocalizedstring.h>
 
@@ -44,6 +47,7 @@
 
 #include "strokes/freehand_stroke.h"
 #include "strokes/KisFreehandStrokeInfo.h"
+#include "KisFreehandStrokeRecording.h"
 
 #include <math.h>
 
@@ -114,6 +118,9 @@ struct KisToolFreehandHelper::Private
     int canvasRotation;
     bool canvasMirroredH;
 
+    QScopedPointer<KisFreehandStrokeRecording> recording;
+    QString recordingDirectory;
+
     qreal effectiveSmoothnessDistance() const;
 };
 
@@ -312,6 +319,18 @@ void KisToolFreehandHelper::initPaintImpl(qreal startAngle,
 
     m_d->strokeId = m_d->strokesFacade->startStroke(stroke);
 
+    m_d->recordingDirectory = KisConfig(true).strokeRecordingDirectory();
+    if (!m_d->recordingDirectory.isEmpty()) {
+        m_d->recording.reset(new KisFreehandStrokeRecording());
+
+        KisPaintOpPresetSP preset = m_d->resources->currentPaintOpPreset();
+        if (preset) {
+            m_d->recording->setPresetName(preset->name());
+        }
+    } else {
+        m_d->recording.reset();
+    }
+
     m_d->history.clear();
     m_d->distanceHistory.clear();
 
@@ -645,6 +664,16 @@ void KisToolFreehandHelper::endPaint()
 
     m_d->strokesFacade->endStroke(m_d->strokeId);
     m_d->strokeId.clear();
+
+    if (m_d->recording) {
+        const QString fileName =
+            QDir(m_d->recordingDirectory).filePath(
+                QString("stroke-%1.xml")
+                    .arg(QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss-zzz")));
+
+        m_d->recording->save(fileName);
+        m_d->recording.reset();
+    }
 }
 
 void KisToolFreehandHelper::cancelPaint()
@@ -675,6 +704,8 @@ void KisToolFreehandHelper::cancelPaint()
     m_d->strokesFacade->cancelStroke(m_d->strokeId);
     m_d->strokeId.clear();
 
+    m_d->recording.reset();
+
 }
 
 int KisToolFreehandHelper::elapsedStrokeTime() const
@@ -892,6 +923,10 @@ void KisToolFreehandHelper::doAirbrushing()
 
 void KisToolFreehandHelper::doAsynchronousUpdate(bool forceUpdate)
 {
+    if (m_d->recording) {
+        m_d->recording->addAsynchronousUpdate(elapsedStrokeTime(), forceUpdate);
+    }
+
     m_d->strokesFacade->addJob(m_d->strokeId,
                                new FreehandStrokeStrategy::UpdateData(forceUpdate));
 }
@@ -906,6 +941,11 @@ void KisToolFreehandHelper::paintAt(int strokeInfoId,
                                     const KisPaintInformation &pi)
 {
     m_d->hasPaintAtLeastOnce = true;
+
+    if (m_d->recording) {
+        m_d->recording->addPaintAt(elapsedStrokeTime(), strokeInfoId, pi);
+    }
+
     m_d->strokesFacade->addJob(m_d->strokeId,
                                new FreehandStrokeStrategy::Data(strokeInfoId, pi));
 
@@ -916,6 +956,11 @@ void KisToolFreehandHelper::paintLine(int strokeInfoId,
                                       const KisPaintInformation &pi2)
 {
     m_d->hasPaintAtLeastOnce = true;
+
+    if (m_d->recording) {
+        m_d->recording->addPaintLine(elapsedStrokeTime(), strokeInfoId, pi1, pi2);
+    }
+
     m_d->strokesFacade->addJob(m_d->strokeId,
                                new FreehandStrokeStrategy::Data(strokeInfoId, pi1, pi2));
 
@@ -952,6 +997,12 @@ void KisToolFreehandHelper::paintBezierCurve(int strokeInfoId,
 #endif
 
     m_d->hasPaintAtLeastOnce = true;
+
+    if (m_d->recording) {
+        m_d->recording->addPaintBezierCurve(elapsedStrokeTime(), strokeInfoId,
+                                            pi1, control1, control2, pi2);
+    }
+
     m_d->strokesFacade->addJob(m_d->strokeId,
                                new FreehandStrokeStrategy::Data(strokeInfoId,
                                                                 pi1, control1, control2, pi2));
@@ -19,6 +19,8 @@
 #include "freehand_stroke.h"
 
 #include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
 
 #include "kis_canvas_resource_provider.h"
 #include <brushengine/kis_paintop_preset.h>
@@ -39,6 +41,7 @@
 #include <strokes/KisMaskedFreehandStrokePainter.h>
 
 #include "brushengine/kis_paintop_utils.h"
+#include "KisLatencyTracer.h"
 
 
 struct FreehandStrokeStrategy::Private
@@ -72,6 +75,13 @@ struct FreehandStrokeStrategy::Private
 
     const bool needsAsynchronousUpdates = false;
     std::mutex updateEntryMutex;
+
+    /**
+     * Latency traces of the painting jobs whose dirty rects
+     * have not been issued yet
+     */
+    QMutex pendingTracesLock;
+    KisLatencyTracer::TraceIds pendingTraces;
 };
 
 FreehandStrokeStrategy::FreehandStrokeStrategy(KisResourcesSnapshotSP resources,
@@ -213,6 +223,14 @@ void FreehandStrokeStrategy::doStrokeCallback(KisStrokeJobData *data)
             break;
         };
 
+        if (KisLatencyTracer::instance()->isEnabled()) {
+            const KisLatencyTracer::TraceIds traceIds = KisLatencyTracer::currentTraces();
+            if (!traceIds.isEmpty()) {
+                QMutexLocker l(&m_d->pendingTracesLock);
+                m_d->pendingTraces += traceIds;
+            }
+        }
+
         tryDoUpdate();
     } else {
         KisPainterBasedStrokeStrategy::doStrokeCallback(data);
@@ -281,6 +299,21 @@ void FreehandStrokeStrategy::tryDoUpdate(bool forceEnd)
 
 void FreehandStrokeStrategy::issueSetDirtySignals()
 {
+    KisLatencyTracer::TraceIds traceIds;
+
+    if (KisLatencyTracer::instance()->isEnabled()) {
+        {
+            QMutexLocker l(&m_d->pendingTracesLock);
+            traceIds.swap(m_d->pendingTraces);
+        }
+
+        Q_FOREACH (quint64 id, KisLatencyTracer::currentTraces()) {
+            if (!traceIds.contains(id)) {
+                traceIds << id;
+            }
+        }
+    }
+
     QVector<QRect> dirtyRects;
 
     for (int i = 0; i < numMaskedPainters(); i++) {
@@ -315,14 +348,22 @@ void FreehandStrokeStrategy::issueSetDirtySignals()
         QVector<KisRunnableStrokeJobData*> jobs = doMaskingBrushUpdates(dirtyRects);
 
         jobs.append(new KisRunnableStrokeJobData(
-            [this, dirtyRects] () {
-                this->targetNode()->setDirty(dirtyRects);
+            [this, dirtyRects, traceIds] () {
+                if (traceIds.isEmpty()) {
+                    this->targetNode()->setDirty(dirtyRects);
+                } else {
+                    KisLatencyTracer::ScopedCurrentTraces currentTraces(traceIds);
+                    this->targetNode()->setDirty(dirtyRects);
+                }
             },
             KisStrokeJobData::SEQUENTIAL));
 
         runnableJobsInterface()->addRunnableJobs(jobs);
 
+    } else if (traceIds.isEmpty()) {
+        targetNode()->setDirty(dirtyRects);
     } else {
+        KisLatencyTracer::ScopedCurrentTraces currentTraces(traceIds);
         targetNode()->setDirty(dirtyRects);
     }
 
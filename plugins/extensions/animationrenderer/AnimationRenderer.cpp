@@ -102,6 +102,33 @@ void AnimaterionRenderer::slotRenderSequenceAgain()
     renderAnimationImpl(doc, encoderOptions);
 }
 
+KisImportExportErrorCode AnimaterionRenderer::prepareVideoFile(const KisAnimationRenderingOptions &encoderOptions)
+{
+    const QString resultFile = encoderOptions.resolveAbsoluteVideoFilePath();
+    KIS_SAFE_ASSERT_RECOVER_NOOP(QFileInfo(resultFile).isAbsolute())
+
+    {
+        const QFileInfo info(resultFile);
+        QDir dir(info.absolutePath());
+
+        if (!dir.exists()) {
+            dir.mkpath(info.absolutePath());
+        }
+        KIS_SAFE_ASSERT_RECOVER_NOOP(dir.exists());
+    }
+
+    KisImportExportErrorCode res = ImportExportCodes::OK;
+    QFile fi(resultFile);
+    if (!fi.open(QIODevice::WriteOnly)) {
+        qWarning() << "Could not open" << fi.fileName() << "for writing!";
+        res = KisImportExportErrorCannotWrite(fi.error());
+    } else {
+        fi.close();
+    }
+
+    return res;
+}
+
 void AnimaterionRenderer::renderAnimationImpl(KisDocument *doc, KisAnimationRenderingOptions encoderOptions)
 {
     const QString frameMimeType = encoderOptions.frameMimeType;
@@ -143,6 +170,28 @@ void AnimaterionRenderer::renderAnimationImpl(KisDocument *doc, KisAnimationRend
     }
 
     const bool batchMode = false; // TODO: fetch correctly!
+
+    /**
+     * If the image sequence is not needed, the frames are passed
+     * directly to ffmpeg without saving them on disk
+     */
+    if (encoderOptions.renderMode() == KisAnimationRenderingOptions::RENDER_VIDEO_ONLY &&
+        VideoSaver::supportsStreaming(encoderOptions)) {
+
+        KisImportExportErrorCode res = prepareVideoFile(encoderOptions);
+
+        if (res.isOk()) {
+            QScopedPointer<VideoSaver> encoder(new VideoSaver(doc, batchMode));
+            res = encoder->encodeStreaming(encoderOptions, viewManager()->mainWindow()->viewManager());
+        }
+
+        if (!res.isOk() && !res.isCancelled()) {
+            QMessageBox::critical(0, i18nc("@title:window", "Krita"), i18n("Could not render animation:\n%1", res.errorMessage()));
+        }
+
+        return;
+    }
+
     KisAsyncAnimationFramesSaveDialog exporter(doc->image(),
                                                KisTimeRange::fromTime(encoderOptions.firstFrame,
                                                                       encoderOptions.lastFrame),
@@ -161,27 +210,7 @@ void AnimaterionRenderer::renderAnimationImpl(KisDocument *doc, KisAnimationRend
 
         const QString savedFilesMask = exporter.savedFilesMask();
 
-        const QString resultFile = encoderOptions.resolveAbsoluteVideoFilePath();
-        KIS_SAFE_ASSERT_RECOVER_NOOP(QFileInfo(resultFile).isAbsolute())
-
-        {
-            const QFileInfo info(resultFile);
-            QDir dir(info.absolutePath());
-
-            if (!dir.exists()) {
-                dir.mkpath(info.absolutePath());
-            }
-            KIS_SAFE_ASSERT_RECOVER_NOOP(dir.exists());
-        }
-
-        KisImportExportErrorCode res;
-        QFile fi(resultFile);
-        if (!fi.open(QIODevice::WriteOnly)) {
-            qWarning() << "Could not open" << fi.fileName() << "for writing!";
-            res = KisImportExportErrorCannotWrite(fi.error());
-        } else {
-            fi.close();
-        }
+        KisImportExportErrorCode res = prepareVideoFile(encoderOptions);
 
         QScopedPointer<VideoSaver> encoder(new VideoSaver(doc, batchMode));
         res = encoder->convert(doc, savedFilesMask, encoderOptions, batchMode);
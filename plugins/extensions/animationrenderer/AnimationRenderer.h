@@ -21,6 +21,8 @@
 #include <QVariant>
 
 #include <KisActionPlugin.h>
+#include <KisImportExportErrorCode.h>
+
 class KisAnimationRenderingOptions;
 class KisDocument;
 
@@ -55,6 +57,12 @@ private Q_SLOTS:
 private:
     void renderAnimationImpl(KisDocument *doc, KisAnimationRenderingOptions encoderOptions);
 
+    /**
+     * Creates the directory for the video file and checks
+     * that the file is writable
+     */
+    static KisImportExportErrorCode prepareVideoFile(const KisAnimationRenderingOptions &encoderOptions);
+
 };
 
 #endif // ANIMATIONRENDERERIMAGE_H
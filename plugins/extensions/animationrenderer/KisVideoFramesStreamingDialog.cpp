@@ -0,0 +1,266 @@
+/*
+ *  Copyright (c) 2020 Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "KisVideoFramesStreamingDialog.h"
+
+#include <QProcess>
+
+#include <klocalizedstring.h>
+
+#include <KoColorSpace.h>
+#include <KoColorSpaceRegistry.h>
+#include <KoColorModelStandardIds.h>
+
+#include <kis_image.h>
+#include <kis_paint_device.h>
+
+
+KisVideoFrameQueue::KisVideoFrameQueue(QProcess *process, const KisTimeRange &range, int capacity)
+    : m_process(process),
+      m_range(range),
+      m_capacity(capacity),
+      m_nextFrame(range.start())
+{
+    connect(this, SIGNAL(sigFrameAdded()), SLOT(slotWriteFrames()), Qt::QueuedConnection);
+    connect(m_process, SIGNAL(bytesWritten(qint64)), SLOT(slotWriteFrames()));
+    connect(m_process, SIGNAL(finished(int,QProcess::ExitStatus)), SLOT(slotProcessFinished()));
+    connect(m_process, SIGNAL(error(QProcess::ProcessError)), SLOT(slotProcessFinished()));
+}
+
+KisVideoFrameQueue::~KisVideoFrameQueue()
+{
+    abort();
+}
+
+bool KisVideoFrameQueue::pushFrame(int frame, const QByteArray &data)
+{
+    {
+        QMutexLocker l(&m_mutex);
+
+        while (!m_isAborted &&
+               frame != m_nextFrame &&
+               m_frames.size() >= m_capacity) {
+
+            m_frameTaken.wait(&m_mutex);
+        }
+
+        if (m_isAborted) return false;
+
+        m_frames.insert(frame, data);
+    }
+
+    emit sigFrameAdded();
+
+    return true;
+}
+
+void KisVideoFrameQueue::abort()
+{
+    QMutexLocker l(&m_mutex);
+    m_isAborted = true;
+    m_frames.clear();
+    m_frameTaken.wakeAll();
+}
+
+bool KisVideoFrameQueue::isAborted() const
+{
+    QMutexLocker l(&m_mutex);
+    return m_isAborted;
+}
+
+void KisVideoFrameQueue::slotWriteFrames()
+{
+    while (m_nextFrame <= m_range.end()) {
+        QByteArray data;
+
+        {
+            QMutexLocker l(&m_mutex);
+            if (m_isAborted) return;
+
+            auto it = m_frames.find(m_nextFrame);
+            if (it == m_frames.end()) return;
+
+            /**
+             * QProcess buffers all the written data internally, so we
+             * should wait for ffmpeg to consume the previous frame,
+             * otherwise the limit of the queue would be meaningless.
+             */
+            if (m_process->bytesToWrite() >= it->size()) return;
+
+            data = it.value();
+            m_frames.erase(it);
+            m_nextFrame++;
+
+            m_frameTaken.wakeAll();
+        }
+
+        m_process->write(data);
+    }
+
+    if (m_process->state() != QProcess::NotRunning) {
+        // ffmpeg will finish encoding as soon as it reads everything
+        m_process->closeWriteChannel();
+    }
+}
+
+void KisVideoFrameQueue::slotProcessFinished()
+{
+    abort();
+}
+
+
+KisVideoFramesStreamingRenderer::KisVideoFramesStreamingRenderer(KisVideoFrameQueue *queue, const KoColorSpace *dstColorSpace)
+    : m_queue(queue),
+      m_dstColorSpace(dstColorSpace)
+{
+    connect(this, SIGNAL(sigCompleteRegenerationInternal(int)), SLOT(notifyFrameCompleted(int)));
+    connect(this, SIGNAL(sigCancelRegenerationInternal(int)), SLOT(notifyFrameCancelled(int)));
+}
+
+void KisVideoFramesStreamingRenderer::frameCompletedCallback(int frame, const QRegion &requestedRegion)
+{
+    KisImageSP image = requestedImage();
+    if (!image) return;
+
+    KIS_SAFE_ASSERT_RECOVER (requestedRegion == image->bounds()) {
+        emit sigCancelRegenerationInternal(frame);
+        return;
+    }
+
+    const QRect bounds = image->bounds();
+    const int numPixels = bounds.width() * bounds.height();
+
+    KisPaintDeviceSP projection = image->projection();
+    const KoColorSpace *srcColorSpace = projection->colorSpace();
+
+    QByteArray data(numPixels * m_dstColorSpace->pixelSize(), Qt::Uninitialized);
+
+    if (*srcColorSpace == *m_dstColorSpace) {
+        projection->readBytes(reinterpret_cast<quint8*>(data.data()), bounds);
+    } else {
+        QVector<quint8> srcData(numPixels * srcColorSpace->pixelSize());
+        projection->readBytes(srcData.data(), bounds);
+
+        srcColorSpace->convertPixelsTo(srcData.constData(), reinterpret_cast<quint8*>(data.data()),
+                                       m_dstColorSpace, numPixels,
+                                       KoColorConversionTransformation::internalRenderingIntent(),
+                                       KoColorConversionTransformation::internalConversionFlags());
+    }
+
+    // blocks if the encoder cannot keep up with the renderers
+    if (m_queue->pushFrame(frame, data)) {
+        emit sigCompleteRegenerationInternal(frame);
+    } else {
+        emit sigCancelRegenerationInternal(frame);
+    }
+}
+
+void KisVideoFramesStreamingRenderer::frameCancelledCallback(int frame)
+{
+    // wake up the renderers waiting for the queue
+    m_queue->abort();
+    notifyFrameCancelled(frame);
+}
+
+
+struct KisVideoFramesStreamingDialog::Private
+{
+    KisTimeRange range;
+    const KoColorSpace *dstColorSpace = 0;
+    QScopedPointer<KisVideoFrameQueue> queue;
+};
+
+KisVideoFramesStreamingDialog::KisVideoFramesStreamingDialog(KisImageSP image, const KisTimeRange &range, QProcess *process,
+                                                             KisPropertiesConfigurationSP frameExportConfig)
+    : KisAsyncAnimationRenderDialogBase(i18n("Rendering video..."), image),
+      m_d(new Private())
+{
+    /**
+     * The frames waiting for being encoded may take up to this
+     * amount of memory
+     */
+    const qint64 maxQueueMemory = 512 * 1024 * 1024;
+
+    m_d->range = range;
+    m_d->dstColorSpace = streamingColorSpace(image, frameExportConfig);
+
+    const qint64 frameSize = qint64(image->width()) * image->height() * m_d->dstColorSpace->pixelSize();
+    const int capacity = qBound(qint64(2), maxQueueMemory / qMax(qint64(1), frameSize), qint64(64));
+
+    m_d->queue.reset(new KisVideoFrameQueue(process, range, capacity));
+}
+
+KisVideoFramesStreamingDialog::~KisVideoFramesStreamingDialog()
+{
+}
+
+const KoColorSpace *KisVideoFramesStreamingDialog::streamingColorSpace(KisImageSP image, KisPropertiesConfigurationSP frameExportConfig)
+{
+    const KoColorSpace *cs = image->colorSpace();
+
+    const bool saveAsHDR = frameExportConfig && frameExportConfig->getBool("saveAsHDR", false);
+    const bool forceSRGB = !saveAsHDR && frameExportConfig && frameExportConfig->getBool("forceSRGB", false);
+
+    if (saveAsHDR) {
+        return KoColorSpaceRegistry::instance()->colorSpace(RGBAColorModelID.id(),
+                                                            Integer16BitsColorDepthID.id(),
+                                                            KoColorSpaceRegistry::instance()->p2020PQProfile());
+    }
+
+    const QString depthId = cs->colorDepthId() == Integer8BitsColorDepthID ?
+        Integer8BitsColorDepthID.id() : Integer16BitsColorDepthID.id();
+
+    if (forceSRGB || cs->colorModelId() != RGBAColorModelID) {
+        return KoColorSpaceRegistry::instance()->colorSpace(RGBAColorModelID.id(), depthId, "sRGB built-in - (lcms internal)");
+    }
+
+    return KoColorSpaceRegistry::instance()->colorSpace(RGBAColorModelID.id(), depthId, cs->profile());
+}
+
+QString KisVideoFramesStreamingDialog::ffmpegPixelFormat(KisImageSP image, KisPropertiesConfigurationSP frameExportConfig)
+{
+    // integer RGBA color spaces store pixels in BGRA order
+    return streamingColorSpace(image, frameExportConfig)->colorDepthId() == Integer8BitsColorDepthID ?
+        "bgra" : "bgra64le";
+}
+
+QList<int> KisVideoFramesStreamingDialog::calcDirtyFrames() const
+{
+    QList<int> result;
+
+    // all the frames should be streamed in order
+    for (int frame = m_d->range.start(); frame <= m_d->range.end(); frame++) {
+        result.append(frame);
+    }
+
+    return result;
+}
+
+KisAsyncAnimationRendererBase *KisVideoFramesStreamingDialog::createRenderer(KisImageSP image)
+{
+    Q_UNUSED(image);
+    return new KisVideoFramesStreamingRenderer(m_d->queue.data(), m_d->dstColorSpace);
+}
+
+void KisVideoFramesStreamingDialog::initializeRendererForFrame(KisAsyncAnimationRendererBase *renderer, KisImageSP image, int frame)
+{
+    Q_UNUSED(renderer);
+    Q_UNUSED(image);
+    Q_UNUSED(frame);
+}
@@ -0,0 +1,151 @@
+/*
+ *  Copyright (c) 2020 Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef KISVIDEOFRAMESSTREAMINGDIALOG_H
+#define KISVIDEOFRAMESSTREAMINGDIALOG_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QMap>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QScopedPointer>
+
+#include <dialogs/KisAsyncAnimationRenderDialogBase.h>
+#include <KisAsyncAnimationRendererBase.h>
+#include <kis_time_range.h>
+#include <kis_properties_configuration.h>
+
+class QProcess;
+class KoColorSpace;
+
+/**
+ * A bounded queue of raw frames between the frame renderers and the
+ * standard input of an ffmpeg process.
+ *
+ * The renderers push the frames from the image worker threads in any
+ * order. The frames are written into the process in the GUI thread in
+ * the order of their numbers. When too many frames are waiting for
+ * being written, pushFrame() blocks the renderer, so the rendering
+ * never runs too far ahead of the encoding. The frame that should be
+ * written next is always accepted, otherwise the queue could deadlock.
+ */
+class KisVideoFrameQueue : public QObject
+{
+    Q_OBJECT
+public:
+    KisVideoFrameQueue(QProcess *process, const KisTimeRange &range, int capacity);
+    ~KisVideoFrameQueue() override;
+
+    /**
+     * Adds \p frame to the queue. Can be called from any thread.
+     *
+     * @return false if the queue has been aborted
+     */
+    bool pushFrame(int frame, const QByteArray &data);
+
+    /**
+     * Stops writing frames and wakes up all the blocked renderers
+     */
+    void abort();
+
+    bool isAborted() const;
+
+Q_SIGNALS:
+    void sigFrameAdded();
+
+private Q_SLOTS:
+    void slotWriteFrames();
+    void slotProcessFinished();
+
+private:
+    QProcess *m_process;
+    KisTimeRange m_range;
+    int m_capacity;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_frameTaken;
+    QMap<int, QByteArray> m_frames;
+    int m_nextFrame;
+    bool m_isAborted = false;
+};
+
+/**
+ * Renders the frames of the image and streams them into the
+ * ffmpeg process as raw video via KisVideoFrameQueue
+ */
+class KisVideoFramesStreamingRenderer : public KisAsyncAnimationRendererBase
+{
+    Q_OBJECT
+public:
+    KisVideoFramesStreamingRenderer(KisVideoFrameQueue *queue, const KoColorSpace *dstColorSpace);
+
+protected:
+    void frameCompletedCallback(int frame, const QRegion &requestedRegion) override;
+    void frameCancelledCallback(int frame) override;
+
+Q_SIGNALS:
+    void sigCompleteRegenerationInternal(int frame);
+    void sigCancelRegenerationInternal(int frame);
+
+private:
+    KisVideoFrameQueue *m_queue;
+    const KoColorSpace *m_dstColorSpace;
+};
+
+class KisVideoFramesStreamingDialog : public KisAsyncAnimationRenderDialogBase
+{
+public:
+    /**
+     * @param process the ffmpeg process that reads raw frames in the
+     *        format returned by ffmpegPixelFormat() from its standard input
+     * @param frameExportConfig the export configuration of the frames,
+     *        its "forceSRGB" and "saveAsHDR" options select the color
+     *        space the frames are streamed in
+     */
+    KisVideoFramesStreamingDialog(KisImageSP image, const KisTimeRange &range, QProcess *process,
+                                  KisPropertiesConfigurationSP frameExportConfig);
+    ~KisVideoFramesStreamingDialog() override;
+
+    /**
+     * @return the color space the frames of \p image are streamed in.
+     *         It is chosen in the same way as the PNG exporter chooses
+     *         the color space of the image sequence, so the streamed
+     *         video is encoded exactly like the one made from PNG files.
+     */
+    static const KoColorSpace* streamingColorSpace(KisImageSP image, KisPropertiesConfigurationSP frameExportConfig);
+
+    /**
+     * @return the name of ffmpeg's pixel format the frames
+     *         of \p image are streamed in
+     */
+    static QString ffmpegPixelFormat(KisImageSP image, KisPropertiesConfigurationSP frameExportConfig);
+
+protected:
+    QList<int> calcDirtyFrames() const override;
+    KisAsyncAnimationRendererBase* createRenderer(KisImageSP image) override;
+    void initializeRendererForFrame(KisAsyncAnimationRendererBase *renderer,
+                                    KisImageSP image, int frame) override;
+
+private:
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+#endif // KISVIDEOFRAMESSTREAMINGDIALOG_H
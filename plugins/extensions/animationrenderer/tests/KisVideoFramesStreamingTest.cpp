@@ -0,0 +1,165 @@
+/*
+ *  Copyright (c) 2020 Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "KisVideoFramesStreamingTest.h"
+
+#include <QProcess>
+#include <QElapsedTimer>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+
+#include <testutil.h>
+#include <kistest.h>
+
+#include <KoColor.h>
+#include <KoColorSpaceRegistry.h>
+#include <KoColorModelStandardIds.h>
+#include "kis_image.h"
+#include "kis_image_animation_interface.h"
+#include "kis_keyframe_channel.h"
+#include "kis_time_range.h"
+
+#include "KisVideoFramesStreamingDialog.h"
+
+void KisVideoFramesStreamingTest::testStreamingToFFMpeg()
+{
+    const QString ffmpegPath = QStandardPaths::findExecutable("ffmpeg");
+    if (ffmpegPath.isEmpty()) {
+        QSKIP("ffmpeg is not found in PATH");
+    }
+
+    const QRect rect(0, 0, 64, 64);
+    const int numFrames = 3;
+    const QColor colors[numFrames] = {Qt::red, Qt::green, Qt::blue};
+
+    TestUtil::MaskParent p(rect);
+    const KoColorSpace *cs = p.image->colorSpace();
+
+    KUndo2Command parentCommand;
+
+    p.layer->enableAnimation();
+    KisKeyframeChannel *rasterChannel = p.layer->getKeyframeChannel(KisKeyframeChannel::Content.id(), true);
+
+    for (int frame = 1; frame < numFrames; frame++) {
+        rasterChannel->addKeyframe(frame, &parentCommand);
+    }
+
+    const KisTimeRange range = KisTimeRange::fromTime(0, numFrames - 1);
+    p.image->animationInterface()->setFullClipRange(range);
+
+    QByteArray expectedData;
+
+    for (int frame = 0; frame < numFrames; frame++) {
+        p.image->animationInterface()->switchCurrentTimeAsync(frame);
+        p.image->waitForDone();
+
+        p.layer->paintDevice()->fill(rect, KoColor(colors[frame], cs));
+        p.layer->setDirty(rect);
+        p.image->waitForDone();
+
+        QByteArray frameData(rect.width() * rect.height() * cs->pixelSize(), Qt::Uninitialized);
+        p.image->projection()->readBytes(reinterpret_cast<quint8*>(frameData.data()), rect);
+        expectedData += frameData;
+    }
+
+    QCOMPARE(KisVideoFramesStreamingDialog::ffmpegPixelFormat(p.image, 0), QString("bgra"));
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString outputPath = dir.filePath("frames.raw");
+
+    /**
+     * ffmpeg decodes the stream and writes it back as raw video, so
+     * the result should be bit-exact
+     */
+    QStringList args;
+    args << "-y" << "-loglevel" << "error"
+         << "-f" << "rawvideo" << "-pix_fmt" << "bgra"
+         << "-s" << QString("%1x%2").arg(rect.width()).arg(rect.height())
+         << "-r" << "24"
+         << "-i" << "-"
+         << "-f" << "rawvideo" << "-pix_fmt" << "bgra"
+         << outputPath;
+
+    QProcess process;
+    process.start(ffmpegPath, args);
+    QVERIFY(process.waitForStarted());
+
+    /**
+     * The dialog should be alive until ffmpeg exits, because the queued
+     * frames are written into ffmpeg's stdin in the GUI thread and the
+     * write channel is closed only after the last frame is written.
+     */
+    KisVideoFramesStreamingDialog renderer(p.image, range, &process, 0);
+    renderer.setBatchMode(true);
+
+    QCOMPARE(renderer.regenerateRange(0), KisAsyncAnimationRenderDialogBase::RenderComplete);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    while (process.state() != QProcess::NotRunning && timer.elapsed() < 30000) {
+        QCoreApplication::processEvents();
+        process.waitForFinished(10);
+    }
+
+    QCOMPARE(process.state(), QProcess::NotRunning);
+    QCOMPARE(process.exitStatus(), QProcess::NormalExit);
+    QCOMPARE(process.exitCode(), 0);
+
+    QFile outputFile(outputPath);
+    QVERIFY(outputFile.open(QIODevice::ReadOnly));
+    const QByteArray outputData = outputFile.readAll();
+
+    QCOMPARE(outputData.size(), expectedData.size());
+    QVERIFY(outputData == expectedData);
+}
+
+void KisVideoFramesStreamingTest::testStreamingColorSpace()
+{
+    const QRect rect(0, 0, 64, 64);
+    const KoColorProfile *p2020G10 = KoColorSpaceRegistry::instance()->p2020G10Profile();
+    const KoColorProfile *p2020PQ = KoColorSpaceRegistry::instance()->p2020PQProfile();
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->colorSpace(RGBAColorModelID.id(), Integer16BitsColorDepthID.id(), p2020G10);
+
+    TestUtil::MaskParent p(rect);
+    p.image->convertImageColorSpace(cs,
+                                    KoColorConversionTransformation::internalRenderingIntent(),
+                                    KoColorConversionTransformation::internalConversionFlags());
+    p.image->waitForDone();
+
+    // without any options the frames are streamed as is
+    QVERIFY(*KisVideoFramesStreamingDialog::streamingColorSpace(p.image, 0) == *cs);
+    QCOMPARE(KisVideoFramesStreamingDialog::ffmpegPixelFormat(p.image, 0), QString("bgra64le"));
+
+    KisPropertiesConfigurationSP config = new KisPropertiesConfiguration();
+
+    config->setProperty("forceSRGB", true);
+    const KoColorSpace *srgbCS = KisVideoFramesStreamingDialog::streamingColorSpace(p.image, config);
+    QCOMPARE(srgbCS->colorDepthId(), Integer16BitsColorDepthID);
+    QCOMPARE(srgbCS->profile()->name(), QString("sRGB built-in - (lcms internal)"));
+
+    config->setProperty("forceSRGB", false);
+    config->setProperty("saveAsHDR", true);
+    const KoColorSpace *hdrCS = KisVideoFramesStreamingDialog::streamingColorSpace(p.image, config);
+    QCOMPARE(hdrCS->colorDepthId(), Integer16BitsColorDepthID);
+    QVERIFY(hdrCS->profile() == p2020PQ);
+    QCOMPARE(KisVideoFramesStreamingDialog::ffmpegPixelFormat(p.image, config), QString("bgra64le"));
+}
+
+KISTEST_MAIN(KisVideoFramesStreamingTest)
@@ -46,6 +46,7 @@
 #include <QTime>
 
 #include "KisPart.h"
+#include "KisVideoFramesStreamingDialog.h"
 
 class KisFFMpegProgressWatcher : public QObject {
     Q_OBJECT
@@ -113,22 +114,48 @@ public:
                 << "logPath" << logPath
                 << "totalFrames" << totalFrames;
 
-        QTemporaryFile progressFile(QDir::tempPath() + QDir::separator() + "KritaFFmpegProgress.XXXXXX");
-        progressFile.open();
+        startFFMpeg(specialArgs, logPath, false);
+        return waitForFinished(actionName, totalFrames);
+    }
+
+    /**
+     * Starts ffmpeg without waiting for it to finish. If \p readFromStdin
+     * is true, the frames should be written into process() and its write
+     * channel should be closed in the end.
+     */
+    void startFFMpeg(const QStringList &specialArgs,
+                     const QString &logPath,
+                     bool readFromStdin)
+    {
+        m_progressFile.reset(new QTemporaryFile(QDir::tempPath() + QDir::separator() + "KritaFFmpegProgress.XXXXXX"));
+        m_progressFile->open();
 
         m_process.setStandardOutputFile(logPath);
         m_process.setProcessChannelMode(QProcess::MergedChannels);
         QStringList args;
-        args << "-v" << "debug"
-             << "-nostdin"
-             << "-progress" << progressFile.fileName()
+        args << "-v" << "debug";
+
+        if (!readFromStdin) {
+            args << "-nostdin";
+        }
+
+        args << "-progress" << m_progressFile->fileName()
              << specialArgs;
 
         qDebug() << "\t" << m_ffmpegPath << args.join(" ");
 
         m_cancelled = false;
         m_process.start(m_ffmpegPath, args);
-        return waitForFFMpegProcess(actionName, progressFile, m_process, totalFrames);
+    }
+
+    KisImportExportErrorCode waitForFinished(const QString &actionName, int totalFrames)
+    {
+        KIS_SAFE_ASSERT_RECOVER_RETURN_VALUE(m_progressFile, ImportExportCodes::InternalError);
+        return waitForFFMpegProcess(actionName, *m_progressFile, m_process, totalFrames);
+    }
+
+    QProcess* process() {
+        return &m_process;
     }
 
     void cancel() {
@@ -182,6 +209,7 @@ private:
 
 private:
     QProcess m_process;
+    QScopedPointer<QTemporaryFile> m_progressFile;
     bool m_cancelled;
     QString m_ffmpegPath;
 };
@@ -205,6 +233,25 @@ KisImageSP VideoSaver::image()
 
 KisImportExportErrorCode VideoSaver::encode(const QString &savedFilesMask, const KisAnimationRenderingOptions &options)
 {
+    return encodeImpl(savedFilesMask, options, 0);
+}
+
+KisImportExportErrorCode VideoSaver::encodeStreaming(const KisAnimationRenderingOptions &options, KisViewManager *viewManager)
+{
+    KIS_SAFE_ASSERT_RECOVER_RETURN_VALUE(supportsStreaming(options), ImportExportCodes::InternalError);
+    return encodeImpl(QString(), options, viewManager);
+}
+
+bool VideoSaver::supportsStreaming(const KisAnimationRenderingOptions &options)
+{
+    // the palette of a gif is generated in a separate pass over all the frames
+    return QFileInfo(options.resolveAbsoluteVideoFilePath()).suffix().toLower() != "gif";
+}
+
+KisImportExportErrorCode VideoSaver::encodeImpl(const QString &savedFilesMask, const KisAnimationRenderingOptions &options, KisViewManager *viewManager)
+{
+    const bool isStreaming = savedFilesMask.isEmpty();
+
     if (!QFileInfo(options.ffmpegPath).exists()) {
         m_doc->setErrorMessage(i18n("ffmpeg could not be found at %1", options.ffmpegPath));
         return ImportExportCodes::Failure;
@@ -283,9 +330,18 @@ KisImportExportErrorCode VideoSaver::encode(const QString &savedFilesMask, const
         }
     } else {
         QStringList args;
-        args << "-r" << QString::number(options.frameRate)
-             << "-start_number" << QString::number(clipRange.start())
-             << "-i" << savedFilesMask;
+
+        if (isStreaming) {
+            args << "-f" << "rawvideo"
+                 << "-pix_fmt" << KisVideoFramesStreamingDialog::ffmpegPixelFormat(m_image, options.frameExportConfig)
+                 << "-s" << QString("%1x%2").arg(m_image->width()).arg(m_image->height())
+                 << "-r" << QString::number(options.frameRate)
+                 << "-i" << "-";
+        } else {
+            args << "-r" << QString::number(options.frameRate)
+                 << "-start_number" << QString::number(clipRange.start())
+                 << "-i" << savedFilesMask;
+        }
 
         QFileInfo audioFileInfo = animation->audioChannelFileName();
         if (options.includeAudio && audioFileInfo.exists()) {
@@ -312,15 +368,53 @@ KisImportExportErrorCode VideoSaver::encode(const QString &savedFilesMask, const
         args << additionalOptionsList
              << "-y" << resultFile;
 
-
-        resultOuter = runner->runFFMpeg(args, i18n("Encoding frames..."),
-                                     videoDir.filePath("log_encode.log"),
-                                     clipRange.duration());
+        if (isStreaming) {
+            resultOuter = streamFrames(runner.data(), args, videoDir.filePath("log_encode.log"), options, viewManager);
+        } else {
+            resultOuter = runner->runFFMpeg(args, i18n("Encoding frames..."),
+                                         videoDir.filePath("log_encode.log"),
+                                         clipRange.duration());
+        }
     }
 
     return resultOuter;
 }
 
+KisImportExportErrorCode VideoSaver::streamFrames(KisFFMpegRunner *runner,
+                                                 const QStringList &args,
+                                                 const QString &logPath,
+                                                 const KisAnimationRenderingOptions &options,
+                                                 KisViewManager *viewManager)
+{
+    const KisTimeRange range = KisTimeRange::fromTime(options.firstFrame, options.lastFrame);
+
+    runner->startFFMpeg(args, logPath, true);
+
+    if (!runner->process()->waitForStarted()) {
+        m_doc->setErrorMessage(i18n("Could not start ffmpeg at %1", options.ffmpegPath));
+        return ImportExportCodes::Failure;
+    }
+
+    /**
+     * The frames are passed to ffmpeg right after they are rendered,
+     * so there is no intermediate image sequence on disk
+     */
+    KisVideoFramesStreamingDialog renderer(m_image, range, runner->process(), options.frameExportConfig);
+    renderer.setBatchMode(m_batchMode);
+
+    const KisAsyncAnimationRenderDialogBase::Result result = renderer.regenerateRange(viewManager);
+
+    if (result != KisAsyncAnimationRenderDialogBase::RenderComplete) {
+        runner->cancel();
+        runner->process()->waitForFinished();
+
+        return result == KisAsyncAnimationRenderDialogBase::RenderCancelled ?
+            ImportExportCodes::Cancelled : ImportExportCodes::Failure;
+    }
+
+    return runner->waitForFinished(i18n("Encoding frames..."), range.duration());
+}
+
 KisImportExportErrorCode VideoSaver::convert(KisDocument *document, const QString &savedFilesMask, const KisAnimationRenderingOptions &options, bool batchMode)
 {
     VideoSaver videoSaver(document, batchMode);
@@ -32,6 +32,7 @@ class KisFFMpegRunner;
 /* The KisImageBuilder_Result definitions come from kis_png_converter.h here */
 
 class KisDocument;
+class KisViewManager;
 class KisAnimationRenderingOptions;
 
 class VideoSaver : public QObject {
@@ -62,8 +63,32 @@ public:
      */
     KisImportExportErrorCode encode(const QString &savedFilesMask, const KisAnimationRenderingOptions &options);
 
+    /**
+     * @brief encode the animation without saving an image sequence on disk.
+     * The frames are rendered and written into ffmpeg's standard input as
+     * raw video.
+     * @param options the configuration
+     * @param viewManager the view manager used for locking the image, may be null
+     * @return whether it is successful or had another failure.
+     */
+    KisImportExportErrorCode encodeStreaming(const KisAnimationRenderingOptions &options, KisViewManager *viewManager);
+
+    /**
+     * @return true if the video format of \p options can be encoded with
+     *         encodeStreaming()
+     */
+    static bool supportsStreaming(const KisAnimationRenderingOptions &options);
+
     static KisImportExportErrorCode convert(KisDocument *document, const QString &savedFilesMask, const KisAnimationRenderingOptions &options, bool batchMode);
 
+private:
+    KisImportExportErrorCode encodeImpl(const QString &savedFilesMask, const KisAnimationRenderingOptions &options, KisViewManager *viewManager);
+    KisImportExportErrorCode streamFrames(KisFFMpegRunner *runner,
+                                          const QStringList &args,
+                                          const QString &logPath,
+                                          const KisAnimationRenderingOptions &options,
+                                          KisViewManager *viewManager);
+
 private:
     KisImageSP m_image;
     KisDocument* m_doc;
@@ -26,6 +26,7 @@
 #include <ImfChannelList.h>
 #include <ImfInputFile.h>
 #include <ImfOutputFile.h>
+#include <ImfTiledOutputFile.h>
 
 #include <ImfStringAttribute.h>
 #include "exr_extra_tags.h"
@@ -34,6 +35,7 @@
 #include <QMessageBox>
 #include <QDomDocument>
 #include <QThread>
+#include <QtConcurrent>
 
 #include <QFileInfo>
 
@@ -50,6 +52,7 @@
 #include <kis_paint_device.h>
 #include <kis_paint_layer.h>
 #include <kis_transaction.h>
+#include <kis_image_config.h>
 #include "kis_iterator_ng.h"
 #include <kis_exr_layers_sorter.h>
 
@@ -66,6 +69,20 @@
 // Do not translate!
 #define HDR_LAYER "HDR Layer"
 
+/**
+ * The size of the tiles of the tiled EXR files we write. It matches
+ * the size of Krita's tiles, so every EXR tile maps onto a single tile
+ * of the layer.
+ */
+const int exrTileSize = 64;
+
+/**
+ * The amount of scanlines passed to OpenEXR at once when writing a
+ * scanline file. OpenEXR compresses the chunks of a single call in
+ * parallel, so it should not be too small.
+ */
+const int exrScanlineBandHeight = 64;
+
 template<typename _T_>
 struct Rgba {
     _T_ r;
@@ -150,7 +167,7 @@ struct EXRConverter::Private {
     QString errorMessage;
 
     template <class WrapperType>
-    void unmultiplyAlpha(typename WrapperType::pixel_type *pixel);
+    void unmultiplyAlpha(typename WrapperType::pixel_type *pixels, int numPixels);
 
     template<typename _T_>
     void decodeData4(Imf::InputFile& file, ExrPaintLayerInfo& info, KisPaintLayerSP layer, int width, int xstart, int ystart, int height, Imf::PixelType ptype);
@@ -173,9 +190,11 @@ EXRConverter::EXRConverter(KisDocument *doc, bool showNotifications)
     d->doc = doc;
     d->showNotifications = showNotifications;
 
-    // Set thread count for IlmImf library
-    Imf::setGlobalThreadCount(QThread::idealThreadCount());
-    dbgFile << "EXR Threadcount was set to: " << QThread::idealThreadCount();
+    // Set thread count for IlmImf library, it should use
+    // the same amount of threads as the image updater
+    const int numThreads = KisImageConfig(true).maxNumberOfThreads();
+    Imf::setGlobalThreadCount(numThreads);
+    dbgFile << "EXR Threadcount was set to: " << numThreads;
 }
 
 EXRConverter::~EXRConverter()
@@ -316,13 +335,18 @@ struct GrayPixelWrapper
     pixel_type &pixel;
 };
 
+/**
+ * Unmultiplies the color of the pixel. Returns true if the alpha of the
+ * pixel had to be changed to keep the colors consistent.
+ */
 template <class WrapperType>
-void EXRConverter::Private::unmultiplyAlpha(typename WrapperType::pixel_type *pixel)
+bool unmultiplyAlphaPixel(typename WrapperType::pixel_type *pixel)
 {
     typedef typename WrapperType::pixel_type pixel_type;
     typedef typename WrapperType::channel_type channel_type;
 
     WrapperType srcPixel(*pixel);
+    bool alphaWasModified = false;
 
     if (!srcPixel.checkMultipliedColorsConsistent()) {
 
@@ -352,6 +376,39 @@ void EXRConverter::Private::unmultiplyAlpha(typename WrapperType::pixel_type *pi
     } else if (srcPixel.alpha() > 0.0) {
         srcPixel.setUnmultiplied(srcPixel.pixel, srcPixel.alpha());
     }
+
+    return alphaWasModified;
+}
+
+template <class WrapperType>
+void EXRConverter::Private::unmultiplyAlpha(typename WrapperType::pixel_type *pixels, int numPixels)
+{
+    const int chunkSize = 4096;
+
+    QVector<int> chunks;
+    for (int i = 0; i < numPixels; i += chunkSize) {
+        chunks << i;
+    }
+
+    QAtomicInt modified(0);
+
+    QtConcurrent::blockingMap(chunks,
+        [pixels, numPixels, &modified] (int start) {
+            const int end = qMin(start + chunkSize, numPixels);
+            bool chunkModified = false;
+
+            for (int i = start; i < end; i++) {
+                chunkModified |= unmultiplyAlphaPixel<WrapperType>(pixels + i);
+            }
+
+            if (chunkModified) {
+                modified.storeRelease(1);
+            }
+        });
+
+    if (modified.loadAcquire()) {
+        alphaWasModified = true;
+    }
 }
 
 template <typename T, typename Pixel, int size, int alphaPos>
@@ -372,59 +429,80 @@ void multiplyAlpha(Pixel *pixel)
     }
 }
 
+/**
+ * The amount of rows decoded at once. OpenEXR decompresses the chunks
+ * of a single call in parallel, so the band spans several of Krita's
+ * tiles. For tiled files it is aligned to the tiles of the file, so
+ * every tile is decompressed only once.
+ */
+int decodingBandHeight(const Imf::Header &header)
+{
+    const int minBandHeight = 4 * exrTileSize;
+
+    if (!header.hasTileDescription()) {
+        return minBandHeight;
+    }
+
+    const int fileTileHeight = header.tileDescription().ySize;
+    return qMax(1, (minBandHeight + fileTileHeight - 1) / fileTileHeight) * fileTileHeight;
+}
+
 template<typename _T_>
 void EXRConverter::Private::decodeData4(Imf::InputFile& file, ExrPaintLayerInfo& info, KisPaintLayerSP layer, int width, int xstart, int ystart, int height, Imf::PixelType ptype)
 {
     typedef Rgba<_T_> Rgba;
 
-    QVector<Rgba> pixels(width * height);
-
-    bool hasAlpha = info.channelMap.contains("A");
-
-    Imf::FrameBuffer frameBuffer;
-    Rgba* frameBufferData = (pixels.data()) - xstart - ystart * width;
-    frameBuffer.insert(info.channelMap["R"].toLatin1().constData(),
-            Imf::Slice(ptype, (char *) &frameBufferData->r,
-                       sizeof(Rgba) * 1,
-                       sizeof(Rgba) * width));
-    frameBuffer.insert(info.channelMap["G"].toLatin1().constData(),
-            Imf::Slice(ptype, (char *) &frameBufferData->g,
-                       sizeof(Rgba) * 1,
-                       sizeof(Rgba) * width));
-    frameBuffer.insert(info.channelMap["B"].toLatin1().constData(),
-            Imf::Slice(ptype, (char *) &frameBufferData->b,
-                       sizeof(Rgba) * 1,
-                       sizeof(Rgba) * width));
-    if (hasAlpha) {
-        frameBuffer.insert(info.channelMap["A"].toLatin1().constData(),
-                Imf::Slice(ptype, (char *) &frameBufferData->a,
-                           sizeof(Rgba) * 1,
-                           sizeof(Rgba) * width));
-    }
+    /**
+     * Rgba has the same layout as Krita's RGBA pixels, so OpenEXR
+     * decodes the channels right into the pixels we write into the
+     * layer, without any per-pixel shuffling.
+     */
+    static_assert(sizeof(Rgba) == sizeof(typename KoRgbTraits<_T_>::Pixel),
+                  "Rgba must have the layout of Krita's pixels");
 
-    file.setFrameBuffer(frameBuffer);
-    file.readPixels(ystart, height + ystart - 1);
-    Rgba *rgba = pixels.data();
+    const bool hasAlpha = info.channelMap.contains("A");
+    const int bandHeight = decodingBandHeight(file.header());
 
-    QRect paintRegion(xstart, ystart, width, height);
-    KisSequentialIterator it(layer->paintDevice(), paintRegion);
-    while (it.nextPixel()) {
+    // if there is no alpha channel, the alpha value is never touched by OpenEXR
+    Rgba defaultPixel;
+    defaultPixel.r = defaultPixel.g = defaultPixel.b = _T_(0.0f);
+    defaultPixel.a = _T_(1.0f);
+
+    QVector<Rgba> pixels(width * bandHeight, defaultPixel);
+
+    for (int y = ystart; y < ystart + height; y += bandHeight) {
+        const int numRows = qMin(bandHeight, ystart + height - y);
+
+        Imf::FrameBuffer frameBuffer;
+        Rgba* frameBufferData = (pixels.data()) - xstart - y * width;
+        frameBuffer.insert(info.channelMap["R"].toLatin1().constData(),
+                Imf::Slice(ptype, (char *) &frameBufferData->r,
+                           sizeof(Rgba) * 1,
+                           sizeof(Rgba) * width));
+        frameBuffer.insert(info.channelMap["G"].toLatin1().constData(),
+                Imf::Slice(ptype, (char *) &frameBufferData->g,
+                           sizeof(Rgba) * 1,
+                           sizeof(Rgba) * width));
+        frameBuffer.insert(info.channelMap["B"].toLatin1().constData(),
+                Imf::Slice(ptype, (char *) &frameBufferData->b,
+                           sizeof(Rgba) * 1,
+                           sizeof(Rgba) * width));
         if (hasAlpha) {
-            unmultiplyAlpha<RgbPixelWrapper<_T_> >(rgba);
+            frameBuffer.insert(info.channelMap["A"].toLatin1().constData(),
+                    Imf::Slice(ptype, (char *) &frameBufferData->a,
+                               sizeof(Rgba) * 1,
+                               sizeof(Rgba) * width));
         }
 
-        typename KoRgbTraits<_T_>::Pixel* dst = reinterpret_cast<typename KoRgbTraits<_T_>::Pixel*>(it.rawData());
+        file.setFrameBuffer(frameBuffer);
+        file.readPixels(y, y + numRows - 1);
 
-        dst->red = rgba->r;
-        dst->green = rgba->g;
-        dst->blue = rgba->b;
         if (hasAlpha) {
-            dst->alpha = rgba->a;
-        } else {
-            dst->alpha = 1.0;
+            unmultiplyAlpha<RgbPixelWrapper<_T_> >(pixels.data(), width * numRows);
         }
 
-        ++rgba;
+        layer->paintDevice()->writeBytes(reinterpret_cast<const quint8*>(pixels.constData()),
+                                         QRect(xstart, y, width, numRows));
     }
 }
 
@@ -437,49 +515,48 @@ void EXRConverter::Private::decodeData1(Imf::InputFile& file, ExrPaintLayerInfo&
     KIS_ASSERT_RECOVER_RETURN(
                 layer->paintDevice()->colorSpace()->colorModelId() == GrayAColorModelID);
 
-    QVector<pixel_type> pixels(width * height);
-
     Q_ASSERT(info.channelMap.contains("G"));
     dbgFile << "G -> " << info.channelMap["G"];
 
-    bool hasAlpha = info.channelMap.contains("A");
+    const bool hasAlpha = info.channelMap.contains("A");
     dbgFile << "Has Alpha:" << hasAlpha;
 
+    const int bandHeight = decodingBandHeight(file.header());
 
-    Imf::FrameBuffer frameBuffer;
-    pixel_type* frameBufferData = (pixels.data()) - xstart - ystart * width;
-    frameBuffer.insert(info.channelMap["G"].toLatin1().constData(),
-            Imf::Slice(ptype, (char *) &frameBufferData->gray,
-                       sizeof(pixel_type) * 1,
-                       sizeof(pixel_type) * width));
-
-    if (hasAlpha) {
-        frameBuffer.insert(info.channelMap["A"].toLatin1().constData(),
-                Imf::Slice(ptype, (char *) &frameBufferData->alpha,
-                           sizeof(pixel_type) * 1,
-                           sizeof(pixel_type) * width));
-    }
+    // if there is no alpha channel, the alpha value is never touched by OpenEXR
+    pixel_type defaultPixel;
+    defaultPixel.gray = channel_type(0.0f);
+    defaultPixel.alpha = channel_type(1.0f);
 
-    file.setFrameBuffer(frameBuffer);
-    file.readPixels(ystart, height + ystart - 1);
+    QVector<pixel_type> pixels(width * bandHeight, defaultPixel);
 
-    pixel_type *srcPtr = pixels.data();
+    for (int y = ystart; y < ystart + height; y += bandHeight) {
+        const int numRows = qMin(bandHeight, ystart + height - y);
 
-    QRect paintRegion(xstart, ystart, width, height);
-    KisSequentialIterator it(layer->paintDevice(), paintRegion);
-    do {
+        Imf::FrameBuffer frameBuffer;
+        pixel_type* frameBufferData = (pixels.data()) - xstart - y * width;
+        frameBuffer.insert(info.channelMap["G"].toLatin1().constData(),
+                Imf::Slice(ptype, (char *) &frameBufferData->gray,
+                           sizeof(pixel_type) * 1,
+                           sizeof(pixel_type) * width));
 
         if (hasAlpha) {
-            unmultiplyAlpha<GrayPixelWrapper<_T_> >(srcPtr);
+            frameBuffer.insert(info.channelMap["A"].toLatin1().constData(),
+                    Imf::Slice(ptype, (char *) &frameBufferData->alpha,
+                               sizeof(pixel_type) * 1,
+                               sizeof(pixel_type) * width));
         }
 
-        pixel_type* dstPtr = reinterpret_cast<pixel_type*>(it.rawData());
+        file.setFrameBuffer(frameBuffer);
+        file.readPixels(y, y + numRows - 1);
 
-        dstPtr->gray = srcPtr->gray;
-        dstPtr->alpha = hasAlpha ? srcPtr->alpha : channel_type(1.0);
+        if (hasAlpha) {
+            unmultiplyAlpha<GrayPixelWrapper<_T_> >(pixels.data(), width * numRows);
+        }
 
-        ++srcPtr;
-    } while (it.nextPixel());
+        layer->paintDevice()->writeBytes(reinterpret_cast<const quint8*>(pixels.constData()),
+                                         QRect(xstart, y, width, numRows));
+    }
 }
 
 bool recCheckGroup(const ExrGroupLayerInfo& group, QStringList list, int idx1, int idx2)
@@ -953,7 +1030,7 @@ class Encoder
 public:
     virtual ~Encoder() {}
     virtual void prepareFrameBuffer(Imf::FrameBuffer*, int line) = 0;
-    virtual void encodeData(int line) = 0;
+    virtual void encodeData(int line, int numLines) = 0;
 
 };
 
@@ -961,13 +1038,12 @@ template<typename _T_, int size, int alphaPos>
 class EncoderImpl : public Encoder
 {
 public:
-    EncoderImpl(Imf::OutputFile* _file, const ExrPaintLayerSaveInfo* _info, int width) : file(_file), info(_info), pixels(width), m_width(width) {}
+    EncoderImpl(const ExrPaintLayerSaveInfo* _info, int width, int bandHeight) : info(_info), pixels(width * bandHeight), m_width(width) {}
     ~EncoderImpl() override {}
     void prepareFrameBuffer(Imf::FrameBuffer*, int line) override;
-    void encodeData(int line) override;
+    void encodeData(int line, int numLines) override;
 private:
     typedef ExrPixel_<_T_, size> ExrPixel;
-    Imf::OutputFile* file;
     const ExrPaintLayerSaveInfo* info;
     QVector<ExrPixel> pixels;
     int m_width;
@@ -988,56 +1064,57 @@ void EncoderImpl<_T_, size, alphaPos>::prepareFrameBuffer(Imf::FrameBuffer* fram
 }
 
 template<typename _T_, int size, int alphaPos>
-void EncoderImpl<_T_, size, alphaPos>::encodeData(int line)
+void EncoderImpl<_T_, size, alphaPos>::encodeData(int line, int numLines)
 {
-    ExrPixel *rgba = pixels.data();
-    KisHLineConstIteratorSP it = info->layerDevice->createHLineConstIteratorNG(0, line, m_width);
-    do {
-        const _T_* dst = reinterpret_cast < const _T_* >(it->oldRawData());
-
-        for (int i = 0; i < size; ++i) {
-            rgba->data[i] = dst[i];
-        }
-
-        if (alphaPos != -1) {
+    /**
+     * The channels of the saved device are stored in the same order
+     * as the EXR channels of the layer, so the pixels are just copied
+     * tile by tile and OpenEXR picks the channels from them.
+     */
+    info->layerDevice->readBytes(reinterpret_cast<quint8*>(pixels.data()),
+                                 QRect(0, line, m_width, numLines));
+
+    if (alphaPos != -1) {
+        ExrPixel *rgba = pixels.data();
+        ExrPixel *end = rgba + m_width * numLines;
+
+        for (; rgba < end; ++rgba) {
             multiplyAlpha<_T_, ExrPixel, size, alphaPos>(rgba);
         }
-
-        ++rgba;
-    } while (it->nextPixel());
+    }
 }
 
-Encoder* encoder(Imf::OutputFile& file, const ExrPaintLayerSaveInfo& info, int width)
+Encoder* encoder(const ExrPaintLayerSaveInfo& info, int width, int bandHeight)
 {
     dbgFile << "Create encoder for" << info.name << info.channels << info.layerDevice->colorSpace()->channelCount();
     switch (info.layerDevice->colorSpace()->channelCount()) {
     case 1: {
         if (info.layerDevice->colorSpace()->colorDepthId() == Float16BitsColorDepthID) {
             Q_ASSERT(info.pixelType == Imf::HALF);
-            return new EncoderImpl < half, 1, -1 > (&file, &info, width);
+            return new EncoderImpl < half, 1, -1 > (&info, width, bandHeight);
         } else if (info.layerDevice->colorSpace()->colorDepthId() == Float32BitsColorDepthID) {
             Q_ASSERT(info.pixelType == Imf::FLOAT);
-            return new EncoderImpl < float, 1, -1 > (&file, &info, width);
+            return new EncoderImpl < float, 1, -1 > (&info, width, bandHeight);
         }
         break;
     }
     case 2: {
         if (info.layerDevice->colorSpace()->colorDepthId() == Float16BitsColorDepthID) {
             Q_ASSERT(info.pixelType == Imf::HALF);
-            return new EncoderImpl<half, 2, 1>(&file, &info, width);
+            return new EncoderImpl<half, 2, 1>(&info, width, bandHeight);
         } else if (info.layerDevice->colorSpace()->colorDepthId() == Float32BitsColorDepthID) {
             Q_ASSERT(info.pixelType == Imf::FLOAT);
-            return new EncoderImpl<float, 2, 1>(&file, &info, width);
+            return new EncoderImpl<float, 2, 1>(&info, width, bandHeight);
         }
         break;
     }
     case 4: {
         if (info.layerDevice->colorSpace()->colorDepthId() == Float16BitsColorDepthID) {
             Q_ASSERT(info.pixelType == Imf::HALF);
-            return new EncoderImpl<half, 4, 3>(&file, &info, width);
+            return new EncoderImpl<half, 4, 3>(&info, width, bandHeight);
         } else if (info.layerDevice->colorSpace()->colorDepthId() == Float32BitsColorDepthID) {
             Q_ASSERT(info.pixelType == Imf::FLOAT);
-            return new EncoderImpl<float, 4, 3>(&file, &info, width);
+            return new EncoderImpl<float, 4, 3>(&info, width, bandHeight);
         }
         break;
     }
@@ -1047,27 +1124,58 @@ Encoder* encoder(Imf::OutputFile& file, const ExrPaintLayerSaveInfo& info, int w
     return 0;
 }
 
-void encodeData(Imf::OutputFile& file, const QList<ExrPaintLayerSaveInfo>& informationObjects, int width, int height)
+void writeBand(Imf::OutputFile& file, int /*line*/, int numLines)
+{
+    file.writePixels(numLines);
+}
+
+void writeBand(Imf::TiledOutputFile& file, int line, int /*numLines*/)
+{
+    const int tileRow = line / file.tileYSize();
+    file.writeTiles(0, file.numXTiles() - 1, tileRow, tileRow);
+}
+
+template <class File>
+void encodeData(File& file, const QList<ExrPaintLayerSaveInfo>& informationObjects, int width, int height, int bandHeight)
 {
     QList<Encoder*> encoders;
     Q_FOREACH (const ExrPaintLayerSaveInfo& info, informationObjects) {
-        encoders.push_back(encoder(file, info, width));
+        encoders.push_back(encoder(info, width, bandHeight));
     }
 
-    for (int y = 0; y < height; ++y) {
+    for (int y = 0; y < height; y += bandHeight) {
+        const int numLines = qMin(bandHeight, height - y);
+
         Imf::FrameBuffer frameBuffer;
         Q_FOREACH (Encoder* encoder, encoders) {
             encoder->prepareFrameBuffer(&frameBuffer, y);
         }
         file.setFrameBuffer(frameBuffer);
-        Q_FOREACH (Encoder* encoder, encoders) {
-            encoder->encodeData(y);
-        }
-        file.writePixels(1);
+
+        // the layers are independent, so they are fetched in parallel
+        QtConcurrent::blockingMap(encoders,
+            [y, numLines] (Encoder *encoder) {
+                encoder->encodeData(y, numLines);
+            });
+
+        writeBand(file, y, numLines);
     }
     qDeleteAll(encoders);
 }
 
+void writeFile(const QString &filename, Imf::Header &header, const QList<ExrPaintLayerSaveInfo>& informationObjects, int width, int height, bool tiled)
+{
+    if (tiled) {
+        header.setTileDescription(Imf::TileDescription(exrTileSize, exrTileSize, Imf::ONE_LEVEL));
+
+        Imf::TiledOutputFile file(QFile::encodeName(filename), header);
+        encodeData(file, informationObjects, width, height, exrTileSize);
+    } else {
+        Imf::OutputFile file(QFile::encodeName(filename), header);
+        encodeData(file, informationObjects, width, height, exrScanlineBandHeight);
+    }
+}
+
 KisPaintDeviceSP wrapLayerDevice(KisPaintDeviceSP device)
 {
     const KoColorSpace *cs = device->colorSpace();
@@ -1092,7 +1200,7 @@ KisPaintDeviceSP wrapLayerDevice(KisPaintDeviceSP device)
     return device;
 }
 
-KisImportExportErrorCode EXRConverter::buildFile(const QString &filename, KisPaintLayerSP layer)
+KisImportExportErrorCode EXRConverter::buildFile(const QString &filename, KisPaintLayerSP layer, bool tiled)
 {
     KIS_ASSERT_RECOVER_RETURN_VALUE(layer, ImportExportCodes::InternalError);
 
@@ -1128,11 +1236,9 @@ KisImportExportErrorCode EXRConverter::buildFile(const QString &filename, KisPai
 
     // Open file for writing
     try {
-        Imf::OutputFile file(QFile::encodeName(filename), header);
-
         QList<ExrPaintLayerSaveInfo> informationObjects;
         informationObjects.push_back(info);
-        encodeData(file, informationObjects, width, height);
+        writeFile(filename, header, informationObjects, width, height, tiled);
         return ImportExportCodes::OK;
 
     } catch(std::exception &e) {
@@ -1339,7 +1445,7 @@ QString EXRConverter::Private::fetchExtraLayersInfo(QList<ExrPaintLayerSaveInfo>
     return doc.toString();
 }
 
-KisImportExportErrorCode EXRConverter::buildFile(const QString &filename, KisGroupLayerSP layer, bool flatten)
+KisImportExportErrorCode EXRConverter::buildFile(const QString &filename, KisGroupLayerSP layer, bool flatten, bool tiled)
 {
     KIS_ASSERT_RECOVER_RETURN_VALUE(layer, ImportExportCodes::InternalError);
 
@@ -1353,7 +1459,7 @@ KisImportExportErrorCode EXRConverter::buildFile(const QString &filename, KisGro
     if (flatten) {
         KisPaintDeviceSP pd = new KisPaintDevice(*image->projection());
         KisPaintLayerSP l = new KisPaintLayer(image, "projection", OPACITY_OPAQUE_U8, pd);
-        return buildFile(filename, l);
+        return buildFile(filename, l, tiled);
     }
     else {
         QList<ExrPaintLayerSaveInfo> informationObjects;
@@ -1380,8 +1486,7 @@ KisImportExportErrorCode EXRConverter::buildFile(const QString &filename, KisGro
 
         // Open file for writing
         try {
-            Imf::OutputFile file(QFile::encodeName(filename), header);
-            encodeData(file, informationObjects, width, height);
+            writeFile(filename, header, informationObjects, width, height, tiled);
             return ImportExportCodes::OK;
         } catch(std::exception &e) {
             dbgFile << "Exception while writing to exr file: " << e.what();
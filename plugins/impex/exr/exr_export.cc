@@ -58,6 +58,7 @@ KisPropertiesConfigurationSP EXRExport::defaultConfiguration(const QByteArray &/
 {
     KisPropertiesConfigurationSP cfg = new KisPropertiesConfiguration();
     cfg->setProperty("flatten", false);
+    cfg->setProperty("tiled", false);
     return cfg;
 }
 
@@ -78,11 +79,13 @@ KisImportExportErrorCode EXRExport::convert(KisDocument *document, QIODevice */*
 
     KisImportExportErrorCode res;
 
+    const bool tiled = configuration && configuration->getBool("tiled", false);
+
     if (configuration && configuration->getBool("flatten")) {
-        res = exrConverter.buildFile(filename(), image->rootLayer(), true);
+        res = exrConverter.buildFile(filename(), image->rootLayer(), true, tiled);
     }
     else {
-        res = exrConverter.buildFile(filename(), image->rootLayer());
+        res = exrConverter.buildFile(filename(), image->rootLayer(), false, tiled);
     }
 
     dbgFile  << " Result =" << res;
@@ -114,12 +117,14 @@ void EXRExport::initializeCapabilities()
 void KisWdgOptionsExr::setConfiguration(const KisPropertiesConfigurationSP cfg)
 {
     chkFlatten->setChecked(cfg->getBool("flatten", false));
+    chkTiled->setChecked(cfg->getBool("tiled", false));
 }
 
 KisPropertiesConfigurationSP KisWdgOptionsExr::configuration() const
 {
     KisPropertiesConfigurationSP cfg = new KisPropertiesConfiguration();
     cfg->setProperty("flatten", chkFlatten->isChecked());
+    cfg->setProperty("tiled", chkTiled->isChecked());
     return cfg;
 }
 
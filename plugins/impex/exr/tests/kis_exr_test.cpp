@@ -25,6 +25,7 @@
 
 #include <half.h>
 #include <KisMimeDatabase.h>
+#include <kis_properties_configuration.h>
 #include "filestest.h"
 
 #ifndef FILES_DATA_DIR
@@ -104,6 +105,46 @@ void KisExrTest::testRoundTrip()
     delete doc1;
 
 }
+void KisExrTest::testRoundTripTiled()
+{
+    QString inputFileName(TestUtil::fetchDataFileLazy("CandleGlass.exr"));
+
+    QScopedPointer<KisDocument> doc1(KisPart::instance()->createDocument());
+
+    doc1->setFileBatchMode(true);
+    bool r = doc1->importDocument(QUrl::fromLocalFile(inputFileName));
+
+    QVERIFY(r);
+    QVERIFY(doc1->errorMessage().isEmpty());
+    QVERIFY(doc1->image());
+
+    QTemporaryFile savedFile(QDir::tempPath() + QLatin1String("/krita_XXXXXX") + QLatin1String(".exr"));
+    savedFile.setAutoRemove(true);
+    savedFile.open();
+
+    QString savedFileName(savedFile.fileName());
+
+    KisPropertiesConfigurationSP exportConfiguration = new KisPropertiesConfiguration();
+    exportConfiguration->setProperty("flatten", false);
+    exportConfiguration->setProperty("tiled", true);
+
+    r = doc1->exportDocumentSync(QUrl::fromLocalFile(savedFileName), ExrMimetype.toLatin1(), exportConfiguration);
+    QVERIFY(r);
+    QVERIFY(QFileInfo(savedFileName).exists());
+
+    QScopedPointer<KisDocument> doc2(KisPart::instance()->createDocument());
+    doc2->setFileBatchMode(true);
+    r = doc2->importDocument(QUrl::fromLocalFile(savedFileName));
+
+    QVERIFY(r);
+    QVERIFY(doc2->errorMessage().isEmpty());
+    QVERIFY(doc2->image());
+
+    QVERIFY(TestUtil::comparePaintDevicesClever<half>(
+                doc1->image()->root()->firstChild()->paintDevice(),
+                doc2->image()->root()->firstChild()->paintDevice(),
+                0.01 /* meaningless alpha */));
+}
 
 KISTEST_MAIN(KisExrTest)
 
@@ -53,6 +53,7 @@ extern "C" {
 #include <KisDocument.h>
 #include <kis_image.h>
 #include <kis_paint_layer.h>
+#include <KisBandedDeviceReader.h>
 #include <kis_transaction.h>
 #include <kis_group_layer.h>
 #include <kis_meta_data_entry.h>
@@ -457,26 +458,23 @@ KisImageSP KisJPEGConverter::image()
 }
 
 
-KisImportExportErrorCode KisJPEGConverter::buildFile(QIODevice *io, KisPaintLayerSP layer, KisJPEGOptions options, KisMetaData::Store* metaData)
+KisImportExportErrorCode KisJPEGConverter::buildFile(QIODevice *io, KisImageSP image, KisPaintDeviceSP device, KisJPEGOptions options, KisMetaData::Store* metaData)
 {
-    KIS_ASSERT_RECOVER_RETURN_VALUE(layer, ImportExportCodes::InternalError);
+    KIS_ASSERT_RECOVER_RETURN_VALUE(image, ImportExportCodes::InternalError);
+    KIS_ASSERT_RECOVER_RETURN_VALUE(device, ImportExportCodes::InternalError);
 
-    KisImageSP image = KisImageSP(layer->image());
-    KIS_ASSERT_RECOVER_RETURN_VALUE(layer, ImportExportCodes::InternalError);
-
-    const KoColorSpace * cs = layer->colorSpace();
+    // cs is the color space the pixels are converted into while
+    // streaming them from the device
+    const KoColorSpace * cs = device->colorSpace();
     J_COLOR_SPACE color_type = getColorTypeforColorSpace(cs);
 
     if (color_type == JCS_UNKNOWN) {
-        layer->paintDevice()->convertTo(KoColorSpaceRegistry::instance()->rgb8(), KoColorConversionTransformation::internalRenderingIntent(), KoColorConversionTransformation::internalConversionFlags());
         cs = KoColorSpaceRegistry::instance()->rgb8();
         color_type = JCS_RGB;
     }
 
     if (options.forceSRGB) {
-        const KoColorSpace* dst = KoColorSpaceRegistry::instance()->colorSpace(RGBAColorModelID.id(), layer->colorSpace()->colorDepthId().id(), "sRGB built-in - (lcms internal)");
-        layer->paintDevice()->convertTo(dst);
-        cs = dst;
+        cs = KoColorSpaceRegistry::instance()->colorSpace(RGBAColorModelID.id(), cs->colorDepthId().id(), "sRGB built-in - (lcms internal)");
         color_type = JCS_RGB;
     }
 
@@ -619,16 +617,8 @@ KisImportExportErrorCode KisJPEGConverter::buildFile(QIODevice *io, KisPaintLaye
     }
 
 
-    KisPaintDeviceSP dev = new KisPaintDevice(layer->colorSpace());
-    KoColor c(options.transparencyFillColor, layer->colorSpace());
-    dev->fill(QRect(0, 0, width, height), c);
-    KisPainter gc(dev);
-    gc.bitBlt(QPoint(0, 0), layer->paintDevice(), QRect(0, 0, width, height));
-    gc.end();
-
-
     if (options.saveProfile) {
-        const KoColorProfile* colorProfile = layer->colorSpace()->profile();
+        const KoColorProfile* colorProfile = cs->profile();
         QByteArray colorProfileData = colorProfile->rawData();
         write_icc_profile(& cinfo, (uchar*) colorProfileData.data(), colorProfileData.size());
     }
@@ -636,76 +626,70 @@ KisImportExportErrorCode KisJPEGConverter::buildFile(QIODevice *io, KisPaintLaye
     // Write data information
 
     JSAMPROW row_pointer = new JSAMPLE[width*cinfo.input_components];
-    int color_nb_bits = 8 * layer->paintDevice()->pixelSize() / layer->paintDevice()->channelCount();
-
-    for (; cinfo.next_scanline < height;) {
-        KisHLineConstIteratorSP it = dev->createHLineConstIteratorNG(0, cinfo.next_scanline, width);
-        quint8 *dst = row_pointer;
-        switch (color_type) {
-        case JCS_GRAYSCALE:
-            if (color_nb_bits == 16) {
-                do {
-                    //const quint16 *d = reinterpret_cast<const quint16 *>(it->oldRawData());
-                    const quint8 *d = it->oldRawData();
-                    *(dst++) = cs->scaleToU8(d, 0);//d[0] / quint8_MAX;
-
-                } while (it->nextPixel());
-            } else {
-                do {
-                    const quint8 *d = it->oldRawData();
-                    *(dst++) = d[0];
+    int color_nb_bits = 8 * cs->pixelSize() / cs->channelCount();
+    const int pixelSize = cs->pixelSize();
 
-                } while (it->nextPixel());
-            }
-            break;
-        case JCS_RGB:
-            if (color_nb_bits == 16) {
-                do {
-                    //const quint16 *d = reinterpret_cast<const quint16 *>(it->oldRawData());
-                    const quint8 *d = it->oldRawData();
-                    *(dst++) = cs->scaleToU8(d, 2); //d[2] / quint8_MAX;
-                    *(dst++) = cs->scaleToU8(d, 1); //d[1] / quint8_MAX;
-                    *(dst++) = cs->scaleToU8(d, 0); //d[0] / quint8_MAX;
+    // the transparent pixels are composited over the fill color while
+    // streaming, JPEG has no alpha channel
+    KisBandedDeviceReader reader(device, QRect(0, 0, width, height), cs);
+    reader.setFillColor(KoColor(options.transparencyFillColor, device->colorSpace()));
 
-                } while (it->nextPixel());
-            } else {
-                do {
-                    const quint8 *d = it->oldRawData();
-                    *(dst++) = d[2];
-                    *(dst++) = d[1];
-                    *(dst++) = d[0];
-
-                } while (it->nextPixel());
-            }
-            break;
-        case JCS_CMYK:
-            if (color_nb_bits == 16) {
-                do {
-                    //const quint16 *d = reinterpret_cast<const quint16 *>(it->oldRawData());
-                    const quint8 *d = it->oldRawData();
-                    *(dst++) = quint8_MAX - cs->scaleToU8(d, 0);//quint8_MAX - d[0] / quint8_MAX;
-                    *(dst++) = quint8_MAX - cs->scaleToU8(d, 1);//quint8_MAX - d[1] / quint8_MAX;
-                    *(dst++) = quint8_MAX - cs->scaleToU8(d, 2);//quint8_MAX - d[2] / quint8_MAX;
-                    *(dst++) = quint8_MAX - cs->scaleToU8(d, 3);//quint8_MAX - d[3] / quint8_MAX;
-
-                } while (it->nextPixel());
-            } else {
-                do {
-                    const quint8 *d = it->oldRawData();
-                    *(dst++) = quint8_MAX - d[0];
-                    *(dst++) = quint8_MAX - d[1];
-                    *(dst++) = quint8_MAX - d[2];
-                    *(dst++) = quint8_MAX - d[3];
+    while (reader.nextBand()) {
+        for (int y = reader.bandTop(); y <= reader.bandBottom(); y++) {
+            const quint8 *d = reader.row(y);
+            quint8 *dst = row_pointer;
 
-                } while (it->nextPixel());
+            switch (color_type) {
+            case JCS_GRAYSCALE:
+                if (color_nb_bits == 16) {
+                    for (uint x = 0; x < width; x++, d += pixelSize) {
+                        *(dst++) = cs->scaleToU8(d, 0);//d[0] / quint8_MAX;
+                    }
+                } else {
+                    for (uint x = 0; x < width; x++, d += pixelSize) {
+                        *(dst++) = d[0];
+                    }
+                }
+                break;
+            case JCS_RGB:
+                if (color_nb_bits == 16) {
+                    for (uint x = 0; x < width; x++, d += pixelSize) {
+                        *(dst++) = cs->scaleToU8(d, 2); //d[2] / quint8_MAX;
+                        *(dst++) = cs->scaleToU8(d, 1); //d[1] / quint8_MAX;
+                        *(dst++) = cs->scaleToU8(d, 0); //d[0] / quint8_MAX;
+                    }
+                } else {
+                    for (uint x = 0; x < width; x++, d += pixelSize) {
+                        *(dst++) = d[2];
+                        *(dst++) = d[1];
+                        *(dst++) = d[0];
+                    }
+                }
+                break;
+            case JCS_CMYK:
+                if (color_nb_bits == 16) {
+                    for (uint x = 0; x < width; x++, d += pixelSize) {
+                        *(dst++) = quint8_MAX - cs->scaleToU8(d, 0);//quint8_MAX - d[0] / quint8_MAX;
+                        *(dst++) = quint8_MAX - cs->scaleToU8(d, 1);//quint8_MAX - d[1] / quint8_MAX;
+                        *(dst++) = quint8_MAX - cs->scaleToU8(d, 2);//quint8_MAX - d[2] / quint8_MAX;
+                        *(dst++) = quint8_MAX - cs->scaleToU8(d, 3);//quint8_MAX - d[3] / quint8_MAX;
+                    }
+                } else {
+                    for (uint x = 0; x < width; x++, d += pixelSize) {
+                        *(dst++) = quint8_MAX - d[0];
+                        *(dst++) = quint8_MAX - d[1];
+                        *(dst++) = quint8_MAX - d[2];
+                        *(dst++) = quint8_MAX - d[3];
+                    }
+                }
+                break;
+            default:
+                delete [] row_pointer;
+                jpeg_destroy_compress(&cinfo);
+                return ImportExportCodes::FormatFeaturesUnsupported;
             }
-            break;
-        default:
-            delete [] row_pointer;
-            jpeg_destroy_compress(&cinfo);
-            return ImportExportCodes::FormatFeaturesUnsupported;
+            jpeg_write_scanlines(&cinfo, &row_pointer, 1);
         }
-        jpeg_write_scanlines(&cinfo, &row_pointer, 1);
     }
 
 
@@ -70,7 +70,11 @@ public:
     ~KisJPEGConverter() override;
 public:
     KisImportExportErrorCode buildImage(QIODevice *io);
-    KisImportExportErrorCode buildFile(QIODevice *io, KisPaintLayerSP layer, KisJPEGOptions options, KisMetaData::Store* metaData);
+    /**
+     * Save \p device (usually, the projection of \p image) into \p io. The pixels
+     * are streamed from the device in bands, the device itself is not changed.
+     */
+    KisImportExportErrorCode buildFile(QIODevice *io, KisImageSP image, KisPaintDeviceSP device, KisJPEGOptions options, KisMetaData::Store* metaData);
     /** Retrieve the constructed image
     */
     KisImageSP image();
@@ -99,10 +99,7 @@ KisImportExportErrorCode KisJPEGExport::convert(KisDocument *document, QIODevice
     options.storeAuthor = configuration->getBool("storeAuthor", false);
     options.storeDocumentMetaData = configuration->getBool("storeMetaData", false);
 
-    KisPaintDeviceSP pd = new KisPaintDevice(*image->projection());
-
     KisJPEGConverter kpc(document, batchMode());
-    KisPaintLayerSP l = new KisPaintLayer(image, "projection", OPACITY_OPAQUE_U8, pd);
 
     KisExifInfoVisitor exivInfoVisitor;
     exivInfoVisitor.visit(image->rootLayer().data());
@@ -168,7 +165,7 @@ KisImportExportErrorCode KisJPEGExport::convert(KisDocument *document, QIODevice
         }
     }
 
-    KisImportExportErrorCode res = kpc.buildFile(io, l, options, metaDataStore.data());
+    KisImportExportErrorCode res = kpc.buildFile(io, image, image->projection(), options, metaDataStore.data());
     return res;
 }
 
@@ -37,6 +37,7 @@
 #include <kis_paint_layer.h>
 #include <kis_png_converter.h>
 #include <KisDocument.h>
+#include <kis_config.h>
 
 static const char CURRENT_DTD_VERSION[] = "2.0";
 
@@ -115,6 +116,14 @@ KisImportExportErrorCode KraConverter::buildFile(QIODevice *io, const QString &f
         return ImportExportCodes::CannotCreateFile;
     }
 
+    /**
+     * The pixel data is always saved as stored entries (see
+     * KisKraSaveVisitor::savePaintDevice()), so the option
+     * affects only the XML and metadata entries
+     */
+    if (KisConfig(true).compressKra()) {
+        m_store->setCompressionEnabled(true);
+    }
 
     m_kraSaver = new KisKraSaver(m_doc, filename);
 
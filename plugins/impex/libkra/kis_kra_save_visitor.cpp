@@ -90,6 +90,22 @@ void KisKraSaveVisitor::setExternalUri(const QString &uri)
     m_uri = uri;
 }
 
+void KisKraSaveVisitor::setPreviousSave(KoStore *previousStore, const KisKraSavedEntries &previousEntries)
+{
+    m_previousStore = previousStore;
+    m_previousEntries = previousEntries;
+}
+
+KisKraSavedEntries KisKraSaveVisitor::savedEntries() const
+{
+    return m_savedEntries;
+}
+
+int KisKraSaveVisitor::numCopiedPaintDevices() const
+{
+    return m_numCopiedPaintDevices;
+}
+
 bool KisKraSaveVisitor::visit(KisExternalLayer * layer)
 {
     bool result = false;
@@ -346,8 +362,13 @@ bool KisKraSaveVisitor::savePaintDevice(KisPaintDeviceSP device,
                                         QString location)
 {
     // Layer data
-    KisConfig cfg(true);
-    m_store->setCompressionEnabled(cfg.compressKra());
+
+    /**
+     * The tiles are already compressed with LZF, so deflating them
+     * once again takes a lot of time and saves almost nothing. They
+     * are always stored as is.
+     */
+    m_store->setEntryCompression(KoStore::StoredEntry);
 
     KisPaintDeviceFramesInterface *frameInterface = device->framesInterface();
     QList<int> frames;
@@ -357,7 +378,13 @@ bool KisKraSaveVisitor::savePaintDevice(KisPaintDeviceSP device,
     }
 
     if (!frameInterface || frames.count() <= 1) {
-        savePaintDeviceFrame(device, location, SimpleDevicePolicy());
+        if (!copyUnchangedPaintDevice(device, location)) {
+            KisKraSavedEntry entry;
+
+            if (savePaintDeviceFrame(device, location, SimpleDevicePolicy(), &entry)) {
+                m_savedEntries.insert(device->contentVersion(), entry);
+            }
+        }
     } else {
         KisRasterKeyframeChannel *keyframeChannel = device->keyframeChannel();
 
@@ -373,13 +400,13 @@ bool KisKraSaveVisitor::savePaintDevice(KisPaintDeviceSP device,
         }
     }
 
-    m_store->setCompressionEnabled(true);
+    m_store->setEntryCompression(KoStore::DeflatedEntry);
     return true;
 }
 
 
 template<class DevicePolicy>
-bool KisKraSaveVisitor::savePaintDeviceFrame(KisPaintDeviceSP device, QString location, DevicePolicy policy)
+bool KisKraSaveVisitor::savePaintDeviceFrame(KisPaintDeviceSP device, QString location, DevicePolicy policy, KisKraSavedEntry *savedEntry)
 {
     if (m_store->open(location)) {
         if (!policy.write(device, *m_writer)) {
@@ -388,7 +415,14 @@ bool KisKraSaveVisitor::savePaintDeviceFrame(KisPaintDeviceSP device, QString lo
             return false;
         }
 
+        const qint64 dataSize = m_store->size();
         m_store->close();
+
+        if (savedEntry) {
+            savedEntry->location = location;
+            savedEntry->size = dataSize;
+            savedEntry->crc = m_store->lastWrittenCrc();
+        }
     }
     if (m_store->open(location + ".defaultpixel")) {
         m_store->write((char*)policy.defaultPixel(device).data(), device->colorSpace()->pixelSize());
@@ -398,6 +432,34 @@ bool KisKraSaveVisitor::savePaintDeviceFrame(KisPaintDeviceSP device, QString lo
     return true;
 }
 
+bool KisKraSaveVisitor::copyUnchangedPaintDevice(KisPaintDeviceSP device, QString location)
+{
+    if (!m_previousStore) return false;
+
+    auto it = m_previousEntries.constFind(device->contentVersion());
+    if (it == m_previousEntries.constEnd()) return false;
+
+    // the entries without a checksum cannot be verified
+    if (it->crc < 0) return false;
+
+    if (!m_store->copyRawEntry(m_previousStore, it->location, location, it->size, it->crc)) {
+        return false;
+    }
+
+    if (m_store->open(location + ".defaultpixel")) {
+        m_store->write((char*)device->defaultPixel().data(), device->colorSpace()->pixelSize());
+        m_store->close();
+    }
+
+    KisKraSavedEntry entry = *it;
+    entry.location = location;
+    m_savedEntries.insert(device->contentVersion(), entry);
+
+    m_numCopiedPaintDevices++;
+
+    return true;
+}
+
 bool KisKraSaveVisitor::saveAnnotations(KisLayer* layer)
 {
     if (!layer) return false;
@@ -31,6 +31,21 @@
 class KisPaintDeviceWriter;
 class KoStore;
 
+/**
+ * An entry of the paint device data written into a .kra archive
+ */
+struct KisKraSavedEntry {
+    QString location;
+    qint64 size = 0;
+    qint64 crc = -1; ///< CRC-32 of the entry data, -1 if unknown
+};
+
+/**
+ * Maps KisPaintDevice::contentVersion() of the saved devices to
+ * the entries they were written into
+ */
+typedef QHash<qint64, KisKraSavedEntry> KisKraSavedEntries;
+
 class KRITALIBKRA_EXPORT KisKraSaveVisitor : public KisNodeVisitor
 {
 public:
@@ -41,6 +56,20 @@ public:
 public:
     void setExternalUri(const QString &uri);
 
+    /**
+     * Enables incremental saving. The paint devices that haven't
+     * changed since the previous save are copied from \p previousStore
+     * as is, without encoding them again. \p previousEntries is the
+     * result of savedEntries() of the previous save.
+     */
+    void setPreviousSave(KoStore *previousStore, const KisKraSavedEntries &previousEntries);
+
+    /// @return the entries of the paint devices written by this visitor
+    KisKraSavedEntries savedEntries() const;
+
+    /// @return the number of paint devices copied from the previous save
+    int numCopiedPaintDevices() const;
+
     bool visit(KisNode*) override {
         return true;
     }
@@ -75,7 +104,9 @@ private:
     bool savePaintDevice(KisPaintDeviceSP device, QString location);
 
     template<class DevicePolicy>
-    bool savePaintDeviceFrame(KisPaintDeviceSP device, QString location, DevicePolicy policy);
+    bool savePaintDeviceFrame(KisPaintDeviceSP device, QString location, DevicePolicy policy, KisKraSavedEntry *savedEntry = 0);
+
+    bool copyUnchangedPaintDevice(KisPaintDeviceSP device, QString location);
 
     bool saveAnnotations(KisLayer* layer);
     bool saveSelection(KisNode* node);
@@ -93,6 +124,11 @@ private:
     QMap<const KisNode*, QString> m_nodeFileNames;
     KisPaintDeviceWriter *m_writer;
     QStringList m_errorMessages;
+
+    KoStore *m_previousStore = 0;
+    KisKraSavedEntries m_previousEntries;
+    KisKraSavedEntries m_savedEntries;
+    int m_numCopiedPaintDevices = 0;
 };
 
 #endif // KIS_KRA_SAVE_VISITOR_H_
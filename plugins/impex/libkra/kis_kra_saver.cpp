@@ -65,10 +65,60 @@
 
 #include <QFileInfo>
 #include <QDir>
+#include <QDateTime>
+#include <QMutex>
+#include <QMutexLocker>
+
+#include "kis_config.h"
 
 
 using namespace KRA;
 
+namespace {
+
+/**
+ * Remembers where the paint devices were written during the last
+ * save of every file, so that the next save of the same file could
+ * copy the unchanged devices from it.
+ */
+struct KisKraSaveHistory
+{
+    struct Record {
+        QDateTime saveTime;
+        KisKraSavedEntries entries;
+        int numCopiedPaintDevices = 0;
+    };
+
+    bool takeRecord(const QString &fileName, Record *record) {
+        QMutexLocker l(&mutex);
+
+        auto it = records.find(fileName);
+        if (it == records.end()) return false;
+
+        *record = *it;
+        records.erase(it);
+        return true;
+    }
+
+    void setRecord(const QString &fileName, const Record &record) {
+        QMutexLocker l(&mutex);
+        records[fileName] = record;
+    }
+
+    int numCopiedPaintDevices(const QString &fileName) {
+        QMutexLocker l(&mutex);
+        return records.value(fileName).numCopiedPaintDevices;
+    }
+
+private:
+    QMutex mutex;
+    QHash<QString, Record> records;
+};
+
+Q_GLOBAL_STATIC(KisKraSaveHistory, s_saveHistory)
+
+}
+
 struct KisKraSaver::Private
 {
 public:
@@ -247,13 +297,57 @@ bool KisKraSaver::saveBinaryData(KoStore* store, KisImageSP image, const QString
     if (external)
         visitor.setExternalUri(uri);
 
+    /**
+     * If the file has been saved in this session already and has not
+     * been modified since then, the unchanged layers are copied from
+     * it without encoding them again.
+     *
+     * The record is taken out of the history, so a failed save never
+     * leaves a record that doesn't match the file on disk.
+     */
+    const QString filePath = QFileInfo(m_d->filename).absoluteFilePath();
+    const QDateTime saveTime = QDateTime::currentDateTime();
+
+    QScopedPointer<KoStore> previousStore;
+    KisKraSaveHistory::Record previousSave;
+
+    KisConfig cfg(true);
+    if (!m_d->filename.isEmpty() &&
+        s_saveHistory->takeRecord(filePath, &previousSave) &&
+        cfg.incrementalKraSave()) {
+
+        const QFileInfo fileInfo(filePath);
+
+        // leave some room for the coarse timestamps of some file systems
+        if (fileInfo.exists() &&
+            fileInfo.lastModified() >= previousSave.saveTime.addSecs(-2)) {
+
+            previousStore.reset(KoStore::createStore(filePath, KoStore::Read, "", KoStore::Zip));
+
+            if (!previousStore->bad()) {
+                visitor.setPreviousSave(previousStore.data(), previousSave.entries);
+            }
+        }
+    }
+
     image->rootLayer()->accept(visitor);
 
+    // the old file should be closed before the new one replaces it
+    previousStore.reset();
+
     m_d->errorMessages.append(visitor.errorMessages());
     if (!m_d->errorMessages.isEmpty()) {
         return false;
     }
 
+    if (!m_d->filename.isEmpty()) {
+        KisKraSaveHistory::Record record;
+        record.saveTime = saveTime;
+        record.entries = visitor.savedEntries();
+        record.numCopiedPaintDevices = visitor.numCopiedPaintDevices();
+        s_saveHistory->setRecord(filePath, record);
+    }
+
     // saving annotations
     // XXX this only saves EXIF and ICC info. This would probably need
     // a redesign of the dtd of the krita file to do this more generally correct
@@ -345,6 +439,11 @@ QStringList KisKraSaver::errorMessages() const
     return m_d->errorMessages;
 }
 
+int KisKraSaver::testingNumCopiedPaintDevices(const QString &filename)
+{
+    return s_saveHistory->numCopiedPaintDevices(QFileInfo(filename).absoluteFilePath());
+}
+
 void KisKraSaver::saveBackgroundColor(QDomDocument& doc, QDomElement& element, KisImageSP image)
 {
     QDomElement e = doc.createElement(CANVASPROJECTIONCOLOR);
@@ -49,6 +49,13 @@ public:
     /// @return a list with everything that went wrong while saving
     QStringList errorMessages() const;
 
+    /**
+     * @return the number of paint devices that were copied from the
+     *         previous archive during the last save of \p filename
+     *         (used in unit tests only)
+     */
+    static int testingNumCopiedPaintDevices(const QString &filename);
+
 private:
     void saveBackgroundColor(QDomDocument& doc, QDomElement& element, KisImageSP image);
     void saveAssistantsGlobalColor(QDomDocument& doc, QDomElement& element);
@@ -48,6 +48,7 @@
 #include "kis_keyframe_channel.h"
 #include "kis_image_animation_interface.h"
 #include "kis_layer_properties_icons.h"
+#include "kis_kra_saver.h"
 
 #include "kis_transform_mask_params_interface.h"
 
@@ -549,4 +550,93 @@ void KisKraSaverTest::testExportToReadonly()
     TestUtil::testExportToReadonly(QString(FILES_DATA_DIR), KraMimetype);
 }
 
+void KisKraSaverTest::testIncrementalSave()
+{
+    QScopedPointer<KisDocument> doc(KisPart::instance()->createDocument());
+
+    // mask parent should be destructed before the document!
+    QRect refRect(0,0,512,512);
+    TestUtil::MaskParent p(refRect);
+
+    doc->setCurrentImage(p.image);
+    doc->documentInfo()->setAboutInfo("title", p.image->objectName());
+
+    KisPaintLayerSP layer2 = new KisPaintLayer(p.image, "layer2", OPACITY_OPAQUE_U8);
+    p.image->addNode(layer2, p.image->root());
+
+    KisPaintDeviceSP dev1 = p.layer->paintDevice();
+    KisPaintDeviceSP dev2 = layer2->paintDevice();
+
+    dev1->fill(QRect(0,0,200,200), KoColor(Qt::red, dev1->colorSpace()));
+    dev2->fill(QRect(100,100,200,200), KoColor(Qt::green, dev2->colorSpace()));
+
+    const QString fileName("incremental_save_test.kra");
+    QFile::remove(fileName);
+
+    QVERIFY(doc->exportDocumentSync(QUrl::fromLocalFile(fileName), doc->mimeType()));
+    QCOMPARE(KisKraSaver::testingNumCopiedPaintDevices(fileName), 0);
+
+    // only the second layer is changed, the first one is copied from the previous save
+    dev2->fill(QRect(250,250,100,100), KoColor(Qt::blue, dev2->colorSpace()));
+    QVERIFY(doc->exportDocumentSync(QUrl::fromLocalFile(fileName), doc->mimeType()));
+    QCOMPARE(KisKraSaver::testingNumCopiedPaintDevices(fileName), 1);
+
+    {
+        QScopedPointer<KisDocument> doc2(KisPart::instance()->createDocument());
+        QVERIFY(doc2->loadNativeFormat(fileName));
+
+        KisNodeSP loadedLayer1 = TestUtil::findNode(doc2->image()->root(), p.layer->name());
+        KisNodeSP loadedLayer2 = TestUtil::findNode(doc2->image()->root(), "layer2");
+        QVERIFY(loadedLayer1);
+        QVERIFY(loadedLayer2);
+
+        QPoint errorPoint;
+        QVERIFY(TestUtil::comparePaintDevices(errorPoint, dev1, loadedLayer1->paintDevice()));
+        QVERIFY(TestUtil::comparePaintDevices(errorPoint, dev2, loadedLayer2->paintDevice()));
+    }
+
+    /**
+     * Replace the archive on disk with a file where both layers have
+     * different content. The recorded entries don't match the file
+     * anymore, so the layers should be encoded again instead of being
+     * copied.
+     */
+    const QString otherFileName("incremental_save_test_other.kra");
+    QFile::remove(otherFileName);
+
+    {
+        QScopedPointer<KisDocument> doc3(KisPart::instance()->createDocument());
+        QVERIFY(doc3->loadNativeFormat(fileName));
+
+        KisNodeSP layer1 = TestUtil::findNode(doc3->image()->root(), p.layer->name());
+        KisNodeSP layer2 = TestUtil::findNode(doc3->image()->root(), "layer2");
+        QVERIFY(layer1);
+        QVERIFY(layer2);
+
+        layer1->paintDevice()->fill(QRect(0,0,100,100), KoColor(Qt::yellow, layer1->colorSpace()));
+        layer2->paintDevice()->fill(QRect(300,300,100,100), KoColor(Qt::yellow, layer2->colorSpace()));
+        QVERIFY(doc3->exportDocumentSync(QUrl::fromLocalFile(otherFileName), doc3->mimeType()));
+    }
+
+    QVERIFY(QFile::remove(fileName));
+    QVERIFY(QFile::copy(otherFileName, fileName));
+
+    QVERIFY(doc->exportDocumentSync(QUrl::fromLocalFile(fileName), doc->mimeType()));
+    QCOMPARE(KisKraSaver::testingNumCopiedPaintDevices(fileName), 0);
+
+    {
+        QScopedPointer<KisDocument> doc4(KisPart::instance()->createDocument());
+        QVERIFY(doc4->loadNativeFormat(fileName));
+
+        KisNodeSP loadedLayer1 = TestUtil::findNode(doc4->image()->root(), p.layer->name());
+        KisNodeSP loadedLayer2 = TestUtil::findNode(doc4->image()->root(), "layer2");
+        QVERIFY(loadedLayer1);
+        QVERIFY(loadedLayer2);
+
+        QPoint errorPoint;
+        QVERIFY(TestUtil::comparePaintDevices(errorPoint, dev1, loadedLayer1->paintDevice()));
+        QVERIFY(TestUtil::comparePaintDevices(errorPoint, dev2, loadedLayer2->paintDevice()));
+    }
+}
+
 KISTEST_MAIN(KisKraSaverTest)
@@ -21,6 +21,11 @@
 #include <QtGlobal>
 #include <QMap>
 #include <QIODevice>
+#include <QQueue>
+#include <QFuture>
+#include <QtConcurrent>
+
+#include <numeric>
 
 
 #include <KoColorSpace.h>
@@ -38,6 +43,7 @@
 #include "psd_layer_record.h"
 #include <asl/kis_offset_keeper.h>
 #include "kis_iterator_ng.h"
+#include "kis_image_config.h"
 
 #include "config_psd.h"
 #ifdef HAVE_ZLIB
@@ -126,52 +132,69 @@ inline float convertByteOrder<KoLabF32Traits>(float value) {
     return qFromBigEndian((quint32)value);
 }
 
-template <class Traits>
-void readAlphaMaskPixel(const QMap<quint16, QByteArray> &channelBytes,
-                        int col, quint8 *dstPtr);
+/**
+ * Pointers to the beginning of the decoded rows of every channel,
+ * the key is the channel id
+ */
+typedef QMap<quint16, const quint8*> ChannelRows;
 
-template <>
-void readAlphaMaskPixel<AlphaU8Traits>(const QMap<quint16, QByteArray> &channelBytes,
-                                       int col, quint8 *dstPtr)
+template <class Traits>
+class ChannelReader
 {
-    *dstPtr = reinterpret_cast<const quint8*>(channelBytes.first().constData())[col];
-}
+    typedef typename Traits::channels_type channels_type;
+
+public:
+    ChannelReader(const ChannelRows &rows, quint16 channelId, int col)
+        : m_ptr(reinterpret_cast<const channels_type*>(rows.value(channelId, 0)))
+    {
+        if (m_ptr) {
+            m_ptr += col;
+        }
+    }
+
+    inline channels_type next(channels_type defaultValue) {
+        return m_ptr ? convertByteOrder<Traits>(*m_ptr++) : defaultValue;
+    }
+
+private:
+    const channels_type *m_ptr;
+};
+
+template <class Traits>
+void readAlphaMaskPixels(const ChannelRows &rows,
+                         int col, int numPixels, quint8 *dstPtr);
 
 template <>
-void readAlphaMaskPixel<AlphaU16Traits>(const QMap<quint16, QByteArray> &channelBytes,
-                                       int col, quint8 *dstPtr)
+void readAlphaMaskPixels<AlphaU8Traits>(const ChannelRows &rows,
+                                        int col, int numPixels, quint8 *dstPtr)
 {
-    *dstPtr = reinterpret_cast<const quint16*>(channelBytes.first().constData())[col] >> 8;
+    const quint8 *srcPtr = reinterpret_cast<const quint8*>(rows.first()) + col;
+    memcpy(dstPtr, srcPtr, numPixels);
 }
 
 template <>
-void readAlphaMaskPixel<AlphaF32Traits>(const QMap<quint16, QByteArray> &channelBytes,
-                                        int col, quint8 *dstPtr)
+void readAlphaMaskPixels<AlphaU16Traits>(const ChannelRows &rows,
+                                         int col, int numPixels, quint8 *dstPtr)
 {
-    *dstPtr = reinterpret_cast<const float*>(channelBytes.first().constData())[col] * 255;
+    const quint16 *srcPtr = reinterpret_cast<const quint16*>(rows.first()) + col;
+    for (int i = 0; i < numPixels; i++) {
+        dstPtr[i] = srcPtr[i] >> 8;
+    }
 }
 
-template <class Traits>
-inline typename Traits::channels_type readChannelValue(const QMap<quint16, QByteArray> &channelBytes,
-                                       quint16 channelId, int col, typename Traits::channels_type defaultValue)
+template <>
+void readAlphaMaskPixels<AlphaF32Traits>(const ChannelRows &rows,
+                                         int col, int numPixels, quint8 *dstPtr)
 {
-    typedef typename Traits::channels_type channels_type;
-
-    if (channelBytes.contains(channelId)) {
-        const QByteArray &bytes = channelBytes[channelId];
-        if (col < bytes.size()) {
-            return convertByteOrder<Traits>(reinterpret_cast<const channels_type *>(bytes.constData())[col]);
-        }
-
-        dbgFile << "col index out of range channelId: "<< channelId << " col:" << col;
+    const float *srcPtr = reinterpret_cast<const float*>(rows.first()) + col;
+    for (int i = 0; i < numPixels; i++) {
+        dstPtr[i] = srcPtr[i] * 255;
     }
-
-    return defaultValue;
 }
 
 template <class Traits>
-void readGrayPixel(const QMap<quint16, QByteArray> &channelBytes,
-                  int col, quint8 *dstPtr)
+void readGrayPixels(const ChannelRows &rows,
+                    int col, int numPixels, quint8 *dstPtr)
 {
     typedef typename Traits::Pixel Pixel;
     typedef typename Traits::channels_type channels_type;
@@ -179,13 +202,18 @@ void readGrayPixel(const QMap<quint16, QByteArray> &channelBytes,
     const channels_type unitValue = KoColorSpaceMathsTraits<channels_type>::unitValue;
     Pixel *pixelPtr = reinterpret_cast<Pixel*>(dstPtr);
 
-    pixelPtr->gray  = readChannelValue<Traits>(channelBytes, 0, col, unitValue);
-    pixelPtr->alpha = readChannelValue<Traits>(channelBytes, -1, col, unitValue);
+    ChannelReader<Traits> gray(rows, 0, col);
+    ChannelReader<Traits> alpha(rows, -1, col);
+
+    for (int i = 0; i < numPixels; i++, pixelPtr++) {
+        pixelPtr->gray  = gray.next(unitValue);
+        pixelPtr->alpha = alpha.next(unitValue);
+    }
 }
 
 template <class Traits>
-void readRgbPixel(const QMap<quint16, QByteArray> &channelBytes,
-                  int col, quint8 *dstPtr)
+void readRgbPixels(const ChannelRows &rows,
+                   int col, int numPixels, quint8 *dstPtr)
 {
     typedef typename Traits::Pixel Pixel;
     typedef typename Traits::channels_type channels_type;
@@ -193,16 +221,22 @@ void readRgbPixel(const QMap<quint16, QByteArray> &channelBytes,
     const channels_type unitValue = KoColorSpaceMathsTraits<channels_type>::unitValue;
     Pixel *pixelPtr = reinterpret_cast<Pixel*>(dstPtr);
 
-    pixelPtr->blue  = readChannelValue<Traits>(channelBytes, 2, col, unitValue);
-    pixelPtr->green = readChannelValue<Traits>(channelBytes, 1, col, unitValue);
-    pixelPtr->red   = readChannelValue<Traits>(channelBytes, 0, col, unitValue);
-    pixelPtr->alpha = readChannelValue<Traits>(channelBytes, -1, col, unitValue);
+    ChannelReader<Traits> red(rows, 0, col);
+    ChannelReader<Traits> green(rows, 1, col);
+    ChannelReader<Traits> blue(rows, 2, col);
+    ChannelReader<Traits> alpha(rows, -1, col);
 
+    for (int i = 0; i < numPixels; i++, pixelPtr++) {
+        pixelPtr->blue  = blue.next(unitValue);
+        pixelPtr->green = green.next(unitValue);
+        pixelPtr->red   = red.next(unitValue);
+        pixelPtr->alpha = alpha.next(unitValue);
+    }
 }
 
 template <class Traits>
-void readCmykPixel(const QMap<quint16, QByteArray> &channelBytes,
-                       int col, quint8 *dstPtr)
+void readCmykPixels(const ChannelRows &rows,
+                    int col, int numPixels, quint8 *dstPtr)
 {
     typedef typename Traits::Pixel Pixel;
     typedef typename Traits::channels_type channels_type;
@@ -210,16 +244,24 @@ void readCmykPixel(const QMap<quint16, QByteArray> &channelBytes,
     const channels_type unitValue = KoColorSpaceMathsTraits<channels_type>::unitValue;
     Pixel *pixelPtr = reinterpret_cast<Pixel*>(dstPtr);
 
-    pixelPtr->cyan    = unitValue - readChannelValue<Traits>(channelBytes, 0, col, unitValue);
-    pixelPtr->magenta = unitValue - readChannelValue<Traits>(channelBytes, 1, col, unitValue);
-    pixelPtr->yellow  = unitValue - readChannelValue<Traits>(channelBytes, 2, col, unitValue);
-    pixelPtr->black   = unitValue - readChannelValue<Traits>(channelBytes, 3, col, unitValue);
-    pixelPtr->alpha   = readChannelValue<Traits>(channelBytes, -1, col, unitValue);
+    ChannelReader<Traits> cyan(rows, 0, col);
+    ChannelReader<Traits> magenta(rows, 1, col);
+    ChannelReader<Traits> yellow(rows, 2, col);
+    ChannelReader<Traits> black(rows, 3, col);
+    ChannelReader<Traits> alpha(rows, -1, col);
+
+    for (int i = 0; i < numPixels; i++, pixelPtr++) {
+        pixelPtr->cyan    = unitValue - cyan.next(unitValue);
+        pixelPtr->magenta = unitValue - magenta.next(unitValue);
+        pixelPtr->yellow  = unitValue - yellow.next(unitValue);
+        pixelPtr->black   = unitValue - black.next(unitValue);
+        pixelPtr->alpha   = alpha.next(unitValue);
+    }
 }
 
 template <class Traits>
-void readLabPixel(const QMap<quint16, QByteArray> &channelBytes,
-                  int col, quint8 *dstPtr)
+void readLabPixels(const ChannelRows &rows,
+                   int col, int numPixels, quint8 *dstPtr)
 {
     typedef typename Traits::Pixel Pixel;
     typedef typename Traits::channels_type channels_type;
@@ -227,74 +269,81 @@ void readLabPixel(const QMap<quint16, QByteArray> &channelBytes,
     const channels_type unitValue = KoColorSpaceMathsTraits<channels_type>::unitValue;
     Pixel *pixelPtr = reinterpret_cast<Pixel*>(dstPtr);
 
-    pixelPtr->L = readChannelValue<Traits>(channelBytes, 0, col, unitValue);
-    pixelPtr->a = readChannelValue<Traits>(channelBytes, 1, col, unitValue);
-    pixelPtr->b = readChannelValue<Traits>(channelBytes, 2, col, unitValue);
-    pixelPtr->alpha = readChannelValue<Traits>(channelBytes, -1, col, unitValue);
+    ChannelReader<Traits> L(rows, 0, col);
+    ChannelReader<Traits> a(rows, 1, col);
+    ChannelReader<Traits> b(rows, 2, col);
+    ChannelReader<Traits> alpha(rows, -1, col);
+
+    for (int i = 0; i < numPixels; i++, pixelPtr++) {
+        pixelPtr->L = L.next(unitValue);
+        pixelPtr->a = a.next(unitValue);
+        pixelPtr->b = b.next(unitValue);
+        pixelPtr->alpha = alpha.next(unitValue);
+    }
 }
 
 void readRgbPixelCommon(int channelSize,
-                               const QMap<quint16, QByteArray> &channelBytes,
-                               int col, quint8 *dstPtr)
+                        const ChannelRows &rows,
+                        int col, int numPixels, quint8 *dstPtr)
 {
     if (channelSize == 1) {
-        readRgbPixel<KoBgrU8Traits>(channelBytes, col, dstPtr);
+        readRgbPixels<KoBgrU8Traits>(rows, col, numPixels, dstPtr);
     } else if (channelSize == 2) {
-        readRgbPixel<KoBgrU16Traits>(channelBytes, col, dstPtr);
+        readRgbPixels<KoBgrU16Traits>(rows, col, numPixels, dstPtr);
     } else if (channelSize == 4) {
-        readRgbPixel<KoBgrU16Traits>(channelBytes, col, dstPtr);
+        readRgbPixels<KoBgrU16Traits>(rows, col, numPixels, dstPtr);
     }
 }
 
 void readGrayPixelCommon(int channelSize,
-                                const QMap<quint16, QByteArray> &channelBytes,
-                                int col, quint8 *dstPtr)
+                         const ChannelRows &rows,
+                         int col, int numPixels, quint8 *dstPtr)
 {
     if (channelSize == 1) {
-        readGrayPixel<KoGrayU8Traits>(channelBytes, col, dstPtr);
+        readGrayPixels<KoGrayU8Traits>(rows, col, numPixels, dstPtr);
     } else if (channelSize == 2) {
-        readGrayPixel<KoGrayU16Traits>(channelBytes, col, dstPtr);
+        readGrayPixels<KoGrayU16Traits>(rows, col, numPixels, dstPtr);
     } else if (channelSize == 4) {
-        readGrayPixel<KoGrayU32Traits>(channelBytes, col, dstPtr);
+        readGrayPixels<KoGrayU32Traits>(rows, col, numPixels, dstPtr);
     }
 }
 
 void readCmykPixelCommon(int channelSize,
-                                const QMap<quint16, QByteArray> &channelBytes,
-                                int col, quint8 *dstPtr)
+                         const ChannelRows &rows,
+                         int col, int numPixels, quint8 *dstPtr)
 {
     if (channelSize == 1) {
-        readCmykPixel<KoCmykU8Traits>(channelBytes, col, dstPtr);
+        readCmykPixels<KoCmykU8Traits>(rows, col, numPixels, dstPtr);
     } else if (channelSize == 2) {
-        readCmykPixel<KoCmykU16Traits>(channelBytes, col, dstPtr);
+        readCmykPixels<KoCmykU16Traits>(rows, col, numPixels, dstPtr);
     } else if (channelSize == 4) {
-        readCmykPixel<KoCmykF32Traits>(channelBytes, col, dstPtr);
+        readCmykPixels<KoCmykF32Traits>(rows, col, numPixels, dstPtr);
     }
 }
 
 void readLabPixelCommon(int channelSize,
-                                const QMap<quint16, QByteArray> &channelBytes,
-                                int col, quint8 *dstPtr)
+                        const ChannelRows &rows,
+                        int col, int numPixels, quint8 *dstPtr)
 {
     if (channelSize == 1) {
-        readLabPixel<KoLabU8Traits>(channelBytes, col, dstPtr);
+        readLabPixels<KoLabU8Traits>(rows, col, numPixels, dstPtr);
     } else if (channelSize == 2) {
-        readLabPixel<KoLabU16Traits>(channelBytes, col, dstPtr);
+        readLabPixels<KoLabU16Traits>(rows, col, numPixels, dstPtr);
     } else if (channelSize == 4) {
-        readLabPixel<KoLabF32Traits>(channelBytes, col, dstPtr);
+        readLabPixels<KoLabF32Traits>(rows, col, numPixels, dstPtr);
     }
 }
 
 void readAlphaMaskPixelCommon(int channelSize,
-                                const QMap<quint16, QByteArray> &channelBytes,
-                                int col, quint8 *dstPtr)
+                              const ChannelRows &rows,
+                              int col, int numPixels, quint8 *dstPtr)
 {
     if (channelSize == 1) {
-        readAlphaMaskPixel<AlphaU8Traits>(channelBytes, col, dstPtr);
+        readAlphaMaskPixels<AlphaU8Traits>(rows, col, numPixels, dstPtr);
     } else if (channelSize == 2) {
-        readAlphaMaskPixel<AlphaU16Traits>(channelBytes, col, dstPtr);
+        readAlphaMaskPixels<AlphaU16Traits>(rows, col, numPixels, dstPtr);
     } else if (channelSize == 4) {
-        readAlphaMaskPixel<AlphaF32Traits>(channelBytes, col, dstPtr);
+        readAlphaMaskPixels<AlphaF32Traits>(rows, col, numPixels, dstPtr);
     }
 }
 
@@ -391,41 +440,37 @@ psd_status psd_unzip_with_prediction(psd_uchar *src_buf, psd_int src_len,
 /* End of third party block                                           */
 /**********************************************************************/
 
-QMap<quint16, QByteArray> fetchChannelsBytes(QIODevice *io, QVector<ChannelInfo*> channelInfoRecords,
-                                            int row, int width, int channelSize, bool processMasks)
-{
-    const int uncompressedLength = width * channelSize;
-
-    QMap<quint16, QByteArray> channelBytes;
+typedef boost::function<void(int, const ChannelRows&, int, int, quint8*)> PixelFunc;
 
-    Q_FOREACH (ChannelInfo *channelInfo, channelInfoRecords) {
-        // user supplied masks are ignored here
-        if (!processMasks && channelInfo->channelId < -1) continue;
-
-        io->seek(channelInfo->channelDataStart + channelInfo->channelOffset);
+/**
+ * Converts one row of the layer, writing the pixels directly
+ * into the tiles of the device
+ */
+void writeRow(KisHLineIteratorSP it,
+              const ChannelRows &rows,
+              int width,
+              int channelSize,
+              PixelFunc pixelFunc)
+{
+    int col = 0;
 
-        if (channelInfo->compressionType == Compression::Uncompressed) {
-            channelBytes[channelInfo->channelId] = io->read(uncompressedLength);
-            channelInfo->channelOffset += uncompressedLength;
-        }
-        else if (channelInfo->compressionType == Compression::RLE) {
-            int rleLength = channelInfo->rleRowLengths[row];
-            QByteArray compressedBytes = io->read(rleLength);
-            QByteArray uncompressedBytes = Compression::uncompress(uncompressedLength, compressedBytes, channelInfo->compressionType);
-            channelBytes.insert(channelInfo->channelId, uncompressedBytes);
-            channelInfo->channelOffset += rleLength;
-        }
-        else {
-            QString error = QString("Unsupported Compression mode: %1").arg(channelInfo->compressionType);
-            dbgFile << "ERROR: fetchChannelsBytes:" << error;
-            throw KisAslReaderUtils::ASLParseException(error);
-        }
+    while (col < width) {
+        const int numPixels = qMin(it->nConseqPixels(), width - col);
+        pixelFunc(channelSize, rows, col, numPixels, it->rawData());
+        it->nextPixels(numPixels);
+        col += numPixels;
     }
-
-    return channelBytes;
 }
 
-typedef boost::function<void(int, const QMap<quint16, QByteArray>&, int, quint8*)> PixelFunc;
+/**
+ * A row of a channel that is read from the file, but not yet decoded
+ */
+struct RowDecodingJob {
+    Compression::CompressionType compressionType;
+    const char *src;
+    int srcLength;
+    char *dst;
+};
 
 void readCommon(KisPaintDeviceSP dev,
                 QIODevice *io,
@@ -442,6 +487,9 @@ void readCommon(KisPaintDeviceSP dev,
         return;
     }
 
+    const int width = layerRect.width();
+    const int rowLength = width * channelSize;
+
     if (infoRecords.first()->compressionType == Compression::ZIP ||
         infoRecords.first()->compressionType == Compression::ZIPWithPrediction) {
 
@@ -477,27 +525,109 @@ void readCommon(KisPaintDeviceSP dev,
             channelBytes.insert(info->channelId, uncompressedBytes);
         }
 
-        KisSequentialIterator it(dev, layerRect);
-        int col = 0;
-        while (it.nextPixel()) {
-            pixelFunc(channelSize, channelBytes, col, it.rawData());
-            col++;
+        KisHLineIteratorSP it = dev->createHLineIteratorNG(layerRect.left(), layerRect.top(), layerRect.width());
+        for (int row = 0; row < layerRect.height(); row++) {
+            ChannelRows rows;
+
+            for (auto chIt = channelBytes.constBegin(); chIt != channelBytes.constEnd(); ++chIt) {
+                rows.insert(chIt.key(), reinterpret_cast<const quint8*>(chIt.value().constData()) + row * rowLength);
+            }
+
+            writeRow(it, rows, width, channelSize, pixelFunc);
+            it->nextRow();
         }
 
     } else {
+        QVector<ChannelInfo*> channels;
+
+        Q_FOREACH (ChannelInfo *channelInfo, infoRecords) {
+            // user supplied masks are ignored here
+            if (!processMasks && channelInfo->channelId < -1) continue;
+
+            if (channelInfo->compressionType != Compression::Uncompressed &&
+                channelInfo->compressionType != Compression::RLE) {
+
+                QString error = QString("Unsupported Compression mode: %1").arg(channelInfo->compressionType);
+                dbgFile << "ERROR: readCommon:" << error;
+                throw KisAslReaderUtils::ASLParseException(error);
+            }
+
+            channels << channelInfo;
+        }
+
+        /**
+         * The layer is read in bands of rows. The compressed data of a
+         * band is read from the file sequentially, then the rows are
+         * decoded in parallel and written into the device. Only one
+         * band of the layer is kept in memory at a time.
+         */
+        const int bandHeight = 64;
+
+        QVector<QByteArray> compressedBands(channels.size());
+        QVector<QByteArray> decodedBands(channels.size());
+        QVector<RowDecodingJob> jobs;
+
         KisHLineIteratorSP it = dev->createHLineIteratorNG(layerRect.left(), layerRect.top(), layerRect.width());
-        for (int i = 0 ; i < layerRect.height(); i++) {
-            QMap<quint16, QByteArray> channelBytes;
 
-            channelBytes = fetchChannelsBytes(io, infoRecords,
-                                              i, layerRect.width(),
-                                              channelSize, processMasks);
+        for (int bandTop = 0; bandTop < layerRect.height(); bandTop += bandHeight) {
+            const int numRows = qMin(bandHeight, layerRect.height() - bandTop);
+
+            jobs.clear();
+
+            for (int i = 0; i < channels.size(); i++) {
+                ChannelInfo *channelInfo = channels[i];
+
+                QVector<int> rowLengths(numRows, rowLength);
+                if (channelInfo->compressionType == Compression::RLE) {
+                    for (int row = 0; row < numRows; row++) {
+                        rowLengths[row] = channelInfo->rleRowLengths[bandTop + row];
+                    }
+                }
 
-            for (qint64 col = 0; col < layerRect.width(); col++){
-                pixelFunc(channelSize, channelBytes, col, it->rawData());
-                it->nextPixel();
+                const int bandLength = std::accumulate(rowLengths.begin(), rowLengths.end(), 0);
+
+                io->seek(channelInfo->channelDataStart + channelInfo->channelOffset);
+                compressedBands[i] = io->read(bandLength);
+                channelInfo->channelOffset += bandLength;
+
+                decodedBands[i].fill(0, numRows * rowLength);
+
+                const char *src = compressedBands[i].constData();
+                char *dst = decodedBands[i].data();
+                int srcOffset = 0;
+
+                for (int row = 0; row < numRows; row++) {
+                    RowDecodingJob job;
+                    job.compressionType = channelInfo->compressionType;
+                    job.src = src + srcOffset;
+                    job.srcLength = qBound(0, compressedBands[i].size() - srcOffset, rowLengths[row]);
+                    job.dst = dst + row * rowLength;
+                    jobs.append(job);
+
+                    srcOffset += rowLengths[row];
+                }
+            }
+
+            QtConcurrent::blockingMap(jobs,
+                [rowLength] (const RowDecodingJob &job) {
+                    if (job.compressionType == Compression::RLE) {
+                        Compression::decodePackBits(job.src, job.srcLength, job.dst, rowLength);
+                    } else {
+                        memcpy(job.dst, job.src, qMin(job.srcLength, rowLength));
+                    }
+                });
+
+            for (int row = 0; row < numRows; row++) {
+                ChannelRows rows;
+
+                for (int i = 0; i < channels.size(); i++) {
+                    rows.insert(channels[i]->channelId,
+                                reinterpret_cast<const quint8*>(decodedBands[i].constData()) + row * rowLength);
+                }
+
+                writeRow(it, rows, width, channelSize, pixelFunc);
+                it->nextRow();
             }
-            it->nextRow();
         }
     }
 }
@@ -543,53 +673,180 @@ void readAlphaMaskChannels(QIODevice *io,
     readCommon(device, io, layerRect, infoRecords, channelSize, &readAlphaMaskPixelCommon, true);
 }
 
-void writeChannelDataRLE(QIODevice *io, const quint8 *plane, const int channelSize, const QRect &rc, const qint64 sizeFieldOffset, const qint64 rleBlockOffset, const bool writeCompressionType)
+/**
+ * The height of the bands of rows compressed by the worker threads
+ */
+const int rleBandHeight = 64;
+
+/**
+ * A band of rows of a channel compressed with PackBits by a single
+ * worker thread, ready to be written into the file
+ */
+struct CompressedRowBand {
+    QVector<quint16> rowLengths;
+    QByteArray data;
+};
+
+/**
+ * Compresses the rows of the channels on the worker threads and
+ * returns them in the order they are written into the file: channel by
+ * channel, band by band. Only a few bands are kept in flight, so the
+ * compressed data of the whole image never resides in memory.
+ */
+class RowBandsCompressorRLE
 {
-    typedef KisAslWriterUtils::OffsetStreamPusher<quint32> Pusher;
-    QScopedPointer<Pusher> channelBlockSizeExternalTag;
-    if (sizeFieldOffset >= 0) {
-        channelBlockSizeExternalTag.reset(new Pusher(io, 0, sizeFieldOffset));
+public:
+    RowBandsCompressorRLE(const QVector<const quint8*> &planes, const int channelSize, const QRect &rc)
+        : m_planes(planes),
+          m_stride(channelSize * rc.width()),
+          m_numRows(rc.height()),
+          m_bandsPerChannel((rc.height() + rleBandHeight - 1) / rleBandHeight)
+    {
+        // every band in flight is compressed by its own worker thread
+        m_maxPendingBands = qBound(2, KisImageConfig(true).maxNumberOfThreads(), 8);
     }
 
-    if (writeCompressionType) {
-        SAFE_WRITE_EX(io, (quint16)Compression::RLE);
+    ~RowBandsCompressorRLE() {
+        // the jobs access the planes, so they should finish before the planes are gone
+        Q_FOREACH (QFuture<CompressedRowBand> band, m_pendingBands) {
+            band.waitForFinished();
+        }
     }
 
-    const bool externalRleBlock = rleBlockOffset >= 0;
+    CompressedRowBand nextBand() {
+        scheduleBands();
+        KIS_ASSERT_RECOVER_RETURN_VALUE(!m_pendingBands.isEmpty(), CompressedRowBand());
 
-    // the start of RLE sizes block
-    const qint64 channelRLESizePos = externalRleBlock ? rleBlockOffset : io->pos();
+        CompressedRowBand band = m_pendingBands.dequeue().result();
 
-    {
-        QScopedPointer<KisOffsetKeeper> rleOffsetKeeper;
+        // keep the workers busy while the band is being written
+        scheduleBands();
+
+        return band;
+    }
+
+    int bandsPerChannel() const {
+        return m_bandsPerChannel;
+    }
+
+private:
+    void scheduleBands() {
+        const int totalBands = m_planes.size() * m_bandsPerChannel;
+
+        while (m_pendingBands.size() < m_maxPendingBands && m_nextBand < totalBands) {
+            const quint8 *plane = m_planes[m_nextBand / m_bandsPerChannel];
+            const int firstRow = (m_nextBand % m_bandsPerChannel) * rleBandHeight;
+            const int numRows = qMin(rleBandHeight, m_numRows - firstRow);
+            const int stride = m_stride;
 
-        if (externalRleBlock) {
-            rleOffsetKeeper.reset(new KisOffsetKeeper(io));
-            io->seek(rleBlockOffset);
+            m_pendingBands.enqueue(
+                QtConcurrent::run(
+                    [plane, stride, firstRow, numRows] () {
+                        return compressBand(plane, stride, firstRow, numRows);
+                    }));
+
+            m_nextBand++;
         }
+    }
+
+    static CompressedRowBand compressBand(const quint8 *plane, int stride, int firstRow, int numRows) {
+        CompressedRowBand band;
+
+        for (int row = firstRow; row < firstRow + numRows; row++) {
+            QByteArray uncompressed = QByteArray::fromRawData((const char*)plane + row * stride, stride);
+            QByteArray compressed = Compression::compress(uncompressed, Compression::RLE);
 
-        // write zero's for the channel lengths block
-        for(int i = 0; i < rc.height(); ++i) {
-            // XXX: choose size for PSB!
-            const quint16 fakeRLEBLockSize = 0;
-            SAFE_WRITE_EX(io, fakeRLEBLockSize);
+            band.rowLengths.append(compressed.size());
+            band.data.append(compressed);
         }
+
+        return band;
     }
 
-    quint32 stride = channelSize * rc.width();
-    for (qint32 row = 0; row < rc.height(); ++row) {
+private:
+    QVector<const quint8*> m_planes;
+    int m_stride;
+    int m_numRows;
+    int m_bandsPerChannel;
+    int m_maxPendingBands = 2;
+    int m_nextBand = 0;
+    QQueue<QFuture<CompressedRowBand>> m_pendingBands;
+};
+
+void writeChannelsRLE(QIODevice *io, const QVector<const quint8*> &planes, const int channelSize, const QRect &rc, const QVector<ChannelWritingInfo> &writingInfoList, const bool writeCompressionType)
+{
+    KIS_ASSERT_RECOVER_RETURN(planes.size() == writingInfoList.size());
+
+    RowBandsCompressorRLE compressor(planes, channelSize, rc);
 
-        QByteArray uncompressed = QByteArray::fromRawData((const char*)plane + row * stride, stride);
-        QByteArray compressed = Compression::compress(uncompressed, Compression::RLE);
+    for (int i = 0; i < writingInfoList.size(); i++) {
+        const ChannelWritingInfo &info = writingInfoList[i];
 
-        KisAslWriterUtils::OffsetStreamPusher<quint16> rleExternalTag(io, 0, channelRLESizePos + row * sizeof(quint16));
+        dbgFile << "\tWriting channel" << i << "psd channel id" << info.channelId;
+        dbgFile << "\t\tchannel start" << ppVar(io->pos());
 
-        if (io->write(compressed) != compressed.size()) {
+        typedef KisAslWriterUtils::OffsetStreamPusher<quint32> Pusher;
+        QScopedPointer<Pusher> channelBlockSizeExternalTag;
+        if (info.sizeFieldOffset >= 0) {
+            channelBlockSizeExternalTag.reset(new Pusher(io, 0, info.sizeFieldOffset));
+        }
+
+        if (writeCompressionType) {
+            SAFE_WRITE_EX(io, (quint16)Compression::RLE);
+        }
+
+        const bool externalRleBlock = info.rleBlockOffset >= 0;
+
+        // the start of RLE sizes block
+        const qint64 channelRLESizePos = externalRleBlock ? info.rleBlockOffset : io->pos();
+
+        // XXX: choose size for PSB!
+        QByteArray rleSizes(rc.height() * sizeof(quint16), 0);
+        quint16 *rleSizesPtr = reinterpret_cast<quint16*>(rleSizes.data());
+
+        // reserve the space for the internal RLE sizes block, it
+        // is filled in when all the rows are written
+        if (!externalRleBlock && io->write(rleSizes) != rleSizes.size()) {
             throw KisAslWriterUtils::ASLWriteException("Failed to write image data");
         }
+
+        int row = 0;
+
+        for (int j = 0; j < compressor.bandsPerChannel(); j++) {
+            const CompressedRowBand band = compressor.nextBand();
+
+            if (io->write(band.data) != band.data.size()) {
+                throw KisAslWriterUtils::ASLWriteException("Failed to write image data");
+            }
+
+            Q_FOREACH (quint16 length, band.rowLengths) {
+                KIS_ASSERT_RECOVER_BREAK(row < rc.height());
+                rleSizesPtr[row++] = qToBigEndian(length);
+            }
+        }
+
+        {
+            KisOffsetKeeper rleOffsetKeeper(io);
+            io->seek(channelRLESizePos);
+
+            if (io->write(rleSizes) != rleSizes.size()) {
+                throw KisAslWriterUtils::ASLWriteException("Failed to write image data");
+            }
+        }
     }
 }
 
+void writeChannelDataRLE(QIODevice *io, const quint8 *plane, const int channelSize, const QRect &rc, const qint64 sizeFieldOffset, const qint64 rleBlockOffset, const bool writeCompressionType)
+{
+    QVector<const quint8*> planes;
+    planes << plane;
+
+    QVector<ChannelWritingInfo> writingInfoList;
+    writingInfoList << ChannelWritingInfo(0, sizeFieldOffset, rleBlockOffset);
+
+    writeChannelsRLE(io, planes, channelSize, rc, writingInfoList, writeCompressionType);
+}
+
 inline void preparePixelForWrite(quint8 *dataPlane,
                                  int numPixels,
                                  int channelSize,
@@ -688,20 +945,26 @@ void writePixelDataCommon(QIODevice *io,
 
     const int numPixels = rc.width() * rc.height();
 
-    // write down the planes
+    // convert the planes on the worker threads
 
-    try {
-        for (int i = 0; i < writingInfoList.size(); i++) {
-            const ChannelWritingInfo &info = writingInfoList[i];
+    QVector<int> channelIndexes;
+    QVector<const quint8*> constPlanes;
 
-            dbgFile << "\tWriting channel" << i << "psd channel id" << info.channelId;
+    for (int i = 0; i < writingInfoList.size(); i++) {
+        channelIndexes << i;
+        constPlanes << planes[i];
+    }
 
-            preparePixelForWrite(planes[i], numPixels, channelSize, info.channelId, colorMode);
+    QtConcurrent::blockingMap(channelIndexes,
+        [&] (int i) {
+            preparePixelForWrite(planes[i], numPixels, channelSize, writingInfoList[i].channelId, colorMode);
+        });
 
-            dbgFile << "\t\tchannel start" << ppVar(io->pos());
+    // compress the planes band by band and write them down as soon
+    // as the bands are ready
 
-            writeChannelDataRLE(io, planes[i], channelSize, rc, info.sizeFieldOffset, info.rleBlockOffset, writeCompressionType);
-        }
+    try {
+        writeChannelsRLE(io, constPlanes, channelSize, rc, writingInfoList, writeCompressionType);
 
     } catch (KisAslWriterUtils::ASLWriteException &e) {
         Q_FOREACH (quint8 *plane, planes) {
@@ -97,5 +97,59 @@ void CompressionTest::testCompressionUncompressed()
 
 }
 
+void CompressionTest::testDecodePackBitsWideRow()
+{
+    // uncompress() gives up on rows longer than 30000 bytes
+    const int rowLength = 100000;
+
+    QByteArray row(rowLength, 0);
+    for (int i = 0; i < rowLength; ++i) {
+        // mix the runs with the literal sequences
+        row[i] = (i / 300) % 2 ? char(i / 300) : char(i * 7 + i / 13);
+    }
+
+    const QByteArray compressed = Compression::compress(row, Compression::RLE);
+    QVERIFY(!compressed.isEmpty());
+    QVERIFY(compressed.size() < row.size());
+
+    QByteArray decoded(rowLength, char(0xff));
+    Compression::decodePackBits(compressed.constData(), compressed.size(), decoded.data(), decoded.size());
+
+    QVERIFY(decoded == row);
+}
+
+void CompressionTest::testDecodePackBitsTruncated()
+{
+    // a literal sequence of 5 bytes and a run of 4 'x'
+    const char packed[] = {4, 'a', 'b', 'c', 'd', 'e', -3, 'x'};
+
+    {
+        QByteArray decoded(9, char(0xff));
+        Compression::decodePackBits(packed, sizeof(packed), decoded.data(), decoded.size());
+        QCOMPARE(decoded, QByteArray("abcdexxxx"));
+    }
+
+    // the run is cut off, the rest of the row should be zeroed
+    {
+        QByteArray decoded(9, char(0xff));
+        Compression::decodePackBits(packed, 6, decoded.data(), decoded.size());
+        QCOMPARE(decoded, QByteArray("abcde\0\0\0\0", 9));
+    }
+
+    // the literal sequence is cut off in the middle
+    {
+        QByteArray decoded(9, char(0xff));
+        Compression::decodePackBits(packed, 3, decoded.data(), decoded.size());
+        QCOMPARE(decoded, QByteArray("ab\0\0\0\0\0\0\0", 9));
+    }
+
+    // no data at all
+    {
+        QByteArray decoded(9, char(0xff));
+        Compression::decodePackBits(packed, 0, decoded.data(), decoded.size());
+        QCOMPARE(decoded, QByteArray(9, 0));
+    }
+}
+
 QTEST_MAIN(CompressionTest)
 
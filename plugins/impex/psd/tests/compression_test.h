@@ -30,6 +30,9 @@ private Q_SLOTS:
     void testCompressionZIP();
     void testCompressionUncompressed();
 
+    void testDecodePackBitsWideRow();
+    void testDecodePackBitsTruncated();
+
 };
 
 #endif
@@ -35,6 +35,9 @@
 #include "kis_psd_layer_style.h"
 #include "kis_paint_device_debug_utils.h"
 #include <KisImportExportErrorCode.h>
+#include <KoColorSpaceRegistry.h>
+#include "kis_paint_layer.h"
+#include "kis_sequential_iterator.h"
 
 
 
@@ -353,6 +356,57 @@ void KisPSDTest::testSavingAllFormats()
 
 
 
+void KisPSDTest::testSaveLoadWideRLELayer()
+{
+    /**
+     * The rows of a 16-bit channel of this layer are longer than 30000
+     * bytes, which used to be decoded as empty rows, and the height
+     * is not a multiple of the height of the bands the layer is
+     * read and written in
+     */
+    const QRect rc(0, 0, 16000, 100);
+
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb16();
+    KisImageSP image = new KisImage(0, rc.width(), rc.height(), cs, "wide rle layer");
+
+    KisPaintLayerSP layer = new KisPaintLayer(image, "layer", OPACITY_OPAQUE_U8);
+
+    quint32 seed = 42;
+
+    KisSequentialIterator it(layer->paintDevice(), rc);
+    while (it.nextPixel()) {
+        seed = seed * 1103515245 + 12345;
+        const quint16 noise = (seed >> 16) & 0xff;
+
+        quint16 *pixel = reinterpret_cast<quint16*>(it.rawData());
+        pixel[0] = quint16(it.x() * 4 + noise);
+        pixel[1] = quint16(it.y() * 600);
+        pixel[2] = (it.x() / 256) % 2 ? 0xffff : quint16(noise * 256);
+        pixel[3] = it.y() < 90 ? 0xffff : quint16(0xffff - (it.x() & 0xff));
+    }
+
+    image->addNode(layer, image->root());
+    image->initialRefreshGraph();
+
+    QScopedPointer<KisDocument> doc(qobject_cast<KisDocument*>(KisPart::instance()->createDocument()));
+    doc->setCurrentImage(image);
+    doc->setFileBatchMode(true);
+
+    QFileInfo dstFileInfo(QDir::currentPath() + QDir::separator() + "psd_wide_rle_layer.psd");
+
+    QVERIFY(doc->exportDocumentSync(QUrl::fromLocalFile(dstFileInfo.absoluteFilePath()), PSDMimetype.toLatin1()));
+
+    QSharedPointer<KisDocument> loadedDoc = openPsdDocument(dstFileInfo);
+    QVERIFY(loadedDoc->image());
+
+    KisNodeSP loadedLayer = loadedDoc->image()->root()->firstChild();
+    QVERIFY(loadedLayer);
+
+    QPoint errorPoint;
+    QVERIFY(TestUtil::comparePaintDevices(errorPoint, layer->paintDevice(), loadedLayer->paintDevice()));
+}
+
+
 void KisPSDTest::testImportFromWriteonly()
 {
     TestUtil::testImportFromWriteonly(QString(FILES_DATA_DIR), PSDMimetype);
@@ -41,6 +41,8 @@ private Q_SLOTS:
     void testOpeningAllFormats();
     void testSavingAllFormats();
 
+    void testSaveLoadWideRLELayer();
+
 
     void testImportFromWriteonly();
     void testExportToReadonly();
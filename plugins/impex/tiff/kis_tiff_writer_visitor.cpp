@@ -23,6 +23,7 @@
 #include <KoColorSpace.h>
 #include <KoID.h>
 #include <KoColorSpaceRegistry.h>
+#include <KisBandedDeviceReader.h>
 
 #include <KoConfig.h>
 #ifdef HAVE_OPENEXR
@@ -113,62 +114,62 @@ KisTIFFWriterVisitor::~KisTIFFWriterVisitor()
 {
 }
 
-bool KisTIFFWriterVisitor::copyDataToStrips(KisHLineConstIteratorSP it, tdata_t buff, uint8 depth, uint16 sample_format, uint8 nbcolorssamples, quint8* poses)
+bool KisTIFFWriterVisitor::copyDataToStrips(const quint8 *src, int numPixels, int pixelSize, tdata_t buff, uint8 depth, uint16 sample_format, uint8 nbcolorssamples, quint8* poses)
 {
     if (depth == 32) {
         Q_ASSERT(sample_format == SAMPLEFORMAT_IEEEFP);
         float *dst = reinterpret_cast<float *>(buff);
-        do {
-            const float *d = reinterpret_cast<const float *>(it->oldRawData());
+        for (int x = 0; x < numPixels; x++, src += pixelSize) {
+            const float *d = reinterpret_cast<const float *>(src);
             int i;
             for (i = 0; i < nbcolorssamples; i++) {
                 *(dst++) = d[poses[i]];
             }
             if (m_options->alpha) *(dst++) = d[poses[i]];
-        } while (it->nextPixel());
+        }
         return true;
     }
     else if (depth == 16 ) {
         if (sample_format == SAMPLEFORMAT_IEEEFP) {
 #ifdef HAVE_OPENEXR
             half *dst = reinterpret_cast<half *>(buff);
-            do {
-                const half *d = reinterpret_cast<const half *>(it->oldRawData());
+            for (int x = 0; x < numPixels; x++, src += pixelSize) {
+                const half *d = reinterpret_cast<const half *>(src);
                 int i;
                 for (i = 0; i < nbcolorssamples; i++) {
                     *(dst++) = d[poses[i]];
                 }
                 if (m_options->alpha) *(dst++) = d[poses[i]];
 
-            } while (it->nextPixel());
+            }
             return true;
 #endif
         }
         else {
             quint16 *dst = reinterpret_cast<quint16 *>(buff);
-            do {
-                const quint16 *d = reinterpret_cast<const quint16 *>(it->oldRawData());
+            for (int x = 0; x < numPixels; x++, src += pixelSize) {
+                const quint16 *d = reinterpret_cast<const quint16 *>(src);
                 int i;
                 for (i = 0; i < nbcolorssamples; i++) {
                     *(dst++) = d[poses[i]];
                 }
                 if (m_options->alpha) *(dst++) = d[poses[i]];
 
-            } while (it->nextPixel());
+            }
             return true;
         }
     }
     else if (depth == 8) {
         quint8 *dst = reinterpret_cast<quint8 *>(buff);
-        do {
-            const quint8 *d = it->oldRawData();
+        for (int x = 0; x < numPixels; x++, src += pixelSize) {
+            const quint8 *d = src;
             int i;
             for (i = 0; i < nbcolorssamples; i++) {
                 *(dst++) = d[poses[i]];
             }
             if (m_options->alpha) *(dst++) = d[poses[i]];
 
-        } while (it->nextPixel());
+        }
         return true;
     }
     return false;
@@ -187,20 +188,20 @@ bool KisTIFFWriterVisitor::saveLayerProjection(KisLayer *layer)
         if (!destColorSpace) {
             return false;
         }
-        pd.attach(new KisPaintDevice(*pd));
-        pd->convertTo(destColorSpace);
+    } else {
+        destColorSpace = pd->colorSpace();
     }
 
     // Save depth
-    int depth = 8 * pd->pixelSize() / pd->channelCount();
+    int depth = 8 * destColorSpace->pixelSize() / destColorSpace->channelCount();
     TIFFSetField(image(), TIFFTAG_BITSPERSAMPLE, depth);
     // Save number of samples
     if (m_options->alpha) {
-        TIFFSetField(image(), TIFFTAG_SAMPLESPERPIXEL, pd->channelCount());
+        TIFFSetField(image(), TIFFTAG_SAMPLESPERPIXEL, destColorSpace->channelCount());
         uint16 sampleinfo[1] = { EXTRASAMPLE_UNASSALPHA };
         TIFFSetField(image(), TIFFTAG_EXTRASAMPLES, 1, sampleinfo);
     } else {
-        TIFFSetField(image(), TIFFTAG_SAMPLESPERPIXEL, pd->channelCount() - 1);
+        TIFFSetField(image(), TIFFTAG_SAMPLESPERPIXEL, destColorSpace->channelCount() - 1);
         TIFFSetField(image(), TIFFTAG_EXTRASAMPLES, 0);
     }
 
@@ -226,7 +227,7 @@ bool KisTIFFWriterVisitor::saveLayerProjection(KisLayer *layer)
 
     // Save profile
     if (m_options->saveProfile) {
-        const KoColorProfile* profile = pd->colorSpace()->profile();
+        const KoColorProfile* profile = destColorSpace->profile();
         if (profile && profile->type() == "icc" && !profile->rawData().isEmpty()) {
             QByteArray ba = profile->rawData();
             TIFFSetField(image(), TIFFTAG_ICCPROFILE, ba.size(), ba.constData());
@@ -236,39 +237,50 @@ bool KisTIFFWriterVisitor::saveLayerProjection(KisLayer *layer)
     tdata_t buff = _TIFFmalloc(stripsize);
     qint32 height = layer->image()->height();
     qint32 width = layer->image()->width();
+    const int pixelSize = destColorSpace->pixelSize();
     bool r = true;
-    for (int y = 0; y < height; y++) {
-        KisHLineConstIteratorSP it = pd->createHLineConstIteratorNG(0, y, width);
-        switch (color_type) {
-        case PHOTOMETRIC_MINISBLACK: {
-                quint8 poses[] = { 0, 1 };
-                r = copyDataToStrips(it, buff, depth, sample_format, 1, poses);
-            }
-            break;
-        case PHOTOMETRIC_RGB: {
-                quint8 poses[4];
-                if (sample_format == SAMPLEFORMAT_IEEEFP) {
-                    poses[2] = 2; poses[1] = 1; poses[0] = 0; poses[3] = 3;
-                } else {
-                    poses[0] = 2; poses[1] = 1; poses[2] = 0; poses[3] = 3;
+
+    // the rows are converted into destColorSpace band by band,
+    // the projection is never copied as a whole
+    KisBandedDeviceReader reader(pd, QRect(0, 0, width, height), destColorSpace);
+
+    while (reader.nextBand()) {
+        for (int y = reader.bandTop(); y <= reader.bandBottom(); y++) {
+            const quint8 *src = reader.row(y);
+            switch (color_type) {
+            case PHOTOMETRIC_MINISBLACK: {
+                    quint8 poses[] = { 0, 1 };
+                    r = copyDataToStrips(src, width, pixelSize, buff, depth, sample_format, 1, poses);
                 }
-                r = copyDataToStrips(it, buff, depth, sample_format, 3, poses);
-            }
-            break;
-        case PHOTOMETRIC_SEPARATED: {
-                quint8 poses[] = { 0, 1, 2, 3, 4 };
-                r = copyDataToStrips(it, buff, depth, sample_format, 4, poses);
+                break;
+            case PHOTOMETRIC_RGB: {
+                    quint8 poses[4];
+                    if (sample_format == SAMPLEFORMAT_IEEEFP) {
+                        poses[2] = 2; poses[1] = 1; poses[0] = 0; poses[3] = 3;
+                    } else {
+                        poses[0] = 2; poses[1] = 1; poses[2] = 0; poses[3] = 3;
+                    }
+                    r = copyDataToStrips(src, width, pixelSize, buff, depth, sample_format, 3, poses);
+                }
+                break;
+            case PHOTOMETRIC_SEPARATED: {
+                    quint8 poses[] = { 0, 1, 2, 3, 4 };
+                    r = copyDataToStrips(src, width, pixelSize, buff, depth, sample_format, 4, poses);
+                }
+                break;
+            case PHOTOMETRIC_ICCLAB: {
+                    quint8 poses[] = { 0, 1, 2, 3 };
+                    r = copyDataToStrips(src, width, pixelSize, buff, depth, sample_format, 3, poses);
+                }
+                break;
+                return false;
             }
-            break;
-        case PHOTOMETRIC_ICCLAB: {
-                quint8 poses[] = { 0, 1, 2, 3 };
-                r = copyDataToStrips(it, buff, depth, sample_format, 3, poses);
+            if (!r) {
+                _TIFFfree(buff);
+                return false;
             }
-            break;
-            return false;
+            TIFFWriteScanline(image(), buff, y, (tsample_t) - 1);
         }
-        if (!r) return false;
-        TIFFWriteScanline(image(), buff, y, (tsample_t) - 1);
     }
     _TIFFfree(buff);
     TIFFWriteDirectory(image());
@@ -25,6 +25,8 @@
 #include <KoColorSpace.h>
 
 #include <QRect>
+#include <QThread>
+#include <QtConcurrentMap>
 
 #include <kis_types.h>
 #include <kis_iterator_ng.h>
@@ -36,12 +38,17 @@
 
 const qreal degToRad = M_PI / 180.0;
 
+// dabs smaller than that are not worth splitting between threads
+const int minThreadedMaskArea = 128 * 128;
+
 
 DeformBrush::DeformBrush()
 {
     m_firstPaint = false;
     m_counter = 1;
     m_deformAction = 0;
+    m_lodScale = 1.0;
+    m_idealThreadCountCached = QThread::idealThreadCount();
 }
 
 DeformBrush::~DeformBrush()
@@ -79,7 +86,7 @@ void DeformBrush::initDeformAction()
     }
     case DEFORM_COLOR: {
         m_deformAction = new DeformColor();
-        static_cast<DeformColor*>(m_deformAction)->setFactor(m_properties->deform_amount);
+        static_cast<DeformColor*>(m_deformAction)->setFactor(m_properties->deform_amount * m_lodScale);
         break;
     }
     default: {
@@ -142,7 +149,8 @@ bool DeformBrush::setupAction(
     }
     case LENS_IN:
     case LENS_OUT: {
-        static_cast<DeformLens*>(m_deformAction)->setMaxDistance(m_sizeProperties->brush_diameter * 0.5, m_sizeProperties->brush_diameter * 0.5);
+        const qreal maxDistance = m_sizeProperties->brush_diameter * 0.5 * m_lodScale;
+        static_cast<DeformLens*>(m_deformAction)->setMaxDistance(maxDistance, maxDistance);
         break;
     }
     case DEFORM_COLOR: {
@@ -163,7 +171,6 @@ KisFixedPaintDeviceSP DeformBrush::paintMask(KisFixedPaintDeviceSP dab,
         QPointF pos, qreal subPixelX, qreal subPixelY, int dabX, int dabY)
 {
     KisFixedPaintDeviceSP mask = new KisFixedPaintDevice(KoColorSpaceRegistry::instance()->alpha8());
-    KisCrossDeviceColorPicker colorPicker(layer, dab);
 
     qreal fWidth = maskWidth(scale);
     qreal fHeight = maskHeight(scale);
@@ -177,45 +184,92 @@ KisFixedPaintDeviceSP DeformBrush::paintMask(KisFixedPaintDeviceSP dab,
         dab->lazyGrowBufferWithoutInitialization();
     }
 
-    qreal const centerX = dstWidth  * 0.5  + subPixelX;
-    qreal const centerY = dstHeight * 0.5  + subPixelY;
-
-    qreal const majorAxis = 2.0 / fWidth;
-    qreal const minorAxis = 2.0 / fHeight;
-
-    qreal distance;
-
-    QTransform forwardRotationMatrix;
-    forwardRotationMatrix.rotateRadians(-rotation);
-    QTransform reverseRotationMatrix;
-    reverseRotationMatrix.rotateRadians(rotation);
+    MaskProcessingData data;
+    data.layer = layer;
+    data.dab = dab;
+    data.mask = mask;
+    data.pos = pos;
+    data.dabX = dabX;
+    data.dabY = dabY;
+    data.centerX = dstWidth  * 0.5  + subPixelX;
+    data.centerY = dstHeight * 0.5  + subPixelY;
+    data.majorAxis = 2.0 / fWidth;
+    data.minorAxis = 2.0 / fHeight;
+    data.forwardRotationMatrix.rotateRadians(-rotation);
+    data.reverseRotationMatrix.rotateRadians(rotation);
 
     // if can't paint, stop
     if (!setupAction(DeformModes(m_properties->deform_action - 1),
-                     pos, forwardRotationMatrix))
+                     pos, data.forwardRotationMatrix))
     {
         return 0;
     }
 
     mask->setRect(dab->bounds());
     mask->lazyGrowBufferWithoutInitialization();
-    quint8* maskPointer = mask->data();
-    qint8 maskPixelSize = mask->pixelSize();
 
-    quint8* dabPointer = dab->data();
-    int dabPixelSize = dab->colorSpace()->pixelSize();
+    /**
+     * All the source pixels are sampled before the dab is blitted, so the
+     * rows can be processed in any order. The only non-reentrant part is
+     * drand48(), used by the color deformation and the density option, so
+     * these modes stay single-threaded.
+     */
+    const bool usesRandom =
+        DeformModes(m_properties->deform_action - 1) == DEFORM_COLOR ||
+        m_sizeProperties->brush_density != 1.0;
+
+    const int jobs = m_idealThreadCountCached;
+
+    if (!usesRandom && jobs >= 2 && dstWidth * dstHeight >= minThreadedMaskArea) {
+        const int numStripes = qMin(jobs * 2, dstHeight);
+        const int stripeHeight = dstHeight / numStripes;
+
+        QVector<QRect> rects;
+        for (int i = 0; i < numStripes - 1; i++) {
+            rects << QRect(0, i * stripeHeight, dstWidth, stripeHeight);
+        }
+        rects << QRect(0, (numStripes - 1) * stripeHeight, dstWidth, dstHeight - (numStripes - 1) * stripeHeight);
+
+        QtConcurrent::blockingMap(rects,
+            [this, &data] (const QRect &rc) {
+                processMaskRows(rc, data);
+            });
+    } else {
+        processMaskRows(QRect(0, 0, dstWidth, dstHeight), data);
+    }
+
+    m_counter++;
+
+    return mask;
+
+}
+
+void DeformBrush::processMaskRows(const QRect &rc, const MaskProcessingData &data)
+{
+    // the color picker keeps a random accessor, so it cannot be shared between the threads
+    KisCrossDeviceColorPicker colorPicker(data.layer, data.dab);
+
+    const int dstWidth = data.dab->bounds().width();
+
+    const int maskPixelSize = data.mask->pixelSize();
+    const int dabPixelSize = data.dab->colorSpace()->pixelSize();
+
+    quint8* maskPointer = data.mask->data() + (rc.y() * dstWidth + rc.x()) * maskPixelSize;
+    quint8* dabPointer = data.dab->data() + (rc.y() * dstWidth + rc.x()) * dabPixelSize;
 
-    for (int y = 0; y <  dstHeight; y++) {
-        for (int x = 0; x < dstWidth; x++) {
-            qreal maskX = x - centerX;
-            qreal maskY = y - centerY;
-            forwardRotationMatrix.map(maskX, maskY, &maskX, &maskY);
-            distance = norme(maskX * majorAxis, maskY * minorAxis);
+    qreal distance;
+
+    for (int y = rc.y(); y <= rc.bottom(); y++) {
+        for (int x = rc.x(); x <= rc.right(); x++) {
+            qreal maskX = x - data.centerX;
+            qreal maskY = y - data.centerY;
+            data.forwardRotationMatrix.map(maskX, maskY, &maskX, &maskY);
+            distance = norme(maskX * data.majorAxis, maskY * data.minorAxis);
 
             if (distance > 1.0) {
                 // leave there OPACITY TRANSPARENT pixel (default pixel)
 
-                colorPicker.pickOldColor(x + dabX, y + dabY, dabPointer);
+                colorPicker.pickOldColor(x + data.dabX, y + data.dabY, dabPointer);
                 dabPointer += dabPixelSize;
 
                 *maskPointer = OPACITY_TRANSPARENT_U8;
@@ -233,10 +287,10 @@ KisFixedPaintDeviceSP DeformBrush::paintMask(KisFixedPaintDeviceSP dab,
             }
 
             m_deformAction->transform(&maskX, &maskY, distance);
-            reverseRotationMatrix.map(maskX, maskY, &maskX, &maskY);
+            data.reverseRotationMatrix.map(maskX, maskY, &maskX, &maskY);
 
-            maskX += pos.x();
-            maskY += pos.y();
+            maskX += data.pos.x();
+            maskY += data.pos.y();
 
             if (!m_properties->deform_use_bilinear) {
                 maskX = qRound(maskX);
@@ -257,10 +311,6 @@ KisFixedPaintDeviceSP DeformBrush::paintMask(KisFixedPaintDeviceSP dab,
 
         }
     }
-    m_counter++;
-
-    return mask;
-
 }
 
 void DeformBrush::debugColor(const quint8* data, KoColorSpace * cs)
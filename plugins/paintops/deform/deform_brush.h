@@ -28,6 +28,8 @@
 
 #include <time.h>
 
+#include <QTransform>
+
 #if defined(_WIN32) || defined(_WIN64)
 #define srand48 srand
 inline double drand48()
@@ -213,10 +215,40 @@ public:
     void setProperties(DeformOption * properties) {
         m_properties = properties;
     }
+
+    /**
+     * Additional scale of the level of detail the brush paints on. All
+     * the deformations measured in pixels are scaled with it. Should be
+     * set before initDeformAction().
+     */
+    void setLodScale(qreal value) {
+        m_lodScale = value;
+    }
+
     void initDeformAction();
     QPointF hotSpot(qreal scale, qreal rotation);
 
 private:
+    struct MaskProcessingData {
+        KisPaintDeviceSP layer;
+        KisFixedPaintDeviceSP dab;
+        KisFixedPaintDeviceSP mask;
+
+        QPointF pos;
+        int dabX = 0;
+        int dabY = 0;
+
+        qreal centerX = 0.0;
+        qreal centerY = 0.0;
+        qreal majorAxis = 0.0;
+        qreal minorAxis = 0.0;
+
+        QTransform forwardRotationMatrix;
+        QTransform reverseRotationMatrix;
+    };
+
+    void processMaskRows(const QRect &rc, const MaskProcessingData &data);
+
     // return true if can paint
     bool setupAction(
         DeformModes mode, const QPointF& pos, QTransform const& rotation);
@@ -247,6 +279,9 @@ private:
 
     DeformOption * m_properties;
     KisBrushSizeOptionProperties * m_sizeProperties;
+
+    qreal m_lodScale;
+    int m_idealThreadCountCached;
 };
 
 
@@ -117,7 +117,7 @@ void KisDeformOption::writeOptionSetting(KisPropertiesConfigurationSP setting) c
 
 void KisDeformOption::lodLimitations(KisPaintopLodLimitations *l) const
 {
-    l->blockers << KoID("deform-brush", i18nc("PaintOp instant preview limitation", "Deform Brush (unsupported)"));
+    l->limitations << KoID("deform-brush", i18nc("PaintOp instant preview limitation", "Deform Brush (subpixel deformations are not visible on preview)"));
 }
 
 int  KisDeformOption::deformAction() const
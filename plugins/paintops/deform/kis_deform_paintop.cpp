@@ -72,6 +72,7 @@ KisDeformPaintOp::KisDeformPaintOp(const KisPaintOpSettingsSP settings, KisPaint
 
     m_deformBrush.setProperties(&m_properties);
     m_deformBrush.setSizeProperties(&m_sizeProperties);
+    m_deformBrush.setLodScale(KisLodTransform::lodToScale(painter->device()));
 
     m_deformBrush.initDeformAction();
 
@@ -105,10 +106,13 @@ KisSpacingInformation KisDeformPaintOp::paintAt(const KisPaintInformation& info)
     qint32 y;
     qreal subPixelY;
 
+    const qreal lodScale = KisLodTransform::lodToScale(painter()->device());
+
     QPointF pt = info.pos();
     if (m_sizeProperties.brush_jitter_movement_enabled) {
-        pt.setX(pt.x() + ((m_sizeProperties.brush_diameter * drand48()) - m_sizeProperties.brush_diameter * 0.5) * m_sizeProperties.brush_jitter_movement);
-        pt.setY(pt.y() + ((m_sizeProperties.brush_diameter * drand48()) - m_sizeProperties.brush_diameter * 0.5) * m_sizeProperties.brush_jitter_movement);
+        const qreal diameter = m_sizeProperties.brush_diameter * lodScale;
+        pt.setX(pt.x() + ((diameter * drand48()) - diameter * 0.5) * m_sizeProperties.brush_jitter_movement);
+        pt.setY(pt.y() + ((diameter * drand48()) - diameter * 0.5) * m_sizeProperties.brush_jitter_movement);
     }
 
     qreal rotation = m_rotationOption.apply(info);
@@ -116,7 +120,7 @@ KisSpacingInformation KisDeformPaintOp::paintAt(const KisPaintInformation& info)
     // Deform Brush is capable of working with zero scale,
     // so no additional checks for 'zero'ness are needed
     qreal scale = m_sizeOption.apply(info);
-
+    scale *= lodScale;
 
     rotation += m_sizeProperties.brush_rotation;
     scale *= m_sizeProperties.brush_scale;
@@ -148,9 +152,12 @@ KisSpacingInformation KisDeformPaintOp::paintAt(const KisPaintInformation& info)
 
 KisSpacingInformation KisDeformPaintOp::updateSpacingImpl(const KisPaintInformation &info) const
 {
-    return KisPaintOpPluginUtils::effectiveSpacing(1.0, 1.0, true, 0.0, false, m_spacing, false,
+    // m_spacing is measured in pixels, so scale it with the level of detail
+    const qreal lodScale = KisLodTransform::lodToScale(painter()->device());
+
+    return KisPaintOpPluginUtils::effectiveSpacing(lodScale, lodScale, true, 0.0, false, m_spacing, false,
                                                    1.0,
-                                                   KisLodTransform::lodToScale(painter()->device()),
+                                                   lodScale,
                                                    &m_airbrushOption, nullptr, info);
 }
 
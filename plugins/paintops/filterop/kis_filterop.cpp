@@ -47,7 +47,30 @@
 #include <kis_transaction.h>
 #include <kis_lod_transform.h>
 #include <kis_spacing_information.h>
+#include <KisRenderedDab.h>
+#include <kis_algebra_2d.h>
 
+namespace {
+
+/**
+ * The size of the cells the source is filtered in when
+ * the filtered source cache is active
+ */
+const int filteredCellSize = 64;
+
+/**
+ * The cache is used only for point-wise filters and the filters
+ * with a small kernel, otherwise the overhead of the margins
+ * becomes too high
+ */
+const int maxFilteredCacheKernelMargin = 64;
+
+inline qint64 cellKey(int col, int row)
+{
+    return (qint64(row) << 32) | quint32(col);
+}
+
+}
 
 KisFilterOp::KisFilterOp(const KisPaintOpSettingsSP settings, KisPainter *painter, KisNodeSP node, KisImageSP image)
     : KisBrushBasedPaintOp(settings, painter)
@@ -67,6 +90,24 @@ KisFilterOp::KisFilterOp(const KisPaintOpSettingsSP settings, KisPainter *painte
     m_filterConfiguration = static_cast<const KisFilterOpSettings *>(settings.data())->filterConfig();
     m_smudgeMode = settings->getBool(FILTER_SMUDGE_MODE);
 
+    if (m_filter && !m_smudgeMode && m_filter->supportsThreading()) {
+        const int lod = painter->device()->defaultBounds()->currentLevelOfDetail();
+        const QRect probeRect(0, 0, filteredCellSize, filteredCellSize);
+        const QRect neededRect = m_filter->neededRect(probeRect, m_filterConfiguration, lod);
+
+        const int margin = qMax(qMax(probeRect.left() - neededRect.left(),
+                                     neededRect.right() - probeRect.right()),
+                                qMax(probeRect.top() - neededRect.top(),
+                                     neededRect.bottom() - probeRect.bottom()));
+
+        m_useFilteredSourceCache = margin <= maxFilteredCacheKernelMargin;
+    }
+
+    if (m_useFilteredSourceCache) {
+        m_filteredSource = source()->createCompositionSourceDevice();
+        m_filteredSourceSnapshot = source()->createCompositionSourceDevice();
+    }
+
     m_rotationOption.applyFanCornersInfo(this);
 }
 
@@ -117,27 +158,67 @@ KisSpacingInformation KisFilterOp::paintAt(const KisPaintInformation& info)
     Q_ASSERT(dstRect.size() == dabRect.size());
 
 
-    // Filter the paint device
-    QRect neededRect = m_filter->neededRect(dstRect, m_filterConfiguration, painter()->device()->defaultBounds()->currentLevelOfDetail());
+    KisPaintDeviceSP filteredDevice;
+    QPoint filteredOffset;
+
+    if (m_useFilteredSourceCache) {
+        updateFilteredSourceCache(dstRect);
+
+        filteredDevice = m_filteredSource;
+        filteredOffset = dstRect.topLeft();
+    } else {
+        // Filter the paint device
+        QRect neededRect = m_filter->neededRect(dstRect, m_filterConfiguration, painter()->device()->defaultBounds()->currentLevelOfDetail());
 
-    KisPainter p(m_tmpDevice);
-    if (!m_smudgeMode) {
-        p.setCompositeOp(COMPOSITE_COPY);
+        KisPainter p(m_tmpDevice);
+        if (!m_smudgeMode) {
+            p.setCompositeOp(COMPOSITE_COPY);
+        }
+        p.bitBltOldData(neededRect.topLeft() - dstRect.topLeft(), source(), neededRect);
+
+        KisTransaction transaction(m_tmpDevice);
+        m_filter->process(m_tmpDevice, dabRect, m_filterConfiguration, 0);
+        transaction.end();
+
+        filteredDevice = m_tmpDevice;
+        filteredOffset = dabRect.topLeft();
     }
-    p.bitBltOldData(neededRect.topLeft() - dstRect.topLeft(), source(), neededRect);
 
-    KisTransaction transaction(m_tmpDevice);
-    m_filter->process(m_tmpDevice, dabRect, m_filterConfiguration, 0);
-    transaction.end();
+    if (painter()->compositeOp()->id() == COMPOSITE_COPY) {
+        /**
+         * COMPOSITE_COPY uses the mask as a blending factor, so it cannot
+         * be premultiplied into the dab, render it the old way
+         */
+        painter()->bitBltWithFixedSelection(dstRect.x(), dstRect.y(),
+                                            filteredDevice, dab,
+                                            0, 0,
+                                            filteredOffset.x(), filteredOffset.y(),
+                                            dabRect.width(), dabRect.height());
 
-    painter()->bitBltWithFixedSelection(dstRect.x(), dstRect.y(),
-                                        m_tmpDevice, dab,
-                                        0, 0,
-                                        dabRect.x(), dabRect.y(),
-                                        dabRect.width(), dabRect.height());
+        painter()->renderMirrorMaskSafe(dstRect, filteredDevice,
+                                        filteredOffset.x(), filteredOffset.y(), dab,
+                                        !m_dabCache->needSeparateOriginal());
+    } else {
+        /**
+         * The source is read from the old data of the device, so the dabs
+         * do not depend on each other and can be rendered in a batch. The
+         * brush mask is premultiplied into the alpha channel of the
+         * filtered pixels.
+         */
+        KisFixedPaintDeviceSP filteredDab = new KisFixedPaintDevice(filteredDevice->colorSpace());
+        filteredDab->setRect(dabRect);
+        filteredDab->lazyGrowBufferWithoutInitialization();
+        filteredDevice->readBytes(filteredDab->data(), QRect(filteredOffset, dabRect.size()));
+        filteredDevice->colorSpace()->applyAlphaU8Mask(filteredDab->data(), dab->data(),
+                                                       dabRect.width() * dabRect.height());
 
-    painter()->renderMirrorMaskSafe(dstRect, m_tmpDevice, 0, 0, dab,
-                                    !m_dabCache->needSeparateOriginal());
+        KisRenderedDab renderedDab(filteredDab);
+        renderedDab.offset = dstRect.topLeft();
+        renderedDab.opacity = qreal(painter()->opacity()) / 255.0;
+        renderedDab.flow = qreal(painter()->flow()) / 255.0;
+
+        renderDabBatched(renderedDab);
+    }
 
     return effectiveSpacing(scale, rotation, info);
 }
@@ -148,3 +229,49 @@ KisSpacingInformation KisFilterOp::updateSpacingImpl(const KisPaintInformation &
     const qreal rotation = m_rotationOption.apply(info);
     return effectiveSpacing(scale, rotation, info);
 }
+
+void KisFilterOp::updateFilteredSourceCache(const QRect &rc)
+{
+    using KisAlgebra2D::divideFloor;
+
+    const int lod = painter()->device()->defaultBounds()->currentLevelOfDetail();
+
+    const int firstCol = divideFloor(rc.left(), filteredCellSize);
+    const int lastCol = divideFloor(rc.right(), filteredCellSize);
+    const int firstRow = divideFloor(rc.top(), filteredCellSize);
+    const int lastRow = divideFloor(rc.bottom(), filteredCellSize);
+
+    for (int row = firstRow; row <= lastRow; row++) {
+        int col = firstCol;
+
+        while (col <= lastCol) {
+            if (m_filteredCells.contains(cellKey(col, row))) {
+                col++;
+                continue;
+            }
+
+            // filter the whole run of missing cells in one go
+            const int runStart = col;
+            while (col <= lastCol && !m_filteredCells.contains(cellKey(col, row))) {
+                m_filteredCells.insert(cellKey(col, row));
+                col++;
+            }
+
+            const QRect applyRect(runStart * filteredCellSize, row * filteredCellSize,
+                                  (col - runStart) * filteredCellSize, filteredCellSize);
+
+            const QRect neededRect = m_filter->neededRect(applyRect, m_filterConfiguration, lod);
+
+            /**
+             * The source is taken from the old data of the device, that is,
+             * from the state of the device at the start of the stroke, so
+             * the result doesn't depend on the order of the dabs.
+             */
+            KisPainter::copyAreaOptimizedOldData(neededRect.topLeft(), source(),
+                                                 m_filteredSourceSnapshot, neededRect);
+
+            m_filter->process(m_filteredSourceSnapshot, m_filteredSource,
+                              KisSelectionSP(), applyRect, m_filterConfiguration, 0);
+        }
+    }
+}
@@ -23,6 +23,8 @@
 #ifndef KIS_FILTEROP_H_
 #define KIS_FILTEROP_H_
 
+#include <QSet>
+
 #include "kis_brush_based_paintop.h"
 #include <kis_pressure_size_option.h>
 #include <kis_pressure_rotation_option.h>
@@ -46,6 +48,14 @@ protected:
 
     KisSpacingInformation updateSpacingImpl(const KisPaintInformation &info) const override;
 
+private:
+
+    /**
+     * Filter all the cache cells covering \p rc that have not been
+     * filtered yet during the current stroke
+     */
+    void updateFilteredSourceCache(const QRect &rc);
+
 private:
 
     KisPaintDeviceSP m_tmpDevice;
@@ -54,6 +64,17 @@ private:
     KisFilterSP m_filter;
     KisFilterConfigurationSP m_filterConfiguration;
     bool m_smudgeMode;
+
+    /**
+     * For filters that can be applied in patches and need only a small
+     * margin of pixels around the processed rect, the source is filtered
+     * lazily, cell-by-cell, only once per stroke. The dabs just mask
+     * and blend the pixels from this cache.
+     */
+    bool m_useFilteredSourceCache = false;
+    KisPaintDeviceSP m_filteredSource;
+    KisPaintDeviceSP m_filteredSourceSnapshot;
+    QSet<qint64> m_filteredCells;
 };
 
 #endif // KIS_FILTEROP_H_
@@ -64,7 +64,15 @@ KisHairyPaintOp::KisHairyPaintOp(const KisPaintOpSettingsSP settings, KisPainter
         brush->mask(dab, painter->paintColor(), KisDabShape(), fakePaintInformation);
     }
 
-    m_brush.fromDabWithDensity(dab, settings->getDouble(HAIRY_BRISTLE_DENSITY) * 0.01);
+    /**
+     * The dab is generated in full size and gets scaled while painting, so
+     * on a scaled-down level of detail the same bristles would be packed
+     * into a smaller area and the stroke would look denser. Thin out the
+     * bristles instead. The random source is seeded, so the preview uses
+     * a subset of the bristles of the final stroke.
+     */
+    const qreal lodScale = KisLodTransform::lodToScale(painter->device());
+    m_brush.fromDabWithDensity(dab, settings->getDouble(HAIRY_BRISTLE_DENSITY) * 0.01 * lodScale);
     m_brush.setInkColor(painter->paintColor());
 
     loadSettings(static_cast<const KisBrushBasedPaintOpSettings*>(settings.data()));
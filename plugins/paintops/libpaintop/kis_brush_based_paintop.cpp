@@ -22,6 +22,7 @@
 #include <kis_pressure_spacing_option.h>
 #include <kis_pressure_rate_option.h>
 #include "kis_painter.h"
+#include "kis_fixed_paint_device.h"
 #include <kis_lod_transform.h>
 #include "kis_paintop_utils.h"
 #include "kis_paintop_plugin_utils.h"
@@ -31,6 +32,14 @@
 #include <QImage>
 #include <QPainter>
 
+namespace {
+/**
+ * The batch of dabs is flushed earlier when the dabs occupy more
+ * memory than this limit, e.g. for huge brushes with small spacing
+ */
+const qint64 maxDabsBatchBytes = 32 * 1024 * 1024;
+}
+
 #ifdef HAVE_THREADED_TEXT_RENDERING_WORKAROUND
 
 Q_GLOBAL_STATIC(TextBrushInitializationWorkaround, s_instance)
@@ -179,3 +188,37 @@ bool KisBrushBasedPaintOp::canPaint() const
 {
     return m_brush != 0;
 }
+
+void KisBrushBasedPaintOp::paintLine(const KisPaintInformation &pi1,
+                                     const KisPaintInformation &pi2,
+                                     KisDistanceInformation *currentDistance)
+{
+    m_dabsBatchingActive = true;
+    KisPaintOp::paintLine(pi1, pi2, currentDistance);
+    m_dabsBatchingActive = false;
+
+    flushDabsBatch();
+}
+
+void KisBrushBasedPaintOp::renderDabBatched(KisRenderedDab dab)
+{
+    m_dabsBatchAverageOpacity = KisPainter::blendAverageOpacity(dab.opacity, m_dabsBatchAverageOpacity);
+    dab.averageOpacity = m_dabsBatchAverageOpacity;
+
+    m_dabsBatch.append(dab);
+    m_dabsBatchBytes += qint64(dab.device->bounds().width()) * dab.device->bounds().height() * dab.device->pixelSize();
+
+    if (!m_dabsBatchingActive || m_dabsBatchBytes > maxDabsBatchBytes) {
+        flushDabsBatch();
+    }
+}
+
+void KisBrushBasedPaintOp::flushDabsBatch()
+{
+    if (m_dabsBatch.isEmpty()) return;
+
+    painter()->bltFixedWithMirroring(m_dabsBatch);
+
+    m_dabsBatch.clear();
+    m_dabsBatchBytes = 0;
+}
@@ -27,6 +27,7 @@
 #include "kis_airbrush_option_widget.h"
 #include "kis_pressure_mirror_option.h"
 #include <kis_threaded_text_rendering_workaround.h>
+#include <KisRenderedDab.h>
 
 
 class KisPropertiesConfiguration;
@@ -80,11 +81,37 @@ public:
     ///Reimplemented, false if brush is 0
     bool canPaint() const override;
 
+    /**
+     * Reimplemented to render all the dabs, queued with renderDabBatched()
+     * while painting the line, in one pass
+     */
+    void paintLine(const KisPaintInformation &pi1,
+                   const KisPaintInformation &pi2,
+                   KisDistanceInformation *currentDistance) override;
+
 #ifdef HAVE_THREADED_TEXT_RENDERING_WORKAROUND
     typedef int needs_preinitialization;
     static void preinitializeOpStatically(KisPaintOpSettingsSP settings);
 #endif /* HAVE_THREADED_TEXT_RENDERING_WORKAROUND */
 
+protected:
+    /**
+     * Render \p dab on the painter's device. If called from inside
+     * paintLine(), the dab is queued and the whole batch of dabs is rendered
+     * with KisPainter::bltFixedWithMirroring() when the line is finished,
+     * so that every destination tile is touched only once per batch.
+     * Otherwise, the dab is rendered immediately.
+     *
+     * The batch takes the ownership of the dab's device, so it must not
+     * be a device that is reused by the dab cache.
+     */
+    void renderDabBatched(KisRenderedDab dab);
+
+    /**
+     * Render all the dabs queued with renderDabBatched()
+     */
+    void flushDabsBatch();
+
 private:
     KisSpacingInformation effectiveSpacing(qreal dabWidth, qreal dabHeight, qreal extraScale, bool isotropicSpacing, qreal rotation, bool axesFlipped) const;
 
@@ -95,6 +122,11 @@ protected: // XXX: make private!
 private:
     KisTextureProperties m_textureProperties;
 
+    QList<KisRenderedDab> m_dabsBatch;
+    qint64 m_dabsBatchBytes = 0;
+    qreal m_dabsBatchAverageOpacity = 0.0;
+    bool m_dabsBatchingActive = false;
+
 protected:
     KisPressureMirrorOption m_mirrorOption;
     KisPrecisionOption m_precisionOption;
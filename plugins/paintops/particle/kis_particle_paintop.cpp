@@ -53,6 +53,16 @@ KisParticlePaintOp::KisParticlePaintOp(const KisPaintOpSettingsSP settings, KisP
     m_properties.weight = settings->getDouble(PARTICLE_WEIGHT);
     m_properties.scale = QPointF(settings->getDouble(PARTICLE_SCALE_X), settings->getDouble(PARTICLE_SCALE_Y));
 
+    /**
+     * The particle dynamics is linear in the coordinates, so on a
+     * scaled-down level of detail the trails are just scaled copies of
+     * the full-size ones. But every particle still deposits a full pixel,
+     * so the trails would look 1/scale^2 times denser. Compensate that
+     * with the weight to keep the amount of ink per image area.
+     */
+    const qreal lodScale = KisLodTransform::lodToScale(painter->device());
+    m_properties.weight *= pow2(lodScale);
+
     m_particleBrush.setProperties(&m_properties);
     m_particleBrush.initParticles();
 
@@ -135,5 +135,5 @@ void KisParticleOpOption::readOptionSetting(const KisPropertiesConfigurationSP s
 
 void KisParticleOpOption::lodLimitations(KisPaintopLodLimitations *l) const
 {
-    l->blockers << KoID("particle-brush", i18nc("PaintOp instant preview limitation", "Particle Brush (not supported)"));
+    l->limitations << KoID("particle-brush", i18nc("PaintOp instant preview limitation", "Particle Brush (particle trails are thinner than on preview)"));
 }
@@ -157,7 +157,15 @@ void KisSketchPaintOp::doPaintLine(const KisPaintInformation &pi1, const KisPain
     const qreal scale = lodAdditionalScale * m_sizeOption.apply(pi2);
     if ((scale * m_brush->width()) <= 0.01 || (scale * m_brush->height()) <= 0.01) return;
 
-    const qreal currentLineWidth = qMax(0.9, lodAdditionalScale * m_lineWidthOption.apply(pi2, m_sketchProperties.lineWidth));
+    const qreal lineWidth = m_lineWidthOption.apply(pi2, m_sketchProperties.lineWidth);
+    const qreal currentLineWidth = qMax(0.9, lodAdditionalScale * lineWidth);
+
+    /**
+     * On a scaled-down level of detail the lines are clamped to the
+     * minimal width, which makes them look bolder than in the final
+     * stroke. Compensate that with the opacity of the whole dab.
+     */
+    const qreal lineCoverage = lodAdditionalScale * qMax(0.9, lineWidth) / currentLineWidth;
 
     const qreal currentOffsetScale = m_offsetScaleOption.apply(pi2, m_sketchProperties.offset);
     const double rotation = m_rotationOption.apply(pi2);
@@ -299,6 +307,10 @@ void KisSketchPaintOp::doPaintLine(const KisPaintInformation &pi1, const KisPain
     QRect rc = m_dab->extent();
     quint8 origOpacity = m_opacityOption.apply(painter(), pi2);
 
+    if (lineCoverage < 1.0) {
+        painter()->setOpacity(qRound(painter()->opacity() * lineCoverage));
+    }
+
     painter()->bitBlt(rc.x(), rc.y(), m_dab, rc.x(), rc.y(), rc.width(), rc.height());
     painter()->renderMirrorMask(rc, m_dab);
     painter()->setOpacity(origOpacity);
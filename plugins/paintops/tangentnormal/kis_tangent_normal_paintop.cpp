@@ -32,6 +32,7 @@
 #include <kis_image.h>
 #include <kis_lod_transform.h>
 #include <kis_paintop_plugin_utils.h>
+#include <KisRenderedDab.h>
 
 
 KisTangentNormalPaintOp::KisTangentNormalPaintOp(const KisPaintOpSettingsSP settings, KisPainter* painter, KisNodeSP node, KisImageSP image):
@@ -152,21 +153,23 @@ KisSpacingInformation KisTangentNormalPaintOp::paintAt(const KisPaintInformation
     Q_ASSERT(m_dstDabRect.size() == dabRect.size());
     Q_UNUSED(dabRect);
 
-    quint8  oldOpacity = painter()->opacity();
-    QString oldCompositeOpId = painter()->compositeOp()->id();
+    m_opacityOption.setFlow(m_flowOption.apply(info));
 
+    quint8 dabOpacity = OPACITY_OPAQUE_U8;
+    quint8 dabFlow = OPACITY_OPAQUE_U8;
 
-    m_opacityOption.setFlow(m_flowOption.apply(info));
-    m_opacityOption.apply(painter(), info);
-    //paint with the default color? Copied this from color smudge.//
-    //painter()->setCompositeOp(COMPOSITE_COPY);
-    //painter()->fill(0, 0, m_dstDabRect.width(), m_dstDabRect.height(), color);
-    painter()->bltFixed(m_dstDabRect.topLeft(), m_maskDab, m_maskDab->bounds());
-    painter()->renderMirrorMaskSafe(m_dstDabRect, m_maskDab, !m_dabCache->needSeparateOriginal());
+    m_opacityOption.apply(info, &dabOpacity, &dabFlow);
+
+    /**
+     * The dab cache reuses its device for the next dab, so we should
+     * pass a copy of it to the batch
+     */
+    KisRenderedDab dab(new KisFixedPaintDevice(*m_maskDab));
+    dab.offset = m_dstDabRect.topLeft();
+    dab.opacity = qreal(dabOpacity) / 255.0;
+    dab.flow = qreal(dabFlow) / 255.0;
 
-    // restore original opacity and composite mode values
-    painter()->setOpacity(oldOpacity);
-    painter()->setCompositeOp(oldCompositeOpId);
+    renderDabBatched(dab);
 
     return computeSpacing(info, scale, rotation);
 }
@@ -248,6 +251,6 @@ void KisTangentNormalPaintOp::paintLine(const KisPaintInformation& pi1, const Ki
         painter()->renderMirrorMask(rc, m_lineCacheDevice);
     }
     else {
-        KisPaintOp::paintLine(pi1, pi2, currentDistance);
+        KisBrushBasedPaintOp::paintLine(pi1, pi2, currentDistance);
     }
 }